@@ -16,28 +16,224 @@
 extern "C" {
 #endif
 
-void read_dsres(const char *filename, const int ndatasets, const char **dataset_names, const char **dataset_units, const char *scale_unit, int nsamples, double *data);
+void *open_dsres(const char *filename, int *size);
 
-void get_time_series_size_dsres(const char *filename, const char **dataset_names, int *size);
+void read_dsres(void *dsres, const char *filename, const int ndatasets, const char **dataset_names, const char **dataset_units, const char *scale_unit, int start, int nsamples, int stride, double *data);
 
-//extern char *error_message;
+int read_dsres_time(void *dsres, int index, double *time);
 
-#define MAX_MESSAGE_LENGTH 4096
+void close_dsres(void *dsres);
+
+void get_dsres_aliases(void *dsres, const char *filename, const int ndatasets, const char **dataset_names, int *aliases, int *nvariables, int *ncolumns);
 
-extern char error_message[MAX_MESSAGE_LENGTH];
+#define MAX_MESSAGE_LENGTH 4096
 
+/* Sets the error message of the calling thread that is returned by the ModelicaSDF_* functions */
 void set_error_message(const char *msg, ...);
 
 
+/*! Closes all files that are kept open for reading or appending
+ *
+ * The functions that read from a file keep up to eight files open and reopen a file
+ * when its modification time or size changes. ModelicaSDF_append_rows() keeps the
+ * file it writes open. Call this function to release the handles, e.g. before the
+ * files are modified or read by another application.
+ */
+MODELICA_SDF_API void ModelicaSDF_close_files();
+
+/*! A table or time series whose metadata has been resolved */
+typedef struct ModelicaSDF_Handle ModelicaSDF_Handle;
+
+/*! Opens a table and resolves its dimensions and scales
+ *
+ * @param [in]	filename		the file name
+ * @param [in]	dataset_name	the dataset name
+ * @param [out]	handle			the handle to pass to ModelicaSDF_fill_table()
+ * @param [out]	size			the size of the table data vector
+ *
+ * @return		the error message ("" on success)
+ */
+MODELICA_SDF_API const char * ModelicaSDF_open_table(const char *filename, const char *dataset_name, ModelicaSDF_Handle **handle, int *size);
+
+/*! Reads the table data vector of an open table
+ *
+ * @param [in]	handle			the handle returned by ModelicaSDF_open_table()
+ * @param [in]	ndims			the expected number of dimensions
+ * @param [in]	unit			the expected unit
+ * @param [in]	scale_units		the expected units of the scales
+ * @param [out]	data			a buffer for the table data vector
+ *
+ * @return		the error message ("" on success)
+ */
+MODELICA_SDF_API const char * ModelicaSDF_fill_table(ModelicaSDF_Handle *handle, const int ndims, const char *unit, const char **scale_units, double *data);
+
+/*! Opens a time series and resolves its scale
+ *
+ * @param [in]	filename		the file name
+ * @param [in]	dataset_names	the dataset names (only the first one is used)
+ * @param [out]	handle			the handle to pass to ModelicaSDF_fill_time_series()
+ * @param [out]	size			the number of samples
+ *
+ * @return		the error message ("" on success)
+ */
+MODELICA_SDF_API const char * ModelicaSDF_open_time_series(const char *filename, const char **dataset_names, ModelicaSDF_Handle **handle, int *size);
+
+/*! Reads the samples of an open time series
+ *
+ * @param [in]	handle			the handle returned by ModelicaSDF_open_time_series()
+ * @param [in]	ndatasets		the number of datasets
+ * @param [in]	dataset_names	the dataset names
+ * @param [in]	dataset_units	the expected units of the datasets
+ * @param [in]	scale_unit		the expected unit of the scale
+ * @param [in]	nsamples		the number of samples
+ * @param [out]	data			a buffer for the samples (nsamples x (ndatasets + 1))
+ *
+ * @return		the error message ("" on success)
+ */
+MODELICA_SDF_API const char * ModelicaSDF_fill_time_series(ModelicaSDF_Handle *handle, const int ndatasets, const char **dataset_names, const char **dataset_units, const char *scale_unit, int nsamples, double *data);
+
+/*! Closes a handle returned by ModelicaSDF_open_table() or ModelicaSDF_open_time_series()
+ *
+ * @param [in]	handle			the handle
+ */
+MODELICA_SDF_API void ModelicaSDF_close_handle(ModelicaSDF_Handle *handle);
+
 MODELICA_SDF_API const char * ModelicaSDF_get_table_data_size(const char *filename, const char *dataset_name, int *size);
 
+/*! Gets the size of the table data vector of a dataset
+ *
+ * Works like ModelicaSDF_get_table_data_size() but the size may exceed INT_MAX, so it can be
+ * used for datasets with more than 2^31 elements (ModelicaSDF_get_table_data_size() returns an error).
+ *
+ * @param [in]	filename		the file name
+ * @param [in]	dataset_name	the dataset name
+ * @param [out]	size			the size of the table data vector
+ *
+ * @return		the error message ("" on success)
+ */
+MODELICA_SDF_API const char * ModelicaSDF_get_table_data_size64(const char *filename, const char *dataset_name, long long *size);
+
 MODELICA_SDF_API const char * ModelicaSDF_read_table_data(const char *filename, const char *dataset_name, const int ndims, const char *unit, const char **scale_units, double *data);
 
 
+/*! Reads the table data of a dataset into the shared table cache
+ *
+ * Tables with the same file name, dataset name, units and file modification time are read only
+ * once and shared between all callers. The returned data must not be modified and must be
+ * released with ModelicaSDF_release_table_data().
+ *
+ * @param [in]	filename		the file name
+ * @param [in]	dataset_name	the dataset name
+ * @param [in]	ndims			the number of dimensions
+ * @param [in]	unit			the expected unit
+ * @param [in]	scale_units		the expected units of the scales
+ * @param [out]	data			the table data in the format of ModelicaSDF_read_table_data()
+ * @param [out]	size			the number of elements in data
+ *
+ * @return		the error message ("" on success)
+ */
+MODELICA_SDF_API const char * ModelicaSDF_acquire_table_data(const char *filename, const char *dataset_name, const int ndims, const char *unit, const char **scale_units, const double **data, int *size);
+
+/*! Reads the dimensions and scales of a table into the shared table cache and maps or reads its values
+ *
+ * Works like ModelicaSDF_acquire_table_data() but returns the values separately. The values of
+ * large datasets that are stored contiguously and uncompressed as little-endian doubles (the layout
+ * of ModelicaSDF_make_dataset_double()) are mapped from the file, so they are read on demand and shared
+ * with other processes through the page cache. While values are mapped from a file, the functions of
+ * this library refuse to write it. Rewriting the file from another process is not supported (the values
+ * may change or reading them may raise SIGBUS).
+ *
+ * If single is 1 or the dataset is stored in single precision (the layout of ModelicaSDF_make_dataset_float())
+ * the values are returned as floats, which halves the memory and bandwidth of large tables.
+ *
+ * @param [in]	filename		the file name
+ * @param [in]	dataset_name	the dataset name
+ * @param [in]	ndims			the number of dimensions
+ * @param [in]	unit			the expected unit
+ * @param [in]	scale_units		the expected units of the scales
+ * @param [in,out]	single		1 to request the values in single precision, set to 1 if the values are floats and 0 if they are doubles
+ * @param [out]	data			the number of dimensions, the dimensions and the scales (followed by the values if they are doubles and not mapped)
+ * @param [out]	size			the number of elements in data (may exceed INT_MAX)
+ * @param [out]	values			the table values (doubles or floats depending on single)
+ *
+ * @return		the error message ("" on success)
+ */
+MODELICA_SDF_API const char * ModelicaSDF_acquire_table(const char *filename, const char *dataset_name, const int ndims, const char *unit, const char **scale_units, int *single, const double **data, long long *size, const void **values);
+
+/*! Releases table data returned by ModelicaSDF_acquire_table_data() or ModelicaSDF_acquire_table()
+ *
+ * The data is freed (and the values are unmapped) when the last reference is released.
+ *
+ * @param [in]	data			the table data
+ */
+MODELICA_SDF_API void ModelicaSDF_release_table_data(const double *data);
+
+/*! Gets the statistics of the shared table cache
+ *
+ * @param [out]	entries			the number of tables in the cache
+ * @param [out]	hits			the number of requests that were served from the cache
+ * @param [out]	misses			the number of requests that read the table from the file
+ * @param [out]	bytes_cached	the size of the tables in the cache (in bytes)
+ * @param [out]	bytes_saved		the size of the tables that were served from the cache (in bytes)
+ */
+MODELICA_SDF_API void ModelicaSDF_get_table_cache_statistics(int *entries, int *hits, int *misses, double *bytes_cached, double *bytes_saved);
+
 MODELICA_SDF_API const char * ModelicaSDF_get_time_series_size(const char *filename, const char **dataset_names, int *size);
 
 MODELICA_SDF_API const char * ModelicaSDF_read_time_series(const char *filename, const int ndatasets, const char **dataset_names, const char **dataset_units, const char *scale_unit, int nsamples, double *data);
 
+/*! Gets the window of samples of a time series that covers a time range
+ *
+ * The window starts at the last sample <= start_time and ends at the first sample >= stop_time
+ * (or the first and last sample of the time series).
+ *
+ * @param [in]	filename		the file name
+ * @param [in]	dataset_names	the dataset names (only the first one is used)
+ * @param [in]	start_time		the start of the time range
+ * @param [in]	stop_time		the end of the time range
+ * @param [in]	stride			read every stride-th sample
+ * @param [out]	start			the index of the first sample
+ * @param [out]	count			the number of samples
+ *
+ * @return		the error message ("" on success)
+ */
+MODELICA_SDF_API const char * ModelicaSDF_get_time_series_window(const char *filename, const char **dataset_names, double start_time, double stop_time, int stride, int *start, int *count);
+
+/*! Reads a window of samples of a time series
+ *
+ * Only the samples start, start + stride,... are read from the file.
+ *
+ * @param [in]	filename		the file name
+ * @param [in]	ndatasets		the number of datasets
+ * @param [in]	dataset_names	the dataset names
+ * @param [in]	dataset_units	the expected units of the datasets
+ * @param [in]	scale_unit		the expected unit of the scale
+ * @param [in]	start			the index of the first sample
+ * @param [in]	count			the number of samples
+ * @param [in]	stride			the distance between the samples
+ * @param [out]	data			a buffer for the samples (count x (ndatasets + 1))
+ *
+ * @return		the error message ("" on success)
+ */
+MODELICA_SDF_API const char * ModelicaSDF_read_time_series_window(const char *filename, const int ndatasets, const char **dataset_names, const char **dataset_units, const char *scale_unit, int start, int count, int stride, double *data);
+
+
+/*! Gets the aliases of variables in a Dymola result file
+ *
+ * Variables that are stored in the same column of the result file are aliases of each other
+ * (possibly negated) and have to be read only once.
+ *
+ * @param [in]	filename		the file name
+ * @param [in]	ndatasets		the number of variables
+ * @param [in]	dataset_names	the names of the variables
+ * @param [out]	aliases			for each variable the (1-based) index of the first variable in dataset_names
+ *								that is stored in the same column (negative if the values are negated)
+ * @param [out]	nvariables		the number of variables in the file
+ * @param [out]	ncolumns		the number of distinct columns in the file (i.e. variables without aliases)
+ *
+ * @return		the error message ("" on success)
+ */
+MODELICA_SDF_API const char * ModelicaSDF_get_alias_statistics(const char *filename, const int ndatasets, const char **dataset_names, int *aliases, int *nvariables, int *ncolumns);
 
 MODELICA_SDF_API const char * ModelicaSDF_create_group(const char *filename, const char *group_name, const char *comment);
 
@@ -51,6 +247,16 @@ MODELICA_SDF_API const char * ModelicaSDF_create_group(const char *filename, con
  */
 MODELICA_SDF_API const char * ModelicaSDF_get_dataset_dims(const char *filename, const char *dataset_name, int dims[]);
 
+/*! Retrieves the dimensions of a dataset with extents that may exceed INT_MAX
+ * 
+ * @param [in]	filename		the file name
+ * @param [in]	dataset_name	the dataset name
+ * @param [out]	dims			a long long[32] for the dimensions
+ *
+ * @return		the error message ("" on success)
+ */
+MODELICA_SDF_API const char * ModelicaSDF_get_dataset_dims64(const char *filename, const char *dataset_name, long long dims[]);
+
 /*! Reads the values of a double dataset
  * 
  * @param [in]	filename		the file name
@@ -99,6 +305,34 @@ MODELICA_SDF_API const char * ModelicaSDF_make_dataset_double(
 	const char *display_unit, 
 	int relative_quantity);
 
+/*! Writes a single precision dataset with unit and comment
+ *
+ * The values are converted to floats and stored as little-endian IEEE 754 single precision numbers.
+ * 
+ * @param [in]	filename			the file name
+ * @param [in]	dataset_name		the dataset name
+ * @param [in]	ndims				the number of dimensions
+ * @param [in]	dims				the dimensions
+ * @param [in]	data				a buffer for the values
+ * @param [in]	relative_quantity	absolute if 0, otherwise relative
+ * @param [in]	unit				the unit (optional)
+ * @param [in]	display_unit		the display unit (optional)
+ * @param [in]	comment				the comment (optional)
+ *
+ * @return		the error message ("" on success)
+ */
+MODELICA_SDF_API const char * ModelicaSDF_make_dataset_float(
+	const char *filename, 
+	const char *dataset_name, 
+	int ndims, 
+	const int dims[], 
+	const double *data, 
+	const char *comment, 
+	const char *display_name, 
+	const char *unit, 
+	const char *display_unit, 
+	int relative_quantity);
+
 /*! Writes an integer dataset with unit and comment
  * 
  * @param [in]	filename			the file name
@@ -125,6 +359,143 @@ MODELICA_SDF_API const char *  ModelicaSDF_make_dataset_int(
 	const char *display_unit,
 	int relative_quantity);
 
+/*! Appends rows to a time series
+ *
+ * The scale and the datasets are created as one-dimensional datasets with unlimited size
+ * (if they don't exist) and the scale is attached to the datasets. Datasets that are added
+ * later are filled with NaN up to the current size of the scale. The file is kept open until
+ * it is written by another function or ModelicaSDF_close_files() is called.
+ *
+ * @param [in]	filename		the file name
+ * @param [in]	scale_name		the name of the scale
+ * @param [in]	scale_unit		the unit of the scale (optional)
+ * @param [in]	ndatasets		the number of datasets
+ * @param [in]	dataset_names	the dataset names
+ * @param [in]	dataset_units	the units of the datasets (optional)
+ * @param [in]	nrows			the number of rows
+ * @param [in]	data			the rows (nrows x (ndatasets + 1), the first column is the scale)
+ *
+ * @return		the error message ("" on success)
+ */
+MODELICA_SDF_API const char * ModelicaSDF_append_rows(const char *filename, const char *scale_name, const char *scale_unit, const int ndatasets, const char **dataset_names, const char **dataset_units, int nrows, const double *data);
+
+/*! A writer that appends rows to a time series in a background thread */
+typedef struct ModelicaSDF_Writer ModelicaSDF_Writer;
+
+/*! Opens a buffered writer for a time series
+ *
+ * The rows are copied to a ring buffer and appended by a worker thread (see ModelicaSDF_append_rows())
+ * when the buffer is half full, when the flush interval has elapsed and when the writer is flushed or
+ * closed. When the buffer is full ModelicaSDF_write_row() waits for the worker.
+ *
+ * @param [in]	filename		the file name
+ * @param [in]	scale_name		the name of the scale
+ * @param [in]	scale_unit		the unit of the scale (optional)
+ * @param [in]	ndatasets		the number of datasets
+ * @param [in]	dataset_names	the dataset names
+ * @param [in]	dataset_units	the units of the datasets (optional)
+ * @param [in]	capacity		the number of rows in the buffer (rounded up to a power of 2)
+ * @param [in]	flush_interval	the time after which the buffered rows are written and the file is flushed (in seconds)
+ * @param [out]	writer			the writer
+ *
+ * @return		the error message ("" on success)
+ */
+MODELICA_SDF_API const char * ModelicaSDF_open_writer(const char *filename, const char *scale_name, const char *scale_unit, const int ndatasets, const char **dataset_names, const char **dataset_units, int capacity, double flush_interval, ModelicaSDF_Writer **writer);
+
+/*! Writes a row to the buffer of a writer
+ *
+ * @param [in]	writer			the writer
+ * @param [in]	row				the row (the scale followed by the datasets)
+ * @param [in]	ncols			the number of values in the row (ndatasets + 1)
+ *
+ * @return		the error message ("" on success or the error of a previous append)
+ */
+MODELICA_SDF_API const char * ModelicaSDF_write_row(ModelicaSDF_Writer *writer, const double *row, int ncols);
+
+/*! Appends the buffered rows of a writer and flushes the file
+ *
+ * @param [in]	writer			the writer
+ *
+ * @return		the error message ("" on success)
+ */
+MODELICA_SDF_API const char * ModelicaSDF_flush_writer(ModelicaSDF_Writer *writer);
+
+/*! Appends the buffered rows, stops the worker thread and frees the writer
+ *
+ * @param [in]	writer			the writer (may be NULL)
+ *
+ * @return		the error message ("" on success)
+ */
+MODELICA_SDF_API const char * ModelicaSDF_close_writer(ModelicaSDF_Writer *writer);
+
+/*! Writes a chunked and compressed double dataset with unit and comment
+ *
+ * @param [in]	filename			the file name
+ * @param [in]	dataset_name		the dataset name
+ * @param [in]	ndims				the number of dimensions (> 0)
+ * @param [in]	dims				the dimensions
+ * @param [in]	data				a buffer for the values
+ * @param [in]	comment				the comment (optional)
+ * @param [in]	display_name		the display name (optional)
+ * @param [in]	unit				the unit (optional)
+ * @param [in]	display_unit		the display unit (optional)
+ * @param [in]	relative_quantity	absolute if 0, otherwise relative
+ * @param [in]	chunk_dims			the dimensions of the chunks (NULL or {0,...} to choose chunks of about 1 MB)
+ * @param [in]	deflate_level		the deflate (gzip) level (0: no compression, 1...9)
+ * @param [in]	shuffle				shuffle the bytes before compressing if != 0
+ *
+ * @return		the error message ("" on success)
+ */
+MODELICA_SDF_API const char * ModelicaSDF_make_chunked_dataset_double(
+	const char *filename,
+	const char *dataset_name,
+	int ndims,
+	const int dims[],
+	const double *data,
+	const char *comment,
+	const char *display_name,
+	const char *unit,
+	const char *display_unit,
+	int relative_quantity,
+	const int chunk_dims[],
+	int deflate_level,
+	int shuffle);
+
+/*! Writes a chunked and compressed integer dataset with unit and comment
+ *
+ * @param [in]	filename			the file name
+ * @param [in]	dataset_name		the dataset name
+ * @param [in]	ndims				the number of dimensions (> 0)
+ * @param [in]	dims				the dimensions
+ * @param [in]	data				a buffer for the values
+ * @param [in]	comment				the comment (optional)
+ * @param [in]	display_name		the display name (optional)
+ * @param [in]	unit				the unit (optional)
+ * @param [in]	display_unit		the display unit (optional)
+ * @param [in]	relative_quantity	absolute if 0, otherwise relative
+ * @param [in]	chunk_dims			the dimensions of the chunks (NULL or {0,...} to choose chunks of about 1 MB)
+ * @param [in]	deflate_level		the deflate (gzip) level (0: no compression, 1...9)
+ * @param [in]	shuffle				shuffle the bytes before compressing if != 0
+ * @param [in]	scale_offset		store only the bits needed for the range of each chunk if != 0 (lossless)
+ *
+ * @return		the error message ("" on success)
+ */
+MODELICA_SDF_API const char * ModelicaSDF_make_chunked_dataset_int(
+	const char *filename,
+	const char *dataset_name,
+	int ndims,
+	const int dims[],
+	const int *data,
+	const char *comment,
+	const char *display_name,
+	const char *unit,
+	const char *display_unit,
+	int relative_quantity,
+	const int chunk_dims[],
+	int deflate_level,
+	int shuffle,
+	int scale_offset);
+
 /*! Sets a dataset as the scale for the dimension of another dataset
  * 
  * @param [in]	filename		the file name
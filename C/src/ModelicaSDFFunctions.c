@@ -1,7 +1,20 @@
 #include <stdlib.h>
 #include <stdarg.h>
+#include <limits.h>
+#include <stdint.h>
 #include <math.h>
 #include <string.h>
+#include <time.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
 
 #include "hdf5.h"
 #include "hdf5_hl.h"
@@ -17,8 +30,95 @@
 
 #define MAX_MESSAGE_LENGTH 4096
 
+#define FILE_POOL_SIZE 8
+
+// the size of the chunks if the chunk dimensions are not given (in bytes)
+#define CHUNK_SIZE (1024 * 1024)
+
+// the number of samples in a chunk of an appendable dataset
+#define APPEND_CHUNK_SIZE 1024
+
+// the number of values of a time series that are read before they are interleaved
+#define READ_BATCH_SIZE (1 << 16)
+
+// the minimum size of the values of a shared table that are mapped from the file instead of read (in bytes)
+#define MAP_THRESHOLD (1024 * 1024)
+
+// the file information including the size of files > 2 GB
+#ifdef _WIN32
+typedef struct _stat64 file_stat_t;
+#define get_file_stat(filename, info) _stat64(filename, info)
+#else
+typedef struct stat file_stat_t;
+#define get_file_stat(filename, info) stat(filename, info)
+#endif
+
+// the error message is kept per thread, so the library can be used by concurrent simulations
+#if defined(_MSC_VER)
+#define THREAD_LOCAL __declspec(thread)
+#elif defined(__GNUC__)
+#define THREAD_LOCAL __thread
+#elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+#define THREAD_LOCAL _Thread_local
+#else
+#define THREAD_LOCAL
+#endif
+
+static THREAD_LOCAL char error_message[MAX_MESSAGE_LENGTH];
+
+// HDF5 is not thread-safe, so the functions that use it (or the state of the open files) hold this lock
+#ifdef _WIN32
+static SRWLOCK hdf5_lock = SRWLOCK_INIT;
+#else
+static pthread_mutex_t hdf5_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+// the number of times the calling thread has acquired the lock (functions call each other)
+static THREAD_LOCAL int hdf5_lock_depth = 0;
+
+#define LOCK_HDF5()   lock_hdf5()
+#define UNLOCK_HDF5() unlock_hdf5()
+
+static void lock_hdf5() {
+	if (hdf5_lock_depth++ == 0) {
+#ifdef _WIN32
+		AcquireSRWLockExclusive(&hdf5_lock);
+#else
+		pthread_mutex_lock(&hdf5_lock);
+#endif
+	}
+}
+
+static void unlock_hdf5() {
+	if (--hdf5_lock_depth == 0) {
+#ifdef _WIN32
+		ReleaseSRWLockExclusive(&hdf5_lock);
+#else
+		pthread_mutex_unlock(&hdf5_lock);
+#endif
+	}
+}
+
+// releases the lock while the calling thread doesn't use HDF5 and returns the depth to pass to resume_hdf5()
+static int suspend_hdf5() {
+
+	const int depth = hdf5_lock_depth;
+
+	if (depth > 0) {
+		hdf5_lock_depth = 1;
+		unlock_hdf5();
+	}
+
+	return depth;
+}
+
+static void resume_hdf5(int depth) {
 
-char error_message[MAX_MESSAGE_LENGTH];
+	if (depth > 0) {
+		lock_hdf5();
+		hdf5_lock_depth = depth;
+	}
+}
 
 static void configureMessageHandling() {
 //#ifndef _DEBUG
@@ -34,6 +134,212 @@ void set_error_message(const char *msg, ...) {
 	va_end(vargs);
 }
 
+/* A file that is kept open for reading */
+typedef struct {
+	char *filename;			//!< the file name (NULL if the slot is empty)
+	hid_t file_id;			//!< the file handle
+	time_t mtime;			//!< the modification time of the file when it was opened
+	long long size;			//!< the size of the file when it was opened
+	unsigned long used;		//!< the value of file_pool_clock when the file was last used
+} PooledFile;
+
+static PooledFile file_pool[FILE_POOL_SIZE];
+
+/* A file that table values are mapped from (guarded by the HDF5 lock, so writers can check it) */
+typedef struct MappedFile {
+	char *filename;				//!< the file name
+	int count;					//!< the number of live mappings
+	struct MappedFile *next;	//!< the next file in the list
+} MappedFile;
+
+static MappedFile *mapped_files = NULL;
+
+/* A table or time series whose metadata has been resolved */
+struct ModelicaSDF_Handle {
+	char *filename;				//!< the file name
+	char *dataset_name;			//!< the dataset name (the first dataset of a time series)
+	int time_series;			//!< 1 for a time series, 0 for a table
+	time_t mtime;				//!< the modification time of the file when it was opened
+	long long size;				//!< the size of the file when it was opened
+	hid_t file_id;				//!< the file handle (HDF5 files)
+	void *dsres;				//!< the open result file (MAT files)
+	int rank;					//!< the number of dimensions
+	hsize_t dims[32];			//!< the extent of the dimensions
+	int single;					//!< 1 if the values are stored in single precision
+	char *scale_names[32];		//!< the names of the scales (NULL if the dimension has no scale)
+};
+
+/* The handle opened by the last size query that is used by the following read */
+static ModelicaSDF_Handle *pending_handle = NULL;
+
+/* The file that is kept open for appending rows */
+static char *append_filename = NULL;
+static hid_t append_file_id = H5I_INVALID_HID;
+
+/* The datasets of the append file that are kept open (so the chunk cache is kept, too) */
+typedef struct {
+	char *name;				//!< the dataset name
+	hid_t dset_id;			//!< the dataset handle
+} AppendDataset;
+
+static AppendDataset *append_datasets = NULL;
+static int n_append_datasets = 0;
+static int append_dataset_hint = 0;
+
+static unsigned long file_pool_clock = 0;
+
+static void close_append_file() {
+
+	int i;
+
+	if (!append_filename) return;
+
+	for (i = 0; i < n_append_datasets; i++) {
+		H5Dclose(append_datasets[i].dset_id);
+		free(append_datasets[i].name);
+	}
+
+	free(append_datasets);
+	append_datasets = NULL;
+	n_append_datasets = 0;
+
+	H5Fclose(append_file_id);
+	free(append_filename);
+
+	append_filename = NULL;
+	append_file_id = H5I_INVALID_HID;
+}
+
+static void close_pooled_file(PooledFile *file) {
+
+	if (!file->filename) return;
+
+	H5Fclose(file->file_id);
+	free(file->filename);
+
+	file->filename = NULL;
+	file->file_id = H5I_INVALID_HID;
+}
+
+/* Closes the pooled handle of a file before it is opened for writing
+ *
+ * Returns -1 and sets the error message if table values are mapped from the file, because
+ * HDF5 may reuse or truncate their space, which would change the values or raise SIGBUS.
+ */
+static int evict_file(const char *filename) {
+
+	MappedFile *mapped;
+	int i;
+
+	for (mapped = mapped_files; mapped; mapped = mapped->next) {
+		if (strcmp(mapped->filename, filename) == 0) {
+			set_error_message("Failed to open '%s' for writing because tables are mapped from it", filename);
+			return -1;
+		}
+	}
+
+	if (pending_handle && strcmp(pending_handle->filename, filename) == 0) {
+		ModelicaSDF_close_handle(pending_handle);
+		pending_handle = NULL;
+	}
+
+	if (append_filename && strcmp(append_filename, filename) == 0) {
+		close_append_file();
+	}
+
+	for (i = 0; i < FILE_POOL_SIZE; i++) {
+		if (file_pool[i].filename && strcmp(file_pool[i].filename, filename) == 0) {
+			close_pooled_file(&file_pool[i]);
+		}
+	}
+
+	return 0;
+}
+
+/* Opens a file for reading
+ *
+ * The file is kept open in the file pool and reopened if its modification time or size
+ * has changed. The returned handle must be closed with H5Fclose().
+ */
+static hid_t open_file(const char *filename) {
+
+	file_stat_t file_info;
+	PooledFile *file = NULL;
+	hid_t file_id;
+	int i;
+
+	if (get_file_stat(filename, &file_info) != 0) {
+		return H5I_INVALID_HID;
+	}
+
+	for (i = 0; i < FILE_POOL_SIZE; i++) {
+		if (file_pool[i].filename && strcmp(file_pool[i].filename, filename) == 0) {
+			file = &file_pool[i];
+			break;
+		}
+	}
+
+	if (file && (file->mtime != file_info.st_mtime || file->size != (long long)file_info.st_size)) {
+		close_pooled_file(file);
+	}
+
+	if (!file || !file->filename) {
+
+		if ((file_id = H5Fopen(filename, H5F_ACC_RDONLY, H5P_DEFAULT)) < 0) {
+			return H5I_INVALID_HID;
+		}
+
+		// use an empty slot or the least recently used one
+		if (!file) {
+			file = &file_pool[0];
+			for (i = 0; i < FILE_POOL_SIZE; i++) {
+				if (!file_pool[i].filename) {
+					file = &file_pool[i];
+					break;
+				}
+				if (file_pool[i].used < file->used) {
+					file = &file_pool[i];
+				}
+			}
+			close_pooled_file(file);
+		}
+
+		if (!(file->filename = (char *)malloc(strlen(filename) + 1))) {
+			return file_id;
+		}
+
+		strcpy(file->filename, filename);
+		file->file_id = file_id;
+		file->mtime = file_info.st_mtime;
+		file->size = (long long)file_info.st_size;
+	}
+
+	file->used = ++file_pool_clock;
+
+	// one reference for the pool and one for the caller
+	H5Iinc_ref(file->file_id);
+
+	return file->file_id;
+}
+
+void ModelicaSDF_close_files() {
+
+	int i;
+
+	LOCK_HDF5();
+
+	ModelicaSDF_close_handle(pending_handle);
+	pending_handle = NULL;
+
+	close_append_file();
+
+	for (i = 0; i < FILE_POOL_SIZE; i++) {
+		close_pooled_file(&file_pool[i]);
+	}
+
+	UNLOCK_HDF5();
+}
+
 static herr_t delete_dataset(hid_t loc_id, const char *dataset_name) {
 	
 	int rank;
@@ -53,6 +359,10 @@ static hid_t open_or_create_file(const char *filename) {
 
 	hid_t file_id = -1;
 
+	if (evict_file(filename) < 0) {
+		return -1;
+	}
+
 	// open the file
 	if ((file_id = H5Fopen(filename, H5F_ACC_RDWR, H5P_DEFAULT)) < 0) {
 		
@@ -171,6 +481,7 @@ out:
 	return scale_name;
 }
 
+// checks the rank, the number of elements and the unit of a dataset
 static int check_dataset_1d(hid_t file_id, const char *dataset_name, const char *unit, hsize_t numel) {
 
 	H5T_class_t type_class = H5T_NO_CLASS;
@@ -206,6 +517,40 @@ static int check_dataset_1d(hid_t file_id, const char *dataset_name, const char
 	return 0;
 }
 
+// reads the samples start, start + stride,... (count samples) of a 1-d dataset into data
+static herr_t read_samples(hid_t file_id, const char *dataset_name, hsize_t start, hsize_t count, hsize_t stride, double *data) {
+
+	hid_t dset_id = H5I_INVALID_HID;
+	hid_t file_space_id = H5I_INVALID_HID;
+	hid_t mem_space_id = H5I_INVALID_HID;
+	herr_t status = -1;
+
+	if ((dset_id = H5Dopen2(file_id, dataset_name, H5P_DEFAULT)) < 0) {
+		goto out;
+	}
+
+	if ((file_space_id = H5Dget_space(dset_id)) < 0) {
+		goto out;
+	}
+
+	if (H5Sselect_hyperslab(file_space_id, H5S_SELECT_SET, &start, &stride, &count, NULL) < 0) {
+		goto out;
+	}
+
+	if ((mem_space_id = H5Screate_simple(1, &count, NULL)) < 0) {
+		goto out;
+	}
+
+	status = H5Dread(dset_id, H5T_NATIVE_DOUBLE, mem_space_id, file_space_id, H5P_DEFAULT, data);
+
+out:
+	H5Sclose(mem_space_id);
+	H5Sclose(file_space_id);
+	H5Dclose(dset_id);
+
+	return status;
+}
+
 static herr_t set_dataset_attributes(hid_t handle, const char *filename, const char *dataset_name, const char *comment, const char *display_name, const char *unit, const char *display_unit, int relative_quantity) {
 
 	// set the comment
@@ -251,519 +596,2389 @@ static herr_t set_dataset_attributes(hid_t handle, const char *filename, const c
 	return 0;
 }
 
-const char * ModelicaSDF_get_table_data_size(const char *filename, const char *dataset_name, int *size) {
-	
-	hid_t file_id = H5I_INVALID_HID;
+static int is_dsres(const char *filename) {
+	return strlen(filename) > 4 && !strcmp(filename + strlen(filename) - 4, ".mat");
+}
+
+static ModelicaSDF_Handle *alloc_handle(const char *filename, const char *dataset_name, int time_series) {
+
+	ModelicaSDF_Handle *handle;
+	file_stat_t file_info;
+
+	if (!(handle = (ModelicaSDF_Handle *)calloc(1, sizeof(ModelicaSDF_Handle)))) {
+		return NULL;
+	}
+
+	handle->file_id = H5I_INVALID_HID;
+	handle->time_series = time_series;
+	handle->filename = (char *)malloc(strlen(filename) + 1);
+	handle->dataset_name = (char *)malloc(strlen(dataset_name) + 1);
+
+	if (!handle->filename || !handle->dataset_name) {
+		ModelicaSDF_close_handle(handle);
+		return NULL;
+	}
+
+	strcpy(handle->filename, filename);
+	strcpy(handle->dataset_name, dataset_name);
+
+	if (get_file_stat(filename, &file_info) == 0) {
+		handle->mtime = file_info.st_mtime;
+		handle->size = (long long)file_info.st_size;
+	}
+
+	return handle;
+}
+
+/* Takes the pending handle if it has been opened for the same dataset of the unmodified file */
+static ModelicaSDF_Handle *take_pending_handle(const char *filename, const char *dataset_name, int time_series) {
+
+	ModelicaSDF_Handle *handle = pending_handle;
+	file_stat_t file_info;
+
+	if (!handle) {
+		return NULL;
+	}
+
+	pending_handle = NULL;
+
+	if (handle->time_series == time_series &&
+		strcmp(handle->filename, filename) == 0 &&
+		strcmp(handle->dataset_name, dataset_name) == 0 &&
+		get_file_stat(filename, &file_info) == 0 &&
+		handle->mtime == file_info.st_mtime &&
+		handle->size == (long long)file_info.st_size) {
+		return handle;
+	}
+
+	ModelicaSDF_close_handle(handle);
+
+	return NULL;
+}
+
+static void set_pending_handle(ModelicaSDF_Handle *handle) {
+	ModelicaSDF_close_handle(pending_handle);
+	pending_handle = handle;
+}
+
+void ModelicaSDF_close_handle(ModelicaSDF_Handle *handle) {
+
+	int i;
+
+	if (!handle) return;
+
+	LOCK_HDF5();
+
+	if (handle->file_id >= 0) H5Fclose(handle->file_id);
+
+	UNLOCK_HDF5();
+
+	close_dsres(handle->dsres);
+
+	for (i = 0; i < 32; i++) {
+		free(handle->scale_names[i]);
+	}
+
+	free(handle->filename);
+	free(handle->dataset_name);
+	free(handle);
+}
+
+// opens a table and returns the size of its table data vector (which may exceed INT_MAX)
+static const char * open_table(const char *filename, const char *dataset_name, ModelicaSDF_Handle **handle, long long *size) {
+
+	ModelicaSDF_Handle *h = NULL;
 	H5T_class_t type_class = H5T_NO_CLASS;
 	size_t type_size = 0;
-	hsize_t dims[32] = {0};
-	int i = -1, ndims = -1, ndata = -1;
+	long long ndata = -1;
+	int i = -1;
+
+	LOCK_HDF5();
 
 	configureMessageHandling();
-	
+
 	set_error_message("");
 
-	if ((file_id = H5Fopen(filename, H5F_ACC_RDONLY, H5P_DEFAULT)) < 0) {
+	*handle = NULL;
+
+	if (!(h = alloc_handle(filename, dataset_name, 0))) {
+		set_error_message("Failed to allocate memory for dataset '%s' in '%s'", dataset_name, filename);
+		goto out;
+	}
+
+	if ((h->file_id = open_file(filename)) < 0) {
 		set_error_message("Failed to open file '%s'", filename);
 		goto out;
 	}
 
-	if (H5LTget_dataset_ndims(file_id, dataset_name, &ndims) < 0) {
+	if (H5LTget_dataset_ndims(h->file_id, dataset_name, &h->rank) < 0) {
 		set_error_message("Failed to open dataset '%s' in '%s'", dataset_name, filename);
 		goto out;
 	}
 
-	if (H5LTget_dataset_info(file_id, dataset_name, dims, &type_class, &type_size) < 0) {
+	if (H5LTget_dataset_info(h->file_id, dataset_name, h->dims, &type_class, &type_size) < 0) {
 		set_error_message("Failed to open dataset '%s' in '%s'", dataset_name, filename);
 		goto out;
 	}
 
-	*size = 1 + ndims;
+	h->single = type_class == H5T_FLOAT && type_size == sizeof(float);
+
+	// a missing scale is reported by ModelicaSDF_fill_table()
+	for (i = 0; i < h->rank; i++) {
+		h->scale_names[i] = get_scale_name(h->file_id, dataset_name, i);
+	}
+
+	*size = 1 + h->rank;
 
 	ndata = 1;
 
-	for (i = 0; i < ndims; i++) {
-		*size += (int)dims[i];
-		ndata *= (int)dims[i];
+	for (i = 0; i < h->rank; i++) {
+		*size += (long long)h->dims[i];
+		ndata *= (long long)h->dims[i];
 	}
 
 	*size += ndata;
 
+	*handle = h;
+	h = NULL;
+
 out:
-	if (file_id >= 0) H5Fclose(file_id);
+	ModelicaSDF_close_handle(h);
+
+	UNLOCK_HDF5();
 
 	return error_message;
 }
 
-const char * ModelicaSDF_read_table_data(const char *filename, const char *dataset_name, const int ndims, const char *unit, const char **scale_units, double *data) {
+// converts the size of the table data to int (sets the error message and returns -1 if it is too large)
+static int to_int_size(const char *filename, const char *dataset_name, long long size64, int *size) {
+
+	if (size64 > INT_MAX) {
+		set_error_message("The table data of dataset '%s' in '%s' has %lld elements which exceeds the maximum of %d", dataset_name, filename, size64, INT_MAX);
+		*size = 0;
+		return -1;
+	}
+
+	*size = (int)size64;
+
+	return 0;
+}
+
+const char * ModelicaSDF_open_table(const char *filename, const char *dataset_name, ModelicaSDF_Handle **handle, int *size) {
+
+	long long size64 = 0;
+
+	LOCK_HDF5();
+
+	*size = 0;
+
+	if (strlen(open_table(filename, dataset_name, handle, &size64)) == 0 && to_int_size(filename, dataset_name, size64, size) != 0) {
+		ModelicaSDF_close_handle(*handle);
+		*handle = NULL;
+	}
+
+	UNLOCK_HDF5();
+
+	return error_message;
+}
+
+// reads the table data (or only the dimensions and scales if read_values is 0) of an open table
+static const char * fill_table(ModelicaSDF_Handle *handle, const int ndims, const char *unit, const char **scale_units, int read_values, double *data) {
 	
-	hid_t file_id = H5I_INVALID_HID;
-	H5T_class_t type_class = H5T_NO_CLASS;
-	size_t type_size = 0;
-	hsize_t dims[32] = {0};
-	int rank = -1, i = -1, j = -1;
+	const char *filename = handle->filename;
+	const char *dataset_name = handle->dataset_name;
 	const char *scale_name = NULL;
+	int i = -1, j = -1;
+
+	LOCK_HDF5();
 
 	configureMessageHandling();
 	
 	set_error_message("");
-	
-	if ((file_id = H5Fopen(filename, H5F_ACC_RDONLY, H5P_DEFAULT)) < 0) {
-		set_error_message("Failed to open file '%s'", filename);
-		goto out;
-	}
-
-	if (H5LTget_dataset_ndims(file_id, dataset_name, &rank) < 0) {
-		set_error_message("Failed to open dataset '%s' in '%s'", dataset_name, filename);
-		goto out;
-	}
 
-	if (rank != ndims) {
-		set_error_message("Dataset '%s' in '%s' has the wrong number of dimension. Expected %d but was %d.", dataset_name, filename, ndims, rank);
+	if (handle->time_series) {
+		set_error_message("'%s' in '%s' has not been opened as a table", dataset_name, filename);
 		goto out;
 	}
 
-	if (H5LTget_dataset_info(file_id, dataset_name, dims, &type_class, &type_size) < 0) {
-		set_error_message("Failed to open dataset '%s' in '%s'", dataset_name, filename);
+	if (handle->rank != ndims) {
+		set_error_message("Dataset '%s' in '%s' has the wrong number of dimension. Expected %d but was %d.", dataset_name, filename, ndims, handle->rank);
 		goto out;
 	}
 
 	*data++ = ndims;
 
 	for (i = 0; i < ndims; i++) {
-		*data++ = (int)dims[i];
+		*data++ = (double)handle->dims[i];
 	}
 
 	// read scales
 	for (i = 0; i < ndims; i++) {
 
-		scale_name = get_scale_name(file_id, dataset_name, i);
+		scale_name = handle->scale_names[i];
 
 		if (!scale_name) {
 			set_error_message("Dataset '%s' in '%s' has no scale for dimension %d", dataset_name, filename, i + 1);
 			goto out;
 		}
 
-		if (check_dataset_1d(file_id, scale_name, scale_units[i], dims[i])) {
+		if (check_dataset_1d(handle->file_id, scale_name, scale_units[i], handle->dims[i])) {
 			goto out;
 		}
 
-		if (H5LTread_dataset_double(file_id, scale_name, data) < 0) {
+		if (H5LTread_dataset_double(handle->file_id, scale_name, data) < 0) {
 			set_error_message("Failed to read dataset '%s' in '%s'", scale_name, filename);
 			goto out;
 		}
 
 		// check monotonicity
-		for (j = 0; j < dims[i] - 1; j++) {
+		for (j = 0; j < (int)handle->dims[i] - 1; j++) {
 			if (data[j] >= data[j+1]) {
 				set_error_message("Scale '%s' in '%s' is not strictly monotonic increasing", scale_name, filename);
 				goto out;
 			}
 		}
 
-		data += dims[i];
-
-		free((void *)scale_name);
-		scale_name = NULL;
+		data += handle->dims[i];
 	}
 
 	// read data
-	if(H5LTread_dataset_double(file_id, dataset_name, data) < 0) {
+	if (read_values && H5LTread_dataset_double(handle->file_id, dataset_name, data) < 0) {
 		set_error_message("Failed to read dataset '%s' in '%s'", dataset_name, filename);
 		goto out;
 	}
 
 out:
-	if (file_id >= 0) H5Fclose(file_id);
+	UNLOCK_HDF5();
 
 	return error_message;
 }
 
-const char * ModelicaSDF_get_time_series_size(const char *filename, const char **dataset_names, int *size) {
+const char * ModelicaSDF_fill_table(ModelicaSDF_Handle *handle, const int ndims, const char *unit, const char **scale_units, double *data) {
+	return fill_table(handle, ndims, unit, scale_units, 1, data);
+}
+
+const char * ModelicaSDF_get_table_data_size(const char *filename, const char *dataset_name, int *size) {
 	
-	hid_t file_id = H5I_INVALID_HID;
-	H5T_class_t type_class = H5T_NO_CLASS;
-	size_t type_size = 0;
-	hsize_t dims[32] = {0};
-	int ndims = -1;
+	ModelicaSDF_Handle *handle = NULL;
 
-	set_error_message("");
+	LOCK_HDF5();
 
-	if (strlen(filename) > 4 && !strcmp(filename + strlen(filename) - 4, ".mat")) {
-		get_time_series_size_dsres(filename, dataset_names, size);
-		goto out;
+	// keep the handle for the following ModelicaSDF_read_table_data()
+	if (strlen(ModelicaSDF_open_table(filename, dataset_name, &handle, size)) == 0) {
+		set_pending_handle(handle);
 	}
 
-	configureMessageHandling();	
+	UNLOCK_HDF5();
 
-	if ((file_id = H5Fopen(filename, H5F_ACC_RDONLY, H5P_DEFAULT)) < 0) {
-		set_error_message("Failed to open file '%s'", filename);
-		goto out;
-	}
+	return error_message;
+}
 
-	if (H5LTget_dataset_ndims(file_id, dataset_names[0], &ndims) < 0) {
-		set_error_message("Failed to open dataset '%s' in '%s'", dataset_names[0], filename);
-		goto out;
-	}
+const char * ModelicaSDF_get_table_data_size64(const char *filename, const char *dataset_name, long long *size) {
+	
+	ModelicaSDF_Handle *handle = NULL;
 
-	if (ndims != 1) {
-		set_error_message("Dataset '%s' in '%s' is not one-dimensional", dataset_names[0], filename);
-		goto out;
-	}
+	LOCK_HDF5();
 
-	if (H5LTget_dataset_info(file_id, dataset_names[0], dims, &type_class, &type_size) < 0) {
-		set_error_message("Failed to open dataset '%s' in '%s'", dataset_names[0], filename);
-		goto out;
-	}
+	*size = 0;
 
-	*size = (int)dims[0];
+	if (strlen(open_table(filename, dataset_name, &handle, size)) == 0) {
+		set_pending_handle(handle);
+	}
 
-out:
-	if (file_id >= 0) H5Fclose(file_id);
+	UNLOCK_HDF5();
 
 	return error_message;
 }
 
-const char * ModelicaSDF_read_time_series(const char *filename, const int ndatasets, const char **dataset_names, const char **dataset_units, const char *scale_unit, int nsamples, double *data) {
+const char * ModelicaSDF_read_table_data(const char *filename, const char *dataset_name, const int ndims, const char *unit, const char **scale_units, double *data) {
 	
-	hid_t file_id = H5I_INVALID_HID;
-	int i, j;
-	char *first_scale_name = NULL;
-	char *scale_name = NULL;
-	double *buffer = NULL;
+	ModelicaSDF_Handle *handle = NULL;
+	long long size = 0;
 
-	configureMessageHandling();
-	
-	set_error_message("");
+	LOCK_HDF5();
 
-	if (strlen(filename) > 4 && !strcmp(filename + strlen(filename) - 4, ".mat")) {
-		read_dsres(filename, ndatasets, dataset_names, dataset_units, scale_unit, nsamples, data);
+	if (!(handle = take_pending_handle(filename, dataset_name, 0)) && strlen(open_table(filename, dataset_name, &handle, &size)) > 0) {
+		UNLOCK_HDF5();
 		return error_message;
 	}
 
-	// check number of datasets
-	if (ndatasets < 1) {
-		set_error_message("Number of datasets must be > 0");
-		goto out;
-	}
+	ModelicaSDF_fill_table(handle, ndims, unit, scale_units, data);
 
-	// check number of samples
-	if (nsamples < 1) {
-		set_error_message("Number of samples must be > 0");
-		goto out;
-	}
+	ModelicaSDF_close_handle(handle);
 
-	// open the file
-	if ((file_id = H5Fopen(filename, H5F_ACC_RDONLY, H5P_DEFAULT)) < 0) {
-		set_error_message("Failed to open '%s'", filename);
+	UNLOCK_HDF5();
+
+	return error_message;
+}
+
+/* An entry in the shared table cache */
+typedef struct TableCacheEntry {
+	char *key;						//!< file name, dataset name, unit and scale units separated by '\n'
+	time_t mtime;					//!< the modification time of the file when the data was read
+	long long file_size;			//!< the size of the file when the data was read
+	int split;						//!< 1 if the entry was returned by ModelicaSDF_acquire_table(), 0 otherwise
+	int single_requested;			//!< 1 if the values were requested in single precision
+	int single;						//!< 1 if the values are floats
+	long long size;					//!< the number of elements in data
+	double *data;					//!< the table data in the format of ModelicaSDF_read_table_data() (without the values if they are mapped or floats)
+	long long nvalues;				//!< the number of table values
+	const void *values;				//!< the table values (in data, after data if they are floats, or in mapping)
+	void *mapping;					//!< the pages of the file that contain the values (NULL if they are in data)
+	size_t mapping_length;			//!< the length of mapping in bytes
+	MappedFile *mapped_file;		//!< the file of mapping (NULL if the values are in data)
+	int refcount;					//!< the number of references returned by ModelicaSDF_acquire_table_data()
+	struct TableCacheEntry *next;	//!< the next entry in the list
+} TableCacheEntry;
+
+static TableCacheEntry *table_cache = NULL;
+
+static int table_cache_hits = 0;
+static int table_cache_misses = 0;
+static double table_cache_bytes_saved = 0;
+
+#ifdef _WIN32
+static SRWLOCK table_cache_lock = SRWLOCK_INIT;
+#define LOCK_TABLE_CACHE()   AcquireSRWLockExclusive(&table_cache_lock)
+#define UNLOCK_TABLE_CACHE() ReleaseSRWLockExclusive(&table_cache_lock)
+#else
+static pthread_mutex_t table_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+#define LOCK_TABLE_CACHE()   pthread_mutex_lock(&table_cache_lock)
+#define UNLOCK_TABLE_CACHE() pthread_mutex_unlock(&table_cache_lock)
+#endif
+
+// returns the offset of the values of a dataset in the file if they can be mapped
+// (contiguous, unfiltered, aligned little-endian doubles or floats if single is 1) and -1 otherwise
+static long long get_mappable_offset(hid_t file_id, const char *dataset_name, hsize_t numel, int single) {
+
+	const size_t value_size = single ? sizeof(float) : sizeof(double);
+
+	hid_t dset_id = H5I_INVALID_HID;
+	hid_t dcpl_id = H5I_INVALID_HID;
+	hid_t type_id = H5I_INVALID_HID;
+	haddr_t address;
+	long long offset = -1;
+
+	LOCK_HDF5();
+
+	if ((dset_id = H5Dopen2(file_id, dataset_name, H5P_DEFAULT)) < 0 ||
+		(dcpl_id = H5Dget_create_plist(dset_id)) < 0 ||
+		(type_id = H5Dget_type(dset_id)) < 0) {
+		goto out;
+	}
+
+	if (H5Pget_layout(dcpl_id) != H5D_CONTIGUOUS || H5Pget_nfilters(dcpl_id) != 0 || H5Pget_external_count(dcpl_id) != 0) {
+		goto out;
+	}
+
+	if (single ? (H5Tequal(type_id, H5T_IEEE_F32LE) <= 0 || H5Tequal(H5T_NATIVE_FLOAT, H5T_IEEE_F32LE) <= 0)
+		: (H5Tequal(type_id, H5T_IEEE_F64LE) <= 0 || H5Tequal(H5T_NATIVE_DOUBLE, H5T_IEEE_F64LE) <= 0)) {
+		goto out;
+	}
+
+	if (H5Dget_storage_size(dset_id) != numel * value_size) {
+		goto out;
+	}
+
+	// the address includes the user block
+	if ((address = H5Dget_offset(dset_id)) == HADDR_UNDEF || address % value_size != 0) {
+		goto out;
+	}
+
+	offset = (long long)address;
+
+out:
+	if (type_id >= 0) H5Tclose(type_id);
+	if (dcpl_id >= 0) H5Pclose(dcpl_id);
+	if (dset_id >= 0) H5Dclose(dset_id);
+
+	UNLOCK_HDF5();
+
+	return offset;
+}
+
+// maps size bytes at offset of a file into memory and returns a pointer to the first byte (NULL on failure)
+static const void *map_file_region(const char *filename, long long offset, size_t size, void **mapping, size_t *length) {
+
+	file_stat_t file_info;
+	long long start;
+
+#ifdef _WIN32
+	SYSTEM_INFO system_info;
+	HANDLE file, file_mapping;
+
+	GetSystemInfo(&system_info);
+	start = offset - offset % system_info.dwAllocationGranularity;
+#else
+	int fd;
+
+	start = offset - offset % sysconf(_SC_PAGESIZE);
+#endif
+
+	*mapping = NULL;
+	*length = (size_t)(offset - start) + size;
+
+	// don't map beyond the end of the file
+	if (get_file_stat(filename, &file_info) != 0 || offset + (long long)size > (long long)file_info.st_size) {
+		return NULL;
+	}
+
+#ifdef _WIN32
+	file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+	if (file == INVALID_HANDLE_VALUE) {
+		return NULL;
+	}
+
+	file_mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+
+	CloseHandle(file);
+
+	if (!file_mapping) {
+		return NULL;
+	}
+
+	*mapping = MapViewOfFile(file_mapping, FILE_MAP_READ, (DWORD)(start >> 32), (DWORD)(start & 0xFFFFFFFF), *length);
+
+	CloseHandle(file_mapping);
+#else
+	if ((fd = open(filename, O_RDONLY)) < 0) {
+		return NULL;
+	}
+
+	*mapping = mmap(NULL, *length, PROT_READ, MAP_SHARED, fd, (off_t)start);
+
+	close(fd);
+
+	if (*mapping == MAP_FAILED) {
+		*mapping = NULL;
+	}
+#endif
+
+	return *mapping ? (const char *)*mapping + (offset - start) : NULL;
+}
+
+static void unmap_file_region(void *mapping, size_t length) {
+
+	if (!mapping) return;
+
+#ifdef _WIN32
+	UnmapViewOfFile(mapping);
+#else
+	munmap(mapping, length);
+#endif
+}
+
+// counts a mapping of a file (the caller must hold the HDF5 lock, returns NULL on failure)
+static MappedFile *add_mapped_file(const char *filename) {
+
+	MappedFile *mapped;
+
+	for (mapped = mapped_files; mapped; mapped = mapped->next) {
+		if (strcmp(mapped->filename, filename) == 0) {
+			mapped->count++;
+			return mapped;
+		}
+	}
+
+	if (!(mapped = (MappedFile *)malloc(sizeof(MappedFile)))) {
+		return NULL;
+	}
+
+	if (!(mapped->filename = (char *)malloc(strlen(filename) + 1))) {
+		free(mapped);
+		return NULL;
+	}
+
+	strcpy(mapped->filename, filename);
+	mapped->count = 1;
+	mapped->next = mapped_files;
+
+	mapped_files = mapped;
+
+	return mapped;
+}
+
+// unmaps the values of a cache entry and releases its mapped file
+static void unmap_table_values(TableCacheEntry *entry) {
+
+	MappedFile **link;
+
+	if (!entry->mapping) return;
+
+	LOCK_HDF5();
+
+	unmap_file_region(entry->mapping, entry->mapping_length);
+
+	if (entry->mapped_file && --entry->mapped_file->count == 0) {
+		for (link = &mapped_files; *link; link = &(*link)->next) {
+			if (*link == entry->mapped_file) {
+				*link = entry->mapped_file->next;
+				break;
+			}
+		}
+		free(entry->mapped_file->filename);
+		free(entry->mapped_file);
+	}
+
+	entry->mapping = NULL;
+	entry->mapped_file = NULL;
+
+	UNLOCK_HDF5();
+}
+
+static char *table_cache_key(const char *filename, const char *dataset_name, const int ndims, const char *unit, const char **scale_units) {
+
+	size_t len;
+	int i;
+	char *key;
+
+	len = strlen(filename) + strlen(dataset_name) + strlen(unit) + 3;
+
+	for (i = 0; i < ndims; i++) {
+		len += strlen(scale_units[i]) + 1;
+	}
+
+	if (!(key = (char *)malloc(len))) {
+		return NULL;
+	}
+
+	strcpy(key, filename);
+	strcat(key, "\n");
+	strcat(key, dataset_name);
+	strcat(key, "\n");
+	strcat(key, unit);
+
+	for (i = 0; i < ndims; i++) {
+		strcat(key, "\n");
+		strcat(key, scale_units[i]);
+	}
+
+	return key;
+}
+
+// the size of the data and values of a cache entry in bytes
+static double table_cache_entry_bytes(const TableCacheEntry *entry) {
+
+	double bytes = (double)entry->size * sizeof(double);
+
+	if (entry->mapping || entry->single) {
+		bytes += (double)entry->nvalues * (entry->single ? sizeof(float) : sizeof(double));
+	}
+
+	return bytes;
+}
+
+// acquires a shared table (split: return the values separately and map them from the file if possible,
+// single: return the values as floats, set to 1 if the dataset is stored in single precision)
+static const char * acquire_table(const char *filename, const char *dataset_name, const int ndims, const char *unit, const char **scale_units, int split, int *single, const double **data, long long *size, const void **values) {
+
+	file_stat_t file_info;
+	TableCacheEntry *entry = NULL;
+	ModelicaSDF_Handle *handle = NULL;
+	char *key = NULL;
+	double *buffer = NULL;
+	const void *mapped = NULL;
+	long long offset = -1;
+	size_t value_size;
+	herr_t status;
+	int locked = 0, i, nheader, int_size;
+
+	set_error_message("");
+
+	*data = NULL;
+	*size = 0;
+	*values = NULL;
+
+	if (get_file_stat(filename, &file_info) != 0) {
+		set_error_message("Failed to open file '%s'", filename);
+		goto out;
+	}
+
+	if (!(key = table_cache_key(filename, dataset_name, ndims, unit, scale_units))) {
+		set_error_message("Failed to allocate memory for the table cache");
+		goto out;
+	}
+
+	// the lock is held while the data is read so concurrent requests for the same table read it only once
+	LOCK_TABLE_CACHE();
+	locked = 1;
+
+	for (entry = table_cache; entry; entry = entry->next) {
+		// the size catches rewrites within the resolution of the modification time
+		if (entry->mtime == file_info.st_mtime && entry->file_size == (long long)file_info.st_size && entry->split == split && entry->single_requested == *single && strcmp(entry->key, key) == 0) {
+			entry->refcount++;
+			table_cache_hits++;
+			table_cache_bytes_saved += table_cache_entry_bytes(entry);
+			*single = entry->single;
+			*data = entry->data;
+			*size = entry->size;
+			*values = entry->values;
+			entry = NULL;
+			goto out;
+		}
+	}
+
+	if (strlen(open_table(filename, dataset_name, &handle, size)) > 0) {
+		goto out;
+	}
+
+	// ModelicaSDF_acquire_table_data() returns the table data as one vector with an int size
+	if (!split && to_int_size(filename, dataset_name, *size, &int_size) != 0) {
+		*size = 0;
+		goto out;
+	}
+
+	if (!(entry = (TableCacheEntry *)calloc(1, sizeof(TableCacheEntry)))) {
+		set_error_message("Failed to allocate memory for dataset '%s' in '%s'", dataset_name, filename);
+		goto out;
+	}
+
+	// the number of dimensions, the dimensions and the scales
+	nheader = 1 + ndims;
+
+	for (i = 0; i < ndims && i < handle->rank; i++) {
+		nheader += (int)handle->dims[i];
+	}
+
+	// the buffer must fit into the address space
+	if ((unsigned long long)*size > SIZE_MAX / sizeof(double)) {
+		set_error_message("Dataset '%s' in '%s' is too large to be read (%lld elements)", dataset_name, filename, *size);
+		goto out;
+	}
+
+	entry->nvalues = *size - nheader;
+	entry->single_requested = *single;
+	entry->single = split && (*single || handle->single);
+
+	value_size = entry->single ? sizeof(float) : sizeof(double);
+
+	// map large values directly from the file (shared via the page cache)
+	// while holding the HDF5 lock, so the file is not written before the mapping is counted
+	if (split && handle->rank == ndims && (size_t)entry->nvalues * value_size >= MAP_THRESHOLD) {
+
+		LOCK_HDF5();
+
+		if ((offset = get_mappable_offset(handle->file_id, dataset_name, entry->nvalues, entry->single)) >= 0 &&
+			(mapped = map_file_region(filename, offset, (size_t)entry->nvalues * value_size, &entry->mapping, &entry->mapping_length)) != NULL &&
+			!(entry->mapped_file = add_mapped_file(filename))) {
+			unmap_file_region(entry->mapping, entry->mapping_length);
+			entry->mapping = NULL;
+			mapped = NULL;
+		}
+
+		UNLOCK_HDF5();
+	}
+
+	if (mapped || entry->single) {
+		*size = nheader;
+	}
+
+	// floats that are not mapped are stored after the header
+	if (!(buffer = (double *)malloc((size_t)*size * sizeof(double) + (entry->single && !mapped ? (size_t)entry->nvalues * sizeof(float) : 0)))) {
+		set_error_message("Failed to allocate memory for dataset '%s' in '%s'", dataset_name, filename);
+		goto out;
+	}
+
+	if (strlen(fill_table(handle, ndims, unit, scale_units, !mapped && !entry->single, buffer)) > 0) {
+		goto out;
+	}
+
+	if (entry->single && !mapped) {
+
+		LOCK_HDF5();
+
+		// HDF5 converts doubles to floats
+		status = H5LTread_dataset_float(handle->file_id, dataset_name, (float *)(buffer + nheader));
+
+		UNLOCK_HDF5();
+
+		if (status < 0) {
+			set_error_message("Failed to read dataset '%s' in '%s'", dataset_name, filename);
+			goto out;
+		}
+	}
+
+	entry->key = key;
+	entry->mtime = file_info.st_mtime;
+	entry->file_size = (long long)file_info.st_size;
+	entry->split = split;
+	entry->size = *size;
+	entry->data = buffer;
+	entry->values = mapped ? mapped : (const void *)(buffer + nheader);
+	entry->refcount = 1;
+	entry->next = table_cache;
+
+	table_cache = entry;
+	table_cache_misses++;
+
+	*single = entry->single;
+	*data = buffer;
+	*values = entry->values;
+
+	key = NULL;
+	buffer = NULL;
+	entry = NULL;
+
+out:
+	if (locked) UNLOCK_TABLE_CACHE();
+
+	ModelicaSDF_close_handle(handle);
+
+	if (entry) {
+		unmap_table_values(entry);
+		free(entry);
+		*size = 0;
+	}
+
+	free(buffer);
+	free(key);
+
+	return error_message;
+}
+
+const char * ModelicaSDF_acquire_table_data(const char *filename, const char *dataset_name, const int ndims, const char *unit, const char **scale_units, const double **data, int *size) {
+
+	const void *values;
+	long long size64 = 0;
+	int single = 0;
+
+	// the size has been checked by acquire_table()
+	acquire_table(filename, dataset_name, ndims, unit, scale_units, 0, &single, data, &size64, &values);
+
+	*size = (int)size64;
+
+	return error_message;
+}
+
+const char * ModelicaSDF_acquire_table(const char *filename, const char *dataset_name, const int ndims, const char *unit, const char **scale_units, int *single, const double **data, long long *size, const void **values) {
+	return acquire_table(filename, dataset_name, ndims, unit, scale_units, 1, single, data, size, values);
+}
+
+void ModelicaSDF_release_table_data(const double *data) {
+
+	TableCacheEntry **link, *entry;
+
+	if (!data) return;
+
+	LOCK_TABLE_CACHE();
+
+	for (link = &table_cache; (entry = *link) != NULL; link = &entry->next) {
+		if (entry->data == data) {
+			if (--entry->refcount == 0) {
+				*link = entry->next;
+				unmap_table_values(entry);
+				free(entry->key);
+				free(entry->data);
+				free(entry);
+			}
+			break;
+		}
+	}
+
+	UNLOCK_TABLE_CACHE();
+}
+
+void ModelicaSDF_get_table_cache_statistics(int *entries, int *hits, int *misses, double *bytes_cached, double *bytes_saved) {
+
+	TableCacheEntry *entry;
+
+	LOCK_TABLE_CACHE();
+
+	*entries = 0;
+	*bytes_cached = 0;
+
+	for (entry = table_cache; entry; entry = entry->next) {
+		(*entries)++;
+		*bytes_cached += table_cache_entry_bytes(entry);
+	}
+
+	*hits = table_cache_hits;
+	*misses = table_cache_misses;
+	*bytes_saved = table_cache_bytes_saved;
+
+	UNLOCK_TABLE_CACHE();
+}
+
+const char * ModelicaSDF_open_time_series(const char *filename, const char **dataset_names, ModelicaSDF_Handle **handle, int *size) {
+	
+	ModelicaSDF_Handle *h = NULL;
+	H5T_class_t type_class = H5T_NO_CLASS;
+	size_t type_size = 0;
+	hsize_t dims[32] = {0};
+	int ndims = -1;
+
+	LOCK_HDF5();
+
+	configureMessageHandling();
+
+	set_error_message("");
+
+	*handle = NULL;
+
+	if (!(h = alloc_handle(filename, dataset_names[0], 1))) {
+		set_error_message("Failed to allocate memory for dataset '%s' in '%s'", dataset_names[0], filename);
+		goto out;
+	}
+
+	if (is_dsres(filename)) {
+		if ((h->dsres = open_dsres(filename, size))) {
+			*handle = h;
+			h = NULL;
+		}
+		goto out;
+	}
+
+	if ((h->file_id = open_file(filename)) < 0) {
+		set_error_message("Failed to open file '%s'", filename);
+		goto out;
+	}
+
+	if (H5LTget_dataset_ndims(h->file_id, dataset_names[0], &ndims) < 0) {
+		set_error_message("Failed to open dataset '%s' in '%s'", dataset_names[0], filename);
+		goto out;
+	}
+
+	if (ndims != 1) {
+		set_error_message("Dataset '%s' in '%s' is not one-dimensional", dataset_names[0], filename);
+		goto out;
+	}
+
+	if (H5LTget_dataset_info(h->file_id, dataset_names[0], dims, &type_class, &type_size) < 0) {
+		set_error_message("Failed to open dataset '%s' in '%s'", dataset_names[0], filename);
+		goto out;
+	}
+
+	// a missing scale is reported by ModelicaSDF_fill_time_series()
+	h->rank = 1;
+	h->dims[0] = dims[0];
+	h->scale_names[0] = get_scale_name(h->file_id, dataset_names[0], 0);
+
+	*size = (int)dims[0];
+
+	*handle = h;
+	h = NULL;
+
+out:
+	ModelicaSDF_close_handle(h);
+
+	UNLOCK_HDF5();
+
+	return error_message;
+}
+
+// reads the samples start, start + stride,... (nsamples samples) of an open time series
+// (exact: the datasets must have exactly nsamples samples)
+static const char * fill_time_series_window(ModelicaSDF_Handle *handle, const int ndatasets, const char **dataset_names, const char **dataset_units, const char *scale_unit, int start, int nsamples, int stride, int exact, double *data) {
+	
+	const char *filename = handle->filename;
+	hid_t file_id = handle->file_id;
+	hsize_t numel = (hsize_t)start + (hsize_t)(nsamples - 1) * stride + 1;
+	const int ncols = ndatasets + 1;
+	int i, j, row, nrows, batch_size, depth;
+	const char *first_scale_name = handle->scale_names[0];
+	const char *name;
+	char *scale_name = NULL;
+	double *buffer = NULL;
+
+	LOCK_HDF5();
+
+	configureMessageHandling();
+	
+	set_error_message("");
+
+	if (!handle->time_series) {
+		set_error_message("'%s' in '%s' has not been opened as a time series", handle->dataset_name, filename);
+		goto out;
+	}
+
+	// check the window
+	if (start < 0 || stride < 1) {
+		set_error_message("The first sample must be >= 0 and the stride must be > 0");
+		goto out;
+	}
+
+	if (handle->dsres) {
+		// the result file belongs to the handle and is read with matio, so other threads can use HDF5
+		depth = suspend_hdf5();
+		read_dsres(handle->dsres, filename, ndatasets, dataset_names, dataset_units, scale_unit, start, nsamples, stride, data);
+		resume_hdf5(depth);
+		goto out;
+	}
+
+	// check number of datasets
+	if (ndatasets < 1) {
+		set_error_message("Number of datasets must be > 0");
+		goto out;
+	}
+
+	// check number of samples
+	if (nsamples < 1) {
+		set_error_message("Number of samples must be > 0");
+		goto out;
+	}
+
+	if (!first_scale_name) {
+		set_error_message("Dataset '%s' in '%s' has no scale", dataset_names[0], filename);
+		goto out;
+	}
+
+	// the scale and all datasets must have the same size as the first dataset
+	if (check_dataset_1d(file_id, first_scale_name, scale_unit, handle->dims[0])) {
+		goto out;
+	}
+
+	// check the datasets
+	for (i = 0; i < ndatasets; i++) {
+		
+		if (i > 0) {
+
+			scale_name = get_scale_name(file_id, dataset_names[i], 0);
+
+			if (!scale_name) {
+				set_error_message("Dataset '%s' in '%s' has no scale", dataset_names[i], filename);
+				goto out;
+			}
+
+			// make sure the dataset has the same scale
+			if (strcmp(scale_name, first_scale_name)) {
+				set_error_message("Dataset '%s' in '%s' must have the same scale as the previous dataset", dataset_names[i], filename);
+				goto out;
+			}
+
+			free(scale_name);
+			scale_name = NULL;
+		}
+
+		// check size and unit
+		if (check_dataset_1d(file_id, dataset_names[i], dataset_units[i], handle->dims[0])) {
+			goto out;
+		}
+	}
+
+	// the window must lie within the samples (and cover all of them if exact)
+	if (exact ? numel != handle->dims[0] : numel > handle->dims[0]) {
+		set_error_message("Dataset '%s' has the wrong number of elements", first_scale_name);
+		goto out;
+	}
+
+	// read the columns in batches and interleave them without holding the lock
+	batch_size = READ_BATCH_SIZE / ncols > 0 ? READ_BATCH_SIZE / ncols : 1;
+	batch_size = batch_size < nsamples ? batch_size : nsamples;
+
+	if (!(buffer = (double *)malloc(sizeof(double) * batch_size * ncols))) {
+		set_error_message("Failed to allocate memory to read '%s'", filename);
+		goto out;
+	}
+
+	for (row = 0; row < nsamples; row += nrows) {
+
+		nrows = nsamples - row < batch_size ? nsamples - row : batch_size;
+
+		for (i = 0; i < ncols; i++) {
+
+			name = i == 0 ? first_scale_name : dataset_names[i - 1];
+
+			if (read_samples(file_id, name, (hsize_t)start + (hsize_t)row * stride, nrows, stride, &buffer[(size_t)i * nrows]) < 0) {
+				set_error_message("Failed to read dataset '%s' in '%s'", name, filename);
+				goto out;
+			}
+		}
+
+		depth = suspend_hdf5();
+
+		for (j = 0; j < nrows; j++) {
+			for (i = 0; i < ncols; i++) {
+				data[((size_t)row + j) * ncols + i] = buffer[(size_t)i * nrows + j];
+			}
+		}
+
+		resume_hdf5(depth);
+	}
+
+out:
+
+	free(buffer);
+	free(scale_name);
+
+	UNLOCK_HDF5();
+
+	return error_message;
+}
+
+const char * ModelicaSDF_fill_time_series(ModelicaSDF_Handle *handle, const int ndatasets, const char **dataset_names, const char **dataset_units, const char *scale_unit, int nsamples, double *data) {
+	return fill_time_series_window(handle, ndatasets, dataset_names, dataset_units, scale_unit, 0, nsamples, 1, 1, data);
+}
+
+const char * ModelicaSDF_get_time_series_size(const char *filename, const char **dataset_names, int *size) {
+	
+	ModelicaSDF_Handle *handle = NULL;
+
+	LOCK_HDF5();
+
+	// keep the handle for the following ModelicaSDF_read_time_series()
+	if (strlen(ModelicaSDF_open_time_series(filename, dataset_names, &handle, size)) == 0) {
+		set_pending_handle(handle);
+	}
+
+	UNLOCK_HDF5();
+
+	return error_message;
+}
+
+const char * ModelicaSDF_read_time_series(const char *filename, const int ndatasets, const char **dataset_names, const char **dataset_units, const char *scale_unit, int nsamples, double *data) {
+	
+	ModelicaSDF_Handle *handle = NULL;
+	int size = 0;
+
+	if (ndatasets < 1) {
+		set_error_message("Number of datasets must be > 0");
+		return error_message;
+	}
+
+	LOCK_HDF5();
+
+	if (!(handle = take_pending_handle(filename, dataset_names[0], 1)) && strlen(ModelicaSDF_open_time_series(filename, dataset_names, &handle, &size)) > 0) {
+		UNLOCK_HDF5();
+		return error_message;
+	}
+
+	ModelicaSDF_fill_time_series(handle, ndatasets, dataset_names, dataset_units, scale_unit, nsamples, data);
+
+	ModelicaSDF_close_handle(handle);
+
+	UNLOCK_HDF5();
+
+	return error_message;
+}
+
+// reads the value of the scale of an open time series at index
+static int read_scale_value(ModelicaSDF_Handle *handle, int index, double *value) {
+
+	if (handle->dsres) {
+		return read_dsres_time(handle->dsres, index, value);
+	}
+
+	return read_samples(handle->file_id, handle->scale_names[0], index, 1, 1, value) < 0 ? -1 : 0;
+}
+
+const char * ModelicaSDF_get_time_series_window(const char *filename, const char **dataset_names, double start_time, double stop_time, int stride, int *start, int *count) {
+
+	ModelicaSDF_Handle *handle = NULL;
+	int size = 0, lo, hi, mid, first, last;
+	double value = 0;
+
+	*start = 0;
+	*count = 0;
+
+	if (stride < 1) {
+		set_error_message("The stride must be > 0");
+		return error_message;
+	}
+
+	if (stop_time < start_time) {
+		set_error_message("The stop time must be >= the start time");
+		return error_message;
+	}
+
+	LOCK_HDF5();
+
+	if (strlen(ModelicaSDF_open_time_series(filename, dataset_names, &handle, &size)) > 0) {
+		UNLOCK_HDF5();
+		return error_message;
+	}
+
+	if (!handle->dsres && !handle->scale_names[0]) {
+		set_error_message("Dataset '%s' in '%s' has no scale", dataset_names[0], filename);
+		goto out;
+	}
+
+	if (size < 1) {
+		set_error_message("Dataset '%s' in '%s' is empty", dataset_names[0], filename);
+		goto out;
+	}
+
+	// the last sample <= start_time (or the first sample)
+	for (lo = 0, hi = size - 1; lo < hi;) {
+
+		mid = lo + (hi - lo + 1) / 2;
+
+		if (read_scale_value(handle, mid, &value)) {
+			goto read_error;
+		}
+
+		if (value <= start_time) {
+			lo = mid;
+		} else {
+			hi = mid - 1;
+		}
+	}
+
+	first = lo;
+
+	// the first sample >= stop_time (or the last sample)
+	for (lo = first, hi = size - 1; lo < hi;) {
+
+		mid = lo + (hi - lo) / 2;
+
+		if (read_scale_value(handle, mid, &value)) {
+			goto read_error;
+		}
+
+		if (value >= stop_time) {
+			hi = mid;
+		} else {
+			lo = mid + 1;
+		}
+	}
+
+	last = lo;
+
+	// cover [first, last] without reading beyond the end
+	*start = first;
+	*count = (last - first + stride - 1) / stride + 1;
+
+	if (first + (*count - 1) * stride > size - 1) {
+		(*count)--;
+	}
+
+	// keep the handle for the following ModelicaSDF_read_time_series_window()
+	set_pending_handle(handle);
+
+	UNLOCK_HDF5();
+
+	return error_message;
+
+read_error:
+	set_error_message("Failed to read the scale of '%s' in '%s'", dataset_names[0], filename);
+
+out:
+	ModelicaSDF_close_handle(handle);
+
+	UNLOCK_HDF5();
+
+	return error_message;
+}
+
+const char * ModelicaSDF_read_time_series_window(const char *filename, const int ndatasets, const char **dataset_names, const char **dataset_units, const char *scale_unit, int start, int count, int stride, double *data) {
+
+	ModelicaSDF_Handle *handle = NULL;
+	int size = 0;
+
+	if (ndatasets < 1) {
+		set_error_message("Number of datasets must be > 0");
+		return error_message;
+	}
+
+	LOCK_HDF5();
+
+	if (!(handle = take_pending_handle(filename, dataset_names[0], 1)) && strlen(ModelicaSDF_open_time_series(filename, dataset_names, &handle, &size)) > 0) {
+		UNLOCK_HDF5();
+		return error_message;
+	}
+
+	fill_time_series_window(handle, ndatasets, dataset_names, dataset_units, scale_unit, start, count, stride, 0, data);
+
+	ModelicaSDF_close_handle(handle);
+
+	UNLOCK_HDF5();
+
+	return error_message;
+}
+
+const char * ModelicaSDF_get_alias_statistics(const char *filename, const int ndatasets, const char **dataset_names, int *aliases, int *nvariables, int *ncolumns) {
+
+	ModelicaSDF_Handle *handle = NULL;
+	const char *first_name = "";
+	int size = 0;
+
+	LOCK_HDF5();
+
+	configureMessageHandling();
+
+	set_error_message("");
+
+	if (!is_dsres(filename)) {
+		set_error_message("'%s' is not a Dymola result file", filename);
+		UNLOCK_HDF5();
+		return error_message;
+	}
+
+	if (strlen(ModelicaSDF_open_time_series(filename, ndatasets > 0 ? dataset_names : &first_name, &handle, &size)) > 0) {
+		UNLOCK_HDF5();
+		return error_message;
+	}
+
+	get_dsres_aliases(handle->dsres, filename, ndatasets, dataset_names, aliases, nvariables, ncolumns);
+
+	ModelicaSDF_close_handle(handle);
+
+	UNLOCK_HDF5();
+
+	return error_message;
+}
+
+const char * ModelicaSDF_create_group(const char *filename, const char *group_name, const char *comment) {
+	
+	hid_t file_id = H5I_INVALID_HID;
+	hid_t group_id = H5I_INVALID_HID;
+
+	LOCK_HDF5();
+
+	configureMessageHandling();
+	
+	set_error_message("");
+
+	// open the file
+	if ((file_id = open_or_create_file(filename)) < 0) {
+		goto out;
+	}
+
+	// create the group
+	if((group_id = H5Gopen2(file_id, group_name, H5P_DEFAULT)) < 0) {
+		// create the group if it does not exist
+		if((group_id = H5Gcreate2(file_id, group_name, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT)) < 0) { 
+			set_error_message("Failed to create group '%s' in '%s'", group_name, filename);
+			goto out; 
+		}
+	}
+
+	// set the comment
+	if(comment && strlen(comment) > 0) {
+		if(H5LTset_attribute_string(group_id, ".", COMMENT_ATTR_NAME, comment) < 0) { 
+			set_error_message("Failed to set comment for group '%s' in '%s'", group_name, filename);
+		}
+	}
+
+out:
+	if (group_id >= 0) H5Gclose(group_id);
+	if (file_id >= 0) H5Fclose(file_id);
+
+	UNLOCK_HDF5();
+
+	return error_message;
+}
+
+static const char * get_dataset_dims(const char *filename, const char *dataset_name, hsize_t dimsbuf[]) {
+
+	hid_t file_id = H5I_INVALID_HID;
+	H5T_class_t type_class = H5T_NO_CLASS;
+	size_t size = 0;
+
+	LOCK_HDF5();
+
+	configureMessageHandling();
+	
+	set_error_message("");
+
+	if ((file_id = open_file(filename)) < 0) {
+		set_error_message("Failed to open file '%s'", filename);
+		goto out;
+	}
+
+	if (H5LTget_dataset_info(file_id, dataset_name, dimsbuf, &type_class, &size) < 0) {
+		set_error_message("Failed to open dataset '%s' in '%s'", dataset_name, filename);
+		goto out;
+	}
+
+out:
+	if (file_id >= 0) H5Fclose(file_id);
+
+	UNLOCK_HDF5();
+
+	return error_message;
+}
+
+const char * ModelicaSDF_get_dataset_dims(const char *filename, const char *dataset_name, int dims[]) {
+
+	hsize_t dimsbuf[32] = {0};
+	int i = -1;
+
+	if (strlen(get_dataset_dims(filename, dataset_name, dimsbuf)) > 0) {
+		return error_message;
+	}
+
+	for (i = 0; i < 32; i++) {
+
+		if (dimsbuf[i] > INT_MAX) {
+			set_error_message("Dimension %d of dataset '%s' in '%s' has %llu elements which exceeds the maximum of %d", i + 1, dataset_name, filename, (unsigned long long)dimsbuf[i], INT_MAX);
+			return error_message;
+		}
+
+		dims[i] = (int)dimsbuf[i];
+	}
+
+	return error_message;
+}
+
+const char * ModelicaSDF_get_dataset_dims64(const char *filename, const char *dataset_name, long long dims[]) {
+
+	hsize_t dimsbuf[32] = {0};
+	int i = -1;
+
+	if (strlen(get_dataset_dims(filename, dataset_name, dimsbuf)) > 0) {
+		return error_message;
+	}
+
+	for (i = 0; i < 32; i++) {
+		dims[i] = (long long)dimsbuf[i];
+	}
+
+	return error_message;
+}
+
+const char * ModelicaSDF_read_dataset_double(const char *filename, const char *dataset_name, const char *unit, double *buffer) {
+
+	hid_t file_id = H5I_INVALID_HID;
+
+	LOCK_HDF5();
+
+	configureMessageHandling();
+	
+	set_error_message("");
+
+	// open the file
+	if ((file_id = open_file(filename)) < 0) {
+		set_error_message("Failed to open '%s'", filename);
+		goto out;
+	}
+
+	// read the dataset
+	if (H5LTread_dataset_double(file_id, dataset_name, buffer) < 0) {
+		set_error_message("Failed to read double dataset '%s' from '%s'", dataset_name, filename);
+		goto out;
+	}
+
+	// check the unit
+	if (unit != NULL && strlen(unit) > 0 && assert_string_attribute(file_id, dataset_name, UNIT_ATTR_NAME, unit) != 0) {
+		goto out;
+	}
+
+out:
+	// close the file
+	if (file_id >= 0) H5Fclose(file_id);
+
+	UNLOCK_HDF5();
+
+	return error_message;
+}
+
+const char * ModelicaSDF_read_dataset_int(const char *filename, const char *dataset_name, const char *unit, int *buffer) {
+	
+	hid_t file_id = H5I_INVALID_HID;
+
+	LOCK_HDF5();
+
+	configureMessageHandling();
+	
+	set_error_message("");
+	
+	if ((file_id = open_file(filename)) < 0) {
+		set_error_message("Failed to open '%s'", filename);
+		goto out;
+	}
+
+	if (H5LTread_dataset_int(file_id, dataset_name, buffer) < 0) {
+		set_error_message("Failed to read integer dataset '%s' from '%s'", dataset_name, filename);
+		goto out;
+	}
+
+	// check the unit
+	if (unit != NULL && strlen(unit) > 0 && assert_string_attribute(file_id, dataset_name, UNIT_ATTR_NAME, unit)) {
+		goto out;
+	}
+
+out:
+	if (file_id >= 0) H5Fclose(file_id);
+
+	UNLOCK_HDF5();
+
+	return error_message;
+}
+
+const char * ModelicaSDF_make_dataset_double(
+	
+	const char *filename,
+	const char *dataset_name,
+	int ndims,
+	const int dims[],
+	const double *data,
+	const char *comment,
+	const char *display_name,
+	const char *unit,
+	const char *display_unit,
+	int relative_quantity) {
+
+	hid_t file_id = H5I_INVALID_HID;
+	int i = -1;
+	hsize_t dimsbuf[32] = {0};
+
+	LOCK_HDF5();
+
+	configureMessageHandling();
+
+	set_error_message("");
+	
+	for (i = 0; i < ndims; i++) {
+		dimsbuf[i] = (hsize_t)dims[i];
+	}
+
+	// open the file
+	if ((file_id = open_or_create_file(filename)) < 0) {
+		goto out;
+	}
+
+	if (delete_dataset(file_id, dataset_name) < 0) {
+		// delete_dataset() will set the error message
+		goto out;
+	}
+
+	if (H5LTmake_dataset_double(file_id, dataset_name, ndims, dimsbuf, data) < 0) {
+		set_error_message("Failed to create dataset %s in %s", dataset_name, filename);
+		goto out;
+	}
+
+	if (set_dataset_attributes(file_id, filename, dataset_name, comment, display_name, unit, display_unit, relative_quantity) < 0) {
+		// set_dataset_attributes() will set the error message
+		goto out;
+	}
+
+out:
+	// close the file
+	if (file_id >= 0) H5Fclose(file_id);
+
+	UNLOCK_HDF5();
+
+	return error_message;
+}
+
+const char * ModelicaSDF_make_dataset_float(
+	
+	const char *filename,
+	const char *dataset_name,
+	int ndims,
+	const int dims[],
+	const double *data,
+	const char *comment,
+	const char *display_name,
+	const char *unit,
+	const char *display_unit,
+	int relative_quantity) {
+
+	hid_t file_id = H5I_INVALID_HID;
+	int i = -1;
+	size_t numel = 1, j;
+	hsize_t dimsbuf[32] = {0};
+	float *buffer = NULL;
+
+	LOCK_HDF5();
+
+	configureMessageHandling();
+
+	set_error_message("");
+	
+	for (i = 0; i < ndims; i++) {
+		dimsbuf[i] = (hsize_t)dims[i];
+		numel *= (size_t)dims[i];
+	}
+
+	if (!(buffer = (float *)malloc((numel > 0 ? numel : 1) * sizeof(float)))) {
+		set_error_message("Failed to allocate memory for dataset %s in %s", dataset_name, filename);
+		goto out;
+	}
+
+	for (j = 0; j < numel; j++) {
+		buffer[j] = (float)data[j];
+	}
+
+	// open the file
+	if ((file_id = open_or_create_file(filename)) < 0) {
+		goto out;
+	}
+
+	if (delete_dataset(file_id, dataset_name) < 0) {
+		// delete_dataset() will set the error message
+		goto out;
+	}
+
+	if (H5LTmake_dataset_float(file_id, dataset_name, ndims, dimsbuf, buffer) < 0) {
+		set_error_message("Failed to create dataset %s in %s", dataset_name, filename);
+		goto out;
+	}
+
+	if (set_dataset_attributes(file_id, filename, dataset_name, comment, display_name, unit, display_unit, relative_quantity) < 0) {
+		// set_dataset_attributes() will set the error message
+		goto out;
+	}
+
+out:
+	// close the file
+	if (file_id >= 0) H5Fclose(file_id);
+
+	UNLOCK_HDF5();
+
+	free(buffer);
+
+	return error_message;
+}
+
+const char *   ModelicaSDF_make_dataset_int(
+	const char *filename,
+	const char *dataset_name,
+	int ndims,
+	const int dims[],
+	const int *data,
+	const char *comment,
+	const char *display_name,
+	const char *unit,
+	const char *display_unit,
+	int relative_quantity) {
+
+	hid_t file_id = H5I_INVALID_HID;
+	int i = -1;
+	hsize_t dimsbuf[32] = {0};
+
+	LOCK_HDF5();
+
+	configureMessageHandling();
+	
+	set_error_message("");
+
+	for (i = 0; i < ndims; i++) {
+		dimsbuf[i] = (hsize_t)dims[i];
+	}
+
+	// open the file
+	if ((file_id = open_or_create_file(filename)) < 0) {
+		goto out;
+	}
+
+	if (delete_dataset(file_id, dataset_name) < 0) {
+		// delete_dataset() will set the error message
+		goto out;
+	}
+
+	if (H5LTmake_dataset_int(file_id, dataset_name, ndims, dimsbuf, data) < 0) {
+		set_error_message("Failed to create dataset %s in %s", dataset_name, filename);
+		goto out;
+	}
+	
+	if (set_dataset_attributes(file_id, filename, dataset_name, comment, display_name, unit, display_unit, relative_quantity) < 0) {
+		// set_dataset_attributes() will set the error message
+		goto out;
+	}
+
+out:
+	// close the file
+	if (file_id >= 0) H5Fclose(file_id);
+
+	UNLOCK_HDF5();
+
+	return error_message;
+}
+
+// guesses the shape of the chunks (about CHUNK_SIZE bytes) by halving the largest dimension
+static void guess_chunk_dims(int ndims, const hsize_t dims[], size_t type_size, hsize_t chunk_dims[]) {
+
+	hsize_t size = type_size;
+	int i, largest;
+
+	for (i = 0; i < ndims; i++) {
+		chunk_dims[i] = dims[i] > 0 ? dims[i] : 1;
+		size *= chunk_dims[i];
+	}
+
+	while (size > CHUNK_SIZE) {
+
+		for (i = 1, largest = 0; i < ndims; i++) {
+			if (chunk_dims[i] > chunk_dims[largest]) {
+				largest = i;
+			}
+		}
+
+		if (chunk_dims[largest] == 1) {
+			break;
+		}
+
+		size /= chunk_dims[largest];
+		chunk_dims[largest] = (chunk_dims[largest] + 1) / 2;
+		size *= chunk_dims[largest];
+	}
+}
+
+static const char * make_chunked_dataset(
+	const char *filename,
+	const char *dataset_name,
+	int ndims,
+	const int dims[],
+	hid_t type_id,
+	const void *data,
+	const char *comment,
+	const char *display_name,
+	const char *unit,
+	const char *display_unit,
+	int relative_quantity,
+	const int chunk_dims[],
+	int deflate_level,
+	int shuffle,
+	int scale_offset) {
+
+	hid_t file_id = H5I_INVALID_HID;
+	hid_t space_id = H5I_INVALID_HID;
+	hid_t plist_id = H5I_INVALID_HID;
+	hid_t dset_id = H5I_INVALID_HID;
+	int i = -1;
+	hsize_t dimsbuf[32] = {0};
+	hsize_t chunkbuf[32] = {0};
+
+	LOCK_HDF5();
+
+	configureMessageHandling();
+
+	set_error_message("");
+
+	if (ndims < 1 || ndims > 32) {
+		set_error_message("Chunked datasets must have 1 to 32 dimensions");
+		goto out;
+	}
+
+	if (deflate_level < 0 || deflate_level > 9) {
+		set_error_message("The deflate level must be in the range [0, 9]");
+		goto out;
+	}
+
+	if (deflate_level > 0 && H5Zfilter_avail(H5Z_FILTER_DEFLATE) <= 0) {
+		set_error_message("The deflate filter is not available");
+		goto out;
+	}
+
+	for (i = 0; i < ndims; i++) {
+		dimsbuf[i] = (hsize_t)dims[i];
+	}
+
+	// use the given chunk dimensions or guess them
+	if (chunk_dims && chunk_dims[0] > 0) {
+		for (i = 0; i < ndims; i++) {
+			if (chunk_dims[i] < 1) {
+				set_error_message("The chunk dimensions must be > 0");
+				goto out;
+			}
+			chunkbuf[i] = (hsize_t)chunk_dims[i];
+		}
+	} else {
+		guess_chunk_dims(ndims, dimsbuf, H5Tget_size(type_id), chunkbuf);
+	}
+
+	// open the file
+	if ((file_id = open_or_create_file(filename)) < 0) {
+		goto out;
+	}
+
+	if (delete_dataset(file_id, dataset_name) < 0) {
+		// delete_dataset() will set the error message
+		goto out;
+	}
+
+	// the filters are applied in this order when writing
+	if ((plist_id = H5Pcreate(H5P_DATASET_CREATE)) < 0 ||
+		H5Pset_chunk(plist_id, ndims, chunkbuf) < 0 ||
+		(scale_offset && H5Pset_scaleoffset(plist_id, H5Z_SO_INT, H5Z_SO_INT_MINBITS_DEFAULT) < 0) ||
+		(shuffle && H5Pset_shuffle(plist_id) < 0) ||
+		(deflate_level > 0 && H5Pset_deflate(plist_id, (unsigned)deflate_level) < 0)) {
+		set_error_message("Failed to set the filters for dataset %s in %s", dataset_name, filename);
+		goto out;
+	}
+
+	if ((space_id = H5Screate_simple(ndims, dimsbuf, NULL)) < 0 ||
+		(dset_id = H5Dcreate2(file_id, dataset_name, type_id, space_id, H5P_DEFAULT, plist_id, H5P_DEFAULT)) < 0 ||
+		H5Dwrite(dset_id, type_id, H5S_ALL, H5S_ALL, H5P_DEFAULT, data) < 0) {
+		set_error_message("Failed to create dataset %s in %s", dataset_name, filename);
+		goto out;
+	}
+
+	// close the dataset before the attributes are set by name
+	H5Dclose(dset_id);
+	dset_id = H5I_INVALID_HID;
+
+	if (set_dataset_attributes(file_id, filename, dataset_name, comment, display_name, unit, display_unit, relative_quantity) < 0) {
+		// set_dataset_attributes() will set the error message
+		goto out;
+	}
+
+out:
+	if (dset_id >= 0) H5Dclose(dset_id);
+	if (space_id >= 0) H5Sclose(space_id);
+	if (plist_id >= 0) H5Pclose(plist_id);
+
+	// close the file
+	if (file_id >= 0) H5Fclose(file_id);
+
+	UNLOCK_HDF5();
+
+	return error_message;
+}
+
+const char * ModelicaSDF_make_chunked_dataset_double(
+	const char *filename,
+	const char *dataset_name,
+	int ndims,
+	const int dims[],
+	const double *data,
+	const char *comment,
+	const char *display_name,
+	const char *unit,
+	const char *display_unit,
+	int relative_quantity,
+	const int chunk_dims[],
+	int deflate_level,
+	int shuffle) {
+
+	return make_chunked_dataset(filename, dataset_name, ndims, dims, H5T_NATIVE_DOUBLE, data, comment, display_name, unit, display_unit, relative_quantity, chunk_dims, deflate_level, shuffle, 0);
+}
+
+const char * ModelicaSDF_make_chunked_dataset_int(
+	const char *filename,
+	const char *dataset_name,
+	int ndims,
+	const int dims[],
+	const int *data,
+	const char *comment,
+	const char *display_name,
+	const char *unit,
+	const char *display_unit,
+	int relative_quantity,
+	const int chunk_dims[],
+	int deflate_level,
+	int shuffle,
+	int scale_offset) {
+
+	return make_chunked_dataset(filename, dataset_name, ndims, dims, H5T_NATIVE_INT, data, comment, display_name, unit, display_unit, relative_quantity, chunk_dims, deflate_level, shuffle, scale_offset);
+}
+
+// opens an appendable 1-d dataset of the append file or creates it with size samples (filled with NaN)
+//
+// The dataset is kept open until the append file is closed. The returned handle must be closed with H5Dclose().
+static hid_t open_or_create_appendable_dataset(const char *filename, const char *dataset_name, const char *unit, hsize_t size, int *created) {
+
+	hid_t dset_id = H5I_INVALID_HID;
+	hid_t space_id = H5I_INVALID_HID;
+	hid_t plist_id = H5I_INVALID_HID;
+	hsize_t max_size = H5S_UNLIMITED;
+	hsize_t chunk_size = APPEND_CHUNK_SIZE;
+	double fill_value = NAN;
+	hid_t file_id = append_file_id;
+	AppendDataset *datasets = NULL;
+	int i, j, rank;
+
+	*created = 0;
+
+	// start after the last dataset that was found (the datasets are usually appended in the same order)
+	for (i = 0; i < n_append_datasets; i++) {
+		j = (append_dataset_hint + i) % n_append_datasets;
+		if (strcmp(append_datasets[j].name, dataset_name) == 0) {
+			append_dataset_hint = j + 1;
+			H5Iinc_ref(append_datasets[j].dset_id);
+			return append_datasets[j].dset_id;
+		}
+	}
+
+	if (H5LTget_dataset_ndims(file_id, dataset_name, &rank) == 0) {
+
+		if ((dset_id = H5Dopen2(file_id, dataset_name, H5P_DEFAULT)) < 0) {
+			set_error_message("Failed to open dataset '%s' in '%s'", dataset_name, filename);
+			return dset_id;
+		}
+
+		space_id = H5Dget_space(dset_id);
+
+		if (rank != 1 || H5Sget_simple_extent_dims(space_id, NULL, &max_size) < 0 || max_size != H5S_UNLIMITED) {
+			set_error_message("Dataset '%s' in '%s' is not an appendable one-dimensional dataset", dataset_name, filename);
+			H5Dclose(dset_id);
+			dset_id = H5I_INVALID_HID;
+		}
+
+		goto out;
+	}
+
+	if ((plist_id = H5Pcreate(H5P_DATASET_CREATE)) < 0 ||
+		H5Pset_chunk(plist_id, 1, &chunk_size) < 0 ||
+		H5Pset_fill_value(plist_id, H5T_NATIVE_DOUBLE, &fill_value) < 0 ||
+		(space_id = H5Screate_simple(1, &size, &max_size)) < 0 ||
+		(dset_id = H5Dcreate2(file_id, dataset_name, H5T_NATIVE_DOUBLE, space_id, H5P_DEFAULT, plist_id, H5P_DEFAULT)) < 0) {
+		set_error_message("Failed to create dataset '%s' in '%s'", dataset_name, filename);
+		goto out;
+	}
+
+	if (set_dataset_attributes(file_id, filename, dataset_name, NULL, NULL, unit, NULL, 0) < 0) {
+		// set_dataset_attributes() will set the error message
+		H5Dclose(dset_id);
+		dset_id = H5I_INVALID_HID;
+		goto out;
+	}
+
+	*created = 1;
+
+out:
+	if (space_id >= 0) H5Sclose(space_id);
+	if (plist_id >= 0) H5Pclose(plist_id);
+
+	// one reference for the append file and one for the caller
+	if (dset_id >= 0 && (datasets = (AppendDataset *)realloc(append_datasets, sizeof(AppendDataset) * (n_append_datasets + 1)))) {
+		append_datasets = datasets;
+		if ((append_datasets[n_append_datasets].name = (char *)malloc(strlen(dataset_name) + 1))) {
+			strcpy(append_datasets[n_append_datasets].name, dataset_name);
+			append_datasets[n_append_datasets].dset_id = dset_id;
+			n_append_datasets++;
+			H5Iinc_ref(dset_id);
+		}
+	}
+
+	return dset_id;
+}
+
+// gets the number of elements of a dataset
+static hssize_t get_dataset_size(hid_t dset_id) {
+
+	hid_t space_id = H5Dget_space(dset_id);
+	hssize_t size = H5Sget_simple_extent_npoints(space_id);
+
+	H5Sclose(space_id);
+
+	return size;
+}
+
+// extends a 1-d dataset from start to start + nrows samples and writes column of the interleaved buffer data (ncols values per row)
+static herr_t append_samples(hid_t dset_id, hsize_t start, hsize_t nrows, hsize_t column, hsize_t ncols, const double *data) {
+
+	hid_t file_space_id = H5I_INVALID_HID;
+	hid_t mem_space_id = H5I_INVALID_HID;
+	hsize_t size = start + nrows;
+	hsize_t mem_size = nrows * ncols;
+	herr_t status = -1;
+
+	if (H5Dset_extent(dset_id, &size) < 0 ||
+		(file_space_id = H5Dget_space(dset_id)) < 0 ||
+		H5Sselect_hyperslab(file_space_id, H5S_SELECT_SET, &start, NULL, &nrows, NULL) < 0 ||
+		(mem_space_id = H5Screate_simple(1, &mem_size, NULL)) < 0 ||
+		H5Sselect_hyperslab(mem_space_id, H5S_SELECT_SET, &column, &ncols, &nrows, NULL) < 0) {
+		goto out;
+	}
+
+	status = H5Dwrite(dset_id, H5T_NATIVE_DOUBLE, mem_space_id, file_space_id, H5P_DEFAULT, data);
+
+out:
+	if (mem_space_id >= 0) H5Sclose(mem_space_id);
+	if (file_space_id >= 0) H5Sclose(file_space_id);
+
+	return status;
+}
+
+const char * ModelicaSDF_append_rows(const char *filename, const char *scale_name, const char *scale_unit, const int ndatasets, const char **dataset_names, const char **dataset_units, int nrows, const double *data) {
+
+	hid_t scale_id = H5I_INVALID_HID;
+	hid_t *dset_ids = NULL;
+	hssize_t size = 0;
+	int i, created = 0;
+
+	LOCK_HDF5();
+
+	configureMessageHandling();
+
+	set_error_message("");
+
+	if (ndatasets < 1) {
+		set_error_message("Number of datasets must be > 0");
+		goto out;
+	}
+
+	if (nrows < 0) {
+		set_error_message("Number of rows must be >= 0");
+		goto out;
+	}
+
+	// keep the file open for the following calls
+	if (!append_filename || strcmp(append_filename, filename) != 0) {
+
+		close_append_file();
+
+		if ((append_file_id = open_or_create_file(filename)) < 0) {
+			goto out;
+		}
+
+		if (!(append_filename = (char *)malloc(strlen(filename) + 1))) {
+			H5Fclose(append_file_id);
+			append_file_id = H5I_INVALID_HID;
+			set_error_message("Failed to allocate memory for '%s'", filename);
+			goto out;
+		}
+
+		strcpy(append_filename, filename);
+	}
+
+	if (!(dset_ids = (hid_t *)malloc(sizeof(hid_t) * ndatasets))) {
+		set_error_message("Failed to allocate memory for %d datasets", ndatasets);
+		goto out;
+	}
+
+	for (i = 0; i < ndatasets; i++) {
+		dset_ids[i] = H5I_INVALID_HID;
+	}
+
+	if ((scale_id = open_or_create_appendable_dataset(filename, scale_name, scale_unit, 0, &created)) < 0) {
+		goto out;
+	}
+
+	size = get_dataset_size(scale_id);
+
+	if (created && H5DSset_scale(scale_id, NULL) < 0) {
+		set_error_message("Failed to set scale on '%s'", scale_name);
+		goto out;
+	}
+
+	// check all datasets before anything is written
+	for (i = 0; i < ndatasets; i++) {
+
+		if ((dset_ids[i] = open_or_create_appendable_dataset(filename, dataset_names[i], dataset_units[i], size, &created)) < 0) {
+			goto out;
+		}
+
+		if (get_dataset_size(dset_ids[i]) != size) {
+			set_error_message("Dataset '%s' in '%s' must have the same size as the scale '%s'", dataset_names[i], filename, scale_name);
+			goto out;
+		}
+
+		// attach the scale to new datasets
+		if (created && H5DSattach_scale(dset_ids[i], scale_id, 0) < 0) {
+			set_error_message("Failed to attach scale '%s' to '%s' in '%s'", scale_name, dataset_names[i], filename);
+			goto out;
+		}
+	}
+
+	if (nrows == 0) {
 		goto out;
 	}
 
-	buffer = (double *)malloc(sizeof(double) * nsamples);
+	if (append_samples(scale_id, size, nrows, 0, ndatasets + 1, data) < 0) {
+		set_error_message("Failed to append to dataset '%s' in '%s'", scale_name, filename);
+		goto out;
+	}
+
+	for (i = 0; i < ndatasets; i++) {
+		if (append_samples(dset_ids[i], size, nrows, i + 1, ndatasets + 1, data) < 0) {
+			set_error_message("Failed to append to dataset '%s' in '%s'", dataset_names[i], filename);
+			goto out;
+		}
+	}
+
+out:
+	for (i = 0; dset_ids && i < ndatasets; i++) {
+		if (dset_ids[i] >= 0) H5Dclose(dset_ids[i]);
+	}
 
-	// iterate over the datasets
-	for (i = 0; i < ndatasets; i++) {
-		
-		if (i == 0) {
+	free(dset_ids);
 
-			first_scale_name = get_scale_name(file_id, dataset_names[i], 0);
+	if (scale_id >= 0) H5Dclose(scale_id);
 
-			if (!first_scale_name) {
-				set_error_message("Dataset '%s' in '%s' has no scale", dataset_names[i], filename);
-				goto out;
-			}
+	UNLOCK_HDF5();
 
-			// check size and unit
-			if (check_dataset_1d(file_id, first_scale_name, scale_unit, nsamples)) {
-				goto out;
-			}
-			
-			// read time from scale
-			if (H5LTread_dataset_double(file_id, first_scale_name, buffer) < 0) {
-				set_error_message("Failed to read dataset '%s' in '%s'", scale_name, filename);
-				goto out;
-			}
-		
-			// store the time
-			for (j = 0; j < nsamples; j++) {
-				data[j * (ndatasets + 1)] = buffer[j];
-			}
+	return error_message;
+}
 
-		} else {
+// the positions in the ring buffer and the failed flag are published with release / acquire semantics
+// (volatile accesses have these semantics with MSVC on x86 and x64)
+#ifdef _MSC_VER
+#define LOAD_ACQUIRE(p)         (*(volatile size_t *)(p))
+#define STORE_RELEASE(p, v)     (*(volatile size_t *)(p) = (v))
+#define LOAD_ACQUIRE_INT(p)     (*(volatile int *)(p))
+#define STORE_RELEASE_INT(p, v) (*(volatile int *)(p) = (v))
+#else
+#define LOAD_ACQUIRE(p)         __atomic_load_n(p, __ATOMIC_ACQUIRE)
+#define STORE_RELEASE(p, v)     __atomic_store_n(p, v, __ATOMIC_RELEASE)
+#define LOAD_ACQUIRE_INT(p)     LOAD_ACQUIRE(p)
+#define STORE_RELEASE_INT(p, v) STORE_RELEASE(p, v)
+#endif
+
+/* A writer that appends rows in a background thread */
+struct ModelicaSDF_Writer {
+	char *filename;					//!< the file name
+	char *scale_name;				//!< the name of the scale
+	char *scale_unit;				//!< the unit of the scale
+	int ndatasets;					//!< the number of datasets
+	char **dataset_names;			//!< the dataset names
+	char **dataset_units;			//!< the units of the datasets
+	double *rows;					//!< the ring buffer (capacity rows with ndatasets + 1 values)
+	size_t capacity;				//!< the number of rows in the ring buffer (a power of 2)
+	size_t head;					//!< the number of rows written by the producer
+	size_t tail;					//!< the number of rows appended by the worker
+	double flush_interval;			//!< the time after which the rows are appended and the file is flushed (in seconds)
+	int flush;						//!< 1 if the producer waits for the rows to be appended
+	int stop;						//!< 1 if the worker has to append the remaining rows and stop
+	int failed;						//!< 1 if an append has failed (stored with release semantics after message)
+	char message[MAX_MESSAGE_LENGTH];	//!< the error message of the failed append
+#ifdef _WIN32
+	SRWLOCK lock;
+	CONDITION_VARIABLE wake;		//!< signals the worker
+	CONDITION_VARIABLE progress;	//!< signals the producer
+	HANDLE thread;
+#else
+	pthread_mutex_t lock;
+	pthread_cond_t wake;
+	pthread_cond_t progress;
+	pthread_t thread;
+#endif
+};
+
+#ifdef _WIN32
+#define LOCK_WRITER(w)         AcquireSRWLockExclusive(&(w)->lock)
+#define UNLOCK_WRITER(w)       ReleaseSRWLockExclusive(&(w)->lock)
+#define SIGNAL(w, c)           WakeConditionVariable(&(w)->c)
+#define BROADCAST(w, c)        WakeAllConditionVariable(&(w)->c)
+#define WAIT(w, c)             SleepConditionVariableSRW(&(w)->c, &(w)->lock, INFINITE, 0)
+#else
+#define LOCK_WRITER(w)         pthread_mutex_lock(&(w)->lock)
+#define UNLOCK_WRITER(w)       pthread_mutex_unlock(&(w)->lock)
+#define SIGNAL(w, c)           pthread_cond_signal(&(w)->c)
+#define BROADCAST(w, c)        pthread_cond_broadcast(&(w)->c)
+#define WAIT(w, c)             pthread_cond_wait(&(w)->c, &(w)->lock)
+#endif
+
+// waits for the worker to be signaled or until the flush interval has elapsed (returns 1 on timeout)
+static int wait_for_rows(ModelicaSDF_Writer *writer) {
+#ifdef _WIN32
+	return !SleepConditionVariableSRW(&writer->wake, &writer->lock, (DWORD)(writer->flush_interval * 1000), 0);
+#else
+	struct timespec deadline;
+	double seconds;
+
+	clock_gettime(CLOCK_REALTIME, &deadline);
+
+	seconds = deadline.tv_nsec * 1e-9 + writer->flush_interval;
+	deadline.tv_sec += (time_t)seconds;
+	deadline.tv_nsec = (long)((seconds - (time_t)seconds) * 1e9);
+
+	return pthread_cond_timedwait(&writer->wake, &writer->lock, &deadline) != 0;
+#endif
+}
 
-			scale_name = get_scale_name(file_id, dataset_names[i], 0);
+// appends the rows [tail, head) of the ring buffer (in at most two parts)
+static void append_ring_rows(ModelicaSDF_Writer *writer, size_t tail, size_t head, int flush) {
 
-			if (!scale_name) {
-				set_error_message("Dataset '%s' in '%s' has no scale", dataset_names[i], filename);
-				goto out;
-			}
+	const size_t ncols = writer->ndatasets + 1;
+	size_t first, count;
 
-			// make sure the dataset has the same scale
-			if (strcmp(scale_name, first_scale_name)) {
-				set_error_message("Dataset '%s' in '%s' must have the same scale as the previous dataset", dataset_names[i], filename);
-				goto out;
-			}
+	LOCK_HDF5();
 
-			free(scale_name);
-		}
+	while (!writer->failed && tail < head) {
 
-		// check size and unit
-		if (check_dataset_1d(file_id, dataset_names[i], dataset_units[i], nsamples)) {
-			goto out;
-		}
+		first = tail & (writer->capacity - 1);
+		count = head - tail < writer->capacity - first ? head - tail : writer->capacity - first;
 
-		// read the data
-		if (H5LTread_dataset_double(file_id, dataset_names[i], buffer) < 0) {
-			set_error_message("Failed to read dataset '%s' in '%s'", dataset_names[i], filename);
-			goto out;
-		}
-		
-		// add the data
-		for (j = 0; j < nsamples; j++) {
-			data[j * (ndatasets + 1) + 1 + i] = buffer[j];
+		if (strlen(ModelicaSDF_append_rows(writer->filename, writer->scale_name, writer->scale_unit, writer->ndatasets,
+			(const char **)writer->dataset_names, (const char **)writer->dataset_units, (int)count, &writer->rows[first * ncols])) > 0) {
+			strcpy(writer->message, error_message);
+			STORE_RELEASE_INT(&writer->failed, 1);
 		}
 
+		tail += count;
 	}
 
-out:
+	if (flush && !writer->failed && append_filename && strcmp(append_filename, writer->filename) == 0 && H5Fflush(append_file_id, H5F_SCOPE_LOCAL) < 0) {
+		snprintf(writer->message, MAX_MESSAGE_LENGTH, "Failed to flush '%s'", writer->filename);
+		STORE_RELEASE_INT(&writer->failed, 1);
+	}
 
-	free(buffer);
-	free(first_scale_name);
+	UNLOCK_HDF5();
+}
 
-	if (file_id >= 0) H5Fclose(file_id);
+#ifdef _WIN32
+static DWORD WINAPI run_writer(LPVOID arg) {
+#else
+static void * run_writer(void *arg) {
+#endif
 
-	return error_message;
-}
+	ModelicaSDF_Writer *writer = (ModelicaSDF_Writer *)arg;
+	size_t head, tail = 0;
+	int timeout = 0, flush, flush_requested, stop_requested;
 
-const char * ModelicaSDF_create_group(const char *filename, const char *group_name, const char *comment) {
-	
-	hid_t file_id = H5I_INVALID_HID;
-	hid_t group_id = H5I_INVALID_HID;
+	LOCK_WRITER(writer);
 
-	configureMessageHandling();
-	
-	set_error_message("");
+	for (;;) {
 
-	// open the file
-	if ((file_id = open_or_create_file(filename)) < 0) {
-		goto out;
-	}
+		head = LOAD_ACQUIRE(&writer->head);
 
-	// create the group
-	if((group_id = H5Gopen2(file_id, group_name, H5P_DEFAULT)) < 0) {
-		// create the group if it does not exist
-		if((group_id = H5Gcreate2(file_id, group_name, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT)) < 0) { 
-			set_error_message("Failed to create group '%s' in '%s'", group_name, filename);
-			goto out; 
+		// wait for half a buffer, a flush, the end or the flush interval
+		if (head - tail < writer->capacity / 2 && !writer->flush && !writer->stop && !timeout) {
+			timeout = wait_for_rows(writer);
+			continue;
 		}
-	}
 
-	// set the comment
-	if(comment && strlen(comment) > 0) {
-		if(H5LTset_attribute_string(group_id, ".", COMMENT_ATTR_NAME, comment) < 0) { 
-			set_error_message("Failed to set comment for group '%s' in '%s'", group_name, filename);
+		// requests that arrive while the rows are appended are served by the next batch
+		flush_requested = writer->flush;
+		stop_requested = writer->stop;
+
+		flush = timeout || flush_requested || stop_requested;
+		timeout = 0;
+
+		UNLOCK_WRITER(writer);
+
+		append_ring_rows(writer, tail, head, flush);
+
+		LOCK_WRITER(writer);
+
+		tail = head;
+		STORE_RELEASE(&writer->tail, tail);
+
+		if (flush_requested && tail == LOAD_ACQUIRE(&writer->head)) {
+			writer->flush = 0;
+		}
+
+		BROADCAST(writer, progress);
+
+		if (stop_requested && tail == LOAD_ACQUIRE(&writer->head)) {
+			break;
 		}
 	}
 
-out:
-	if (group_id >= 0) H5Gclose(group_id);
-	if (file_id >= 0) H5Fclose(file_id);
+	UNLOCK_WRITER(writer);
 
-	return error_message;
+	return 0;
 }
 
-const char * ModelicaSDF_get_dataset_dims(const char *filename, const char *dataset_name, int dims[]) {
+static void free_writer(ModelicaSDF_Writer *writer) {
 
-	hid_t file_id = H5I_INVALID_HID;
-	H5T_class_t type_class = H5T_NO_CLASS;
-	size_t size = 0;
-	hsize_t dimsbuf[32] = {0};
-	int i = -1;
+	int i;
 
-	configureMessageHandling();
-	
-	set_error_message("");
+	if (!writer) return;
 
-	if ((file_id = H5Fopen(filename, H5F_ACC_RDONLY, H5P_DEFAULT)) < 0) {
-		set_error_message("Failed to open file '%s'", filename);
-		goto out;
+	for (i = 0; writer->dataset_names && i < writer->ndatasets; i++) {
+		free(writer->dataset_names[i]);
 	}
 
-	if (H5LTget_dataset_info(file_id, dataset_name, dimsbuf, &type_class, &size) < 0) {
-		set_error_message("Failed to open dataset '%s' in '%s'", dataset_name, filename);
-		goto out;
+	for (i = 0; writer->dataset_units && i < writer->ndatasets; i++) {
+		free(writer->dataset_units[i]);
 	}
 
-	for (i = 0; i < 32; i++) {
-		dims[i] = (int)dimsbuf[i];
-	}
+	free(writer->dataset_names);
+	free(writer->dataset_units);
+	free(writer->filename);
+	free(writer->scale_name);
+	free(writer->scale_unit);
+	free(writer->rows);
+	free(writer);
+}
 
-out:
-	if (file_id >= 0) H5Fclose(file_id);
+static char *copy_string(const char *s) {
 
-	return error_message;
+	char *copy = (char *)malloc(strlen(s) + 1);
+
+	if (copy) {
+		strcpy(copy, s);
+	}
+
+	return copy;
 }
 
-const char * ModelicaSDF_read_dataset_double(const char *filename, const char *dataset_name, const char *unit, double *buffer) {
+const char * ModelicaSDF_open_writer(const char *filename, const char *scale_name, const char *scale_unit, const int ndatasets, const char **dataset_names, const char **dataset_units, int capacity, double flush_interval, ModelicaSDF_Writer **writer) {
 
-	hid_t file_id = H5I_INVALID_HID;
+	ModelicaSDF_Writer *w = NULL;
+	size_t size = 2;
+	int i, complete;
+
+	LOCK_HDF5();
 
 	configureMessageHandling();
-	
+
 	set_error_message("");
 
-	// open the file
-	if ((file_id = H5Fopen(filename, H5F_ACC_RDONLY, H5P_DEFAULT)) < 0) {
-		set_error_message("Failed to open '%s'", filename);
+	*writer = NULL;
+
+	if (ndatasets < 1) {
+		set_error_message("Number of datasets must be > 0");
 		goto out;
 	}
 
-	// read the dataset
-	if (H5LTread_dataset_double(file_id, dataset_name, buffer) < 0) {
-		set_error_message("Failed to read double dataset '%s' from '%s'", dataset_name, filename);
+	if (capacity < 2) {
+		set_error_message("The capacity must be >= 2");
 		goto out;
 	}
 
-	// check the unit
-	if (unit != NULL && strlen(unit) > 0 && assert_string_attribute(file_id, dataset_name, UNIT_ATTR_NAME, unit) != 0) {
+	if (flush_interval <= 0) {
+		set_error_message("The flush interval must be > 0");
 		goto out;
 	}
 
-out:
-	// close the file
-	if (file_id >= 0) H5Fclose(file_id);
+	// round the capacity up to a power of 2
+	while (size < (size_t)capacity) {
+		size *= 2;
+	}
 
-	return error_message;
-}
+	if (!(w = (ModelicaSDF_Writer *)calloc(1, sizeof(ModelicaSDF_Writer)))) {
+		set_error_message("Failed to allocate memory for the writer");
+		goto out;
+	}
 
-const char * ModelicaSDF_read_dataset_int(const char *filename, const char *dataset_name, const char *unit, int *buffer) {
-	
-	hid_t file_id = H5I_INVALID_HID;
+	w->ndatasets = ndatasets;
+	w->capacity = size;
+	w->flush_interval = flush_interval;
+	w->filename = copy_string(filename);
+	w->scale_name = copy_string(scale_name);
+	w->scale_unit = copy_string(scale_unit);
+	w->dataset_names = (char **)calloc(ndatasets, sizeof(char *));
+	w->dataset_units = (char **)calloc(ndatasets, sizeof(char *));
+	w->rows = (double *)malloc(sizeof(double) * size * (ndatasets + 1));
 
-	configureMessageHandling();
-	
-	set_error_message("");
-	
-	if ((file_id = H5Fopen(filename, H5F_ACC_RDONLY, H5P_DEFAULT)) < 0) {
-		set_error_message("Failed to open '%s'", filename);
+	complete = w->filename && w->scale_name && w->scale_unit && w->dataset_names && w->dataset_units && w->rows;
+
+	for (i = 0; complete && i < ndatasets; i++) {
+		w->dataset_names[i] = copy_string(dataset_names[i]);
+		w->dataset_units[i] = copy_string(dataset_units[i]);
+		complete = w->dataset_names[i] && w->dataset_units[i];
+	}
+
+	if (!complete) {
+		set_error_message("Failed to allocate memory for the writer");
 		goto out;
 	}
 
-	if (H5LTread_dataset_int(file_id, dataset_name, buffer) < 0) {
-		set_error_message("Failed to read integer dataset '%s' from '%s'", dataset_name, filename);
+	// create the datasets
+	ModelicaSDF_append_rows(filename, scale_name, scale_unit, ndatasets, dataset_names, dataset_units, 0, w->rows);
+
+	if (strlen(error_message) > 0) {
 		goto out;
 	}
 
-	// check the unit
-	if (unit != NULL && strlen(unit) > 0 && assert_string_attribute(file_id, dataset_name, UNIT_ATTR_NAME, unit)) {
+#ifdef _WIN32
+	InitializeSRWLock(&w->lock);
+	InitializeConditionVariable(&w->wake);
+	InitializeConditionVariable(&w->progress);
+
+	if (!(w->thread = CreateThread(NULL, 0, run_writer, w, 0, NULL))) {
+		set_error_message("Failed to start the writer thread");
+		goto out;
+	}
+#else
+	pthread_mutex_init(&w->lock, NULL);
+	pthread_cond_init(&w->wake, NULL);
+	pthread_cond_init(&w->progress, NULL);
+
+	if (pthread_create(&w->thread, NULL, run_writer, w) != 0) {
+		pthread_cond_destroy(&w->progress);
+		pthread_cond_destroy(&w->wake);
+		pthread_mutex_destroy(&w->lock);
+		set_error_message("Failed to start the writer thread");
 		goto out;
 	}
+#endif
+
+	*writer = w;
+	w = NULL;
 
 out:
-	if (file_id >= 0) H5Fclose(file_id);
+	free_writer(w);
+
+	UNLOCK_HDF5();
 
 	return error_message;
 }
 
-const char * ModelicaSDF_make_dataset_double(
-	
-	const char *filename,
-	const char *dataset_name,
-	int ndims,
-	const int dims[],
-	const double *data,
-	const char *comment,
-	const char *display_name,
-	const char *unit,
-	const char *display_unit,
-	int relative_quantity) {
-
-	hid_t file_id = H5I_INVALID_HID;
-	int i = -1;
-	hsize_t dimsbuf[32] = {0};
+const char * ModelicaSDF_write_row(ModelicaSDF_Writer *writer, const double *row, int ncols) {
 
-	configureMessageHandling();
+	const size_t head = writer->head;
 
-	set_error_message("");
-	
-	for (i = 0; i < ndims; i++) {
-		dimsbuf[i] = (hsize_t)dims[i];
+	if (ncols != writer->ndatasets + 1) {
+		set_error_message("The row must have %d values but has %d", writer->ndatasets + 1, ncols);
+		return error_message;
 	}
 
-	// open the file
-	if ((file_id = open_or_create_file(filename)) < 0) {
-		goto out;
-	}
+	// wait while the buffer is full (back-pressure)
+	if (head - LOAD_ACQUIRE(&writer->tail) == writer->capacity) {
 
-	if (delete_dataset(file_id, dataset_name) < 0) {
-		// delete_dataset() will set the error message
-		goto out;
+		LOCK_WRITER(writer);
+
+		SIGNAL(writer, wake);
+
+		while (head - LOAD_ACQUIRE(&writer->tail) == writer->capacity) {
+			WAIT(writer, progress);
+		}
+
+		UNLOCK_WRITER(writer);
 	}
 
-	if (H5LTmake_dataset_double(file_id, dataset_name, ndims, dimsbuf, data) < 0) {
-		set_error_message("Failed to create dataset %s in %s", dataset_name, filename);
-		goto out;
+	if (LOAD_ACQUIRE_INT(&writer->failed)) {
+		set_error_message("%s", writer->message);
+		return error_message;
 	}
 
-	if (set_dataset_attributes(file_id, filename, dataset_name, comment, display_name, unit, display_unit, relative_quantity) < 0) {
-		// set_dataset_attributes() will set the error message
-		goto out;
+	memcpy(&writer->rows[(head & (writer->capacity - 1)) * ncols], row, sizeof(double) * ncols);
+
+	STORE_RELEASE(&writer->head, head + 1);
+
+	// wake the worker when the buffer is half full
+	if (head + 1 - LOAD_ACQUIRE(&writer->tail) == writer->capacity / 2) {
+		LOCK_WRITER(writer);
+		SIGNAL(writer, wake);
+		UNLOCK_WRITER(writer);
 	}
 
-out:
-	// close the file
-	if (file_id >= 0) H5Fclose(file_id);
+	set_error_message("");
 
 	return error_message;
 }
 
-const char *   ModelicaSDF_make_dataset_int(
-	const char *filename,
-	const char *dataset_name,
-	int ndims,
-	const int dims[],
-	const int *data,
-	const char *comment,
-	const char *display_name,
-	const char *unit,
-	const char *display_unit,
-	int relative_quantity) {
+const char * ModelicaSDF_flush_writer(ModelicaSDF_Writer *writer) {
 
-	hid_t file_id = H5I_INVALID_HID;
-	int i = -1;
-	hsize_t dimsbuf[32] = {0};
+	LOCK_WRITER(writer);
 
-	configureMessageHandling();
-	
-	set_error_message("");
+	writer->flush = 1;
 
-	for (i = 0; i < ndims; i++) {
-		dimsbuf[i] = (hsize_t)dims[i];
-	}
+	SIGNAL(writer, wake);
 
-	// open the file
-	if ((file_id = open_or_create_file(filename)) < 0) {
-		goto out;
+	while (writer->flush) {
+		WAIT(writer, progress);
 	}
 
-	if (delete_dataset(file_id, dataset_name) < 0) {
-		// delete_dataset() will set the error message
-		goto out;
+	UNLOCK_WRITER(writer);
+
+	if (LOAD_ACQUIRE_INT(&writer->failed)) {
+		set_error_message("%s", writer->message);
+	} else {
+		set_error_message("");
 	}
 
-	if (H5LTmake_dataset_int(file_id, dataset_name, ndims, dimsbuf, data) < 0) {
-		set_error_message("Failed to create dataset %s in %s", dataset_name, filename);
-		goto out;
+	return error_message;
+}
+
+const char * ModelicaSDF_close_writer(ModelicaSDF_Writer *writer) {
+
+	if (!writer) {
+		return "";
 	}
-	
-	if (set_dataset_attributes(file_id, filename, dataset_name, comment, display_name, unit, display_unit, relative_quantity) < 0) {
-		// set_dataset_attributes() will set the error message
-		goto out;
+
+	LOCK_WRITER(writer);
+
+	writer->stop = 1;
+
+	SIGNAL(writer, wake);
+
+	UNLOCK_WRITER(writer);
+
+#ifdef _WIN32
+	WaitForSingleObject(writer->thread, INFINITE);
+	CloseHandle(writer->thread);
+#else
+	pthread_join(writer->thread, NULL);
+	pthread_cond_destroy(&writer->progress);
+	pthread_cond_destroy(&writer->wake);
+	pthread_mutex_destroy(&writer->lock);
+#endif
+
+	if (LOAD_ACQUIRE_INT(&writer->failed)) {
+		set_error_message("%s", writer->message);
+	} else {
+		set_error_message("");
 	}
 
-out:
-	// close the file
-	if (file_id >= 0) H5Fclose(file_id);
+	free_writer(writer);
 
 	return error_message;
 }
@@ -774,10 +2989,16 @@ const char * ModelicaSDF_attach_scale(const char *filename, const char *dataset_
 	hid_t dset_id  = H5I_INVALID_HID;
 	hid_t scale_id = H5I_INVALID_HID;
 
+	LOCK_HDF5();
+
 	configureMessageHandling();
 
 	set_error_message("");
 
+	if (evict_file(filename) < 0) {
+		goto out;
+	}
+
 	if ((file_id = H5Fopen(filename, H5F_ACC_RDWR, H5P_DEFAULT)) < 0) {
 		set_error_message("Failed to open '%s'", dataset_name, filename);
 		goto out;
@@ -812,6 +3033,8 @@ out:
 	if (dset_id >= 0) H5Dclose(dset_id);
 	if (file_id >= 0) H5Fclose(file_id);
 
+	UNLOCK_HDF5();
+
 	return error_message;
 }
 
@@ -822,11 +3045,13 @@ const char * ModelicaSDF_get_attribute_string_length(const char *filename, const
 	H5T_class_t type_class = H5T_NO_CLASS;
 	size_t type_size = 0;
 
+	LOCK_HDF5();
+
 	configureMessageHandling();
 
 	set_error_message("");
 
-	if ((file_id = H5Fopen(filename, H5F_ACC_RDONLY, H5P_DEFAULT)) < 0) {
+	if ((file_id = open_file(filename)) < 0) {
 		set_error_message("Failed to open %s", filename);
 		goto out;
 	}
@@ -846,6 +3071,8 @@ const char * ModelicaSDF_get_attribute_string_length(const char *filename, const
 out:
 	if (file_id >= 0)  H5Fclose(file_id);
 
+	UNLOCK_HDF5();
+
 	return error_message;
 }
 
@@ -853,11 +3080,13 @@ const char * ModelicaSDF_get_attribute_string(const char *filename, const char *
 
 	hid_t file_id = H5I_INVALID_HID;
 
+	LOCK_HDF5();
+
 	configureMessageHandling();
 
 	set_error_message("");
 
-	if ((file_id = H5Fopen(filename, H5F_ACC_RDONLY, H5P_DEFAULT)) < 0) {
+	if ((file_id = open_file(filename)) < 0) {
 		set_error_message("Failed to open %s", filename);
 		goto out;
 	}
@@ -870,6 +3099,8 @@ const char * ModelicaSDF_get_attribute_string(const char *filename, const char *
 out:
 	if (file_id >= 0) H5Fclose(file_id);
 
+	UNLOCK_HDF5();
+
 	return error_message;
 }
 
@@ -877,10 +3108,16 @@ const char * ModelicaSDF_set_attribute_string(const char *filename, const char *
 	
 	hid_t file_id = H5I_INVALID_HID;
 	
+	LOCK_HDF5();
+
 	configureMessageHandling();
 
 	set_error_message("");
 
+	if (evict_file(filename) < 0) {
+		goto out;
+	}
+
 	if ((file_id = H5Fopen(filename, H5F_ACC_RDWR, H5P_DEFAULT)) < 0) {
 		set_error_message("Failed to open %s", filename);
 		goto out;
@@ -894,5 +3131,7 @@ const char * ModelicaSDF_set_attribute_string(const char *filename, const char *
 out:
 	if (file_id >= 0) H5Fclose(file_id);
 
+	UNLOCK_HDF5();
+
 	return error_message;
 }
@@ -2,7 +2,13 @@
 
 #include "ModelicaSDFFunctions.h"
 #include <string.h>
+#include <stdint.h>
+#include <sys/stat.h>
 
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 #include <vector>
 #include <string>
 
@@ -68,27 +74,43 @@ mat_t *open_mat_file(const char *filename, bool *trans) {
 
 	if (Mat_GetVersion(matfp) != MAT_FT_MAT4) {
 		set_error_message("'%s' has an unsupported MAT file version", filename);
+		Mat_Close(matfp);
 		return nullptr;
 	}
 
-
+	// only read the headers of the (large) data matrices
 	auto Aclass   = Mat_VarRead(matfp, "Aclass");
-	auto dataInfo = Mat_VarRead(matfp, "dataInfo");
-	auto name     = Mat_VarRead(matfp, "name");
-	auto desc     = Mat_VarRead(matfp, "description");
-	auto data_1   = Mat_VarRead(matfp, "data_1");
-	auto data_2   = Mat_VarRead(matfp, "data_2");
+	auto dataInfo = Mat_VarReadInfo(matfp, "dataInfo");
+	auto name     = Mat_VarReadInfo(matfp, "name");
+	auto desc     = Mat_VarReadInfo(matfp, "description");
+	auto data_1   = Mat_VarReadInfo(matfp, "data_1");
+	auto data_2   = Mat_VarReadInfo(matfp, "data_2");
+
+	const bool complete = Aclass && dataInfo && name && desc && data_1 && data_2;
+
+	vector<string> formatInfo;
+
+	if (complete) {
+		formatInfo = readStringMatrix(Aclass, false);
+	}
+
+	Mat_VarFree(Aclass);
+	Mat_VarFree(dataInfo);
+	Mat_VarFree(name);
+	Mat_VarFree(desc);
+	Mat_VarFree(data_1);
+	Mat_VarFree(data_2);
 
-	if (!Aclass || !dataInfo || !name || !desc || !data_1 || !data_2) {
+	if (!complete) {
 		set_error_message("'%s' has an unsupported file structure", filename);
+		Mat_Close(matfp);
 		return nullptr;
 	}
 
-	const auto formatInfo = readStringMatrix(Aclass, false);
-
 	// check the dsres version
-	if (formatInfo[1] != "1.1") {
+	if (formatInfo.size() < 4 || formatInfo[1] != "1.1") {
 		set_error_message("'%s' has an unsupported version", filename);
+		Mat_Close(matfp);
 		return nullptr;
 	}
 
@@ -96,6 +118,7 @@ mat_t *open_mat_file(const char *filename, bool *trans) {
 
 	if (formatType != "binTrans" && formatType != "binNormal") {
 		set_error_message("'%s' has an unsupported format", filename);
+		Mat_Close(matfp);
 		return nullptr;
 	}
 
@@ -142,150 +165,622 @@ string get_unit(const string &description) { //(const QString &description, QStr
 }
 
 
-void get_time_series_size_dsres(const char *filename, const char **dataset_names, int *size) {
+struct DsresFile {
+	mat_t *matfp;
+	bool trans;
+	string filename;
+	time_t mtime;		// the modification time and size of the file
+	long long size;		// when it was opened
+};
+
+void *open_dsres(const char *filename, int *size) {
 
-	mat_t *matfp = nullptr;
 	bool trans = false;
 
-	matfp = open_mat_file(filename, &trans);
+	auto matfp = open_mat_file(filename, &trans);
 
 	if (!matfp) {
+		return nullptr;
+	}
+
+	// the number of samples is in the header of the trajectories
+	auto data_2 = Mat_VarReadInfo(matfp, "data_2");
+
+	*size = static_cast<int>(data_2->dims[trans ? 1 : 0]);
+
+	Mat_VarFree(data_2);
+
+	struct stat file_info;
+
+	if (stat(filename, &file_info) != 0) {
+		file_info.st_mtime = 0;
+		file_info.st_size = 0;
+	}
+
+	return new DsresFile{ matfp, trans, filename, file_info.st_mtime, static_cast<long long>(file_info.st_size) };
+}
+
+void close_dsres(void *dsres) {
+
+	auto file = static_cast<DsresFile *>(dsres);
+
+	if (!file) {
 		return;
 	}
 
-	auto data_2 = Mat_VarRead(matfp, "data_2"); // trajectories
+	Mat_Close(file->matfp);
+
+	delete file;
+}
 
-	*size = data_2->dims[trans ? 1 : 0];
+typedef unique_ptr<matvar_t, decltype(&Mat_VarFree)> MatVar;
 
-	// close the file
-	Mat_Close(matfp);
+// reads the header of a variable (but not the data)
+MatVar read_info(mat_t *matfp, const char *name) {
+	return MatVar(Mat_VarReadInfo(matfp, name), &Mat_VarFree);
 }
 
+// reads a variable including the data
+MatVar read_var(mat_t *matfp, const char *name) {
+	return MatVar(Mat_VarRead(matfp, name), &Mat_VarFree);
+}
 
+// reads the samples first_sample, first_sample + stride,... (nsamples samples) of the variables [first_column, first_column + ncolumns)
+// in a data matrix (rows if trans, columns otherwise) into buffer (ncolumns values per sample if trans, nsamples values per variable otherwise)
+bool read_block(mat_t *matfp, matvar_t *matvar, bool trans, int first_column, int ncolumns, int first_sample, int nsamples, int stride, double *buffer) {
 
-void read_dsres(const char *filename, const int ndatasets, const char **dataset_names, const char **dataset_units, const char *scale_unit, int nsamples, double *data) {
+	int start[2], step[2], edge[2];
 
-	mat_t *matfp = nullptr;
-	bool trans = false;
+	if (trans) {
+		start[0] = first_column; start[1] = first_sample;
+		step[0] = 1;             step[1] = stride;
+		edge[0] = ncolumns;      edge[1] = nsamples;
+	} else {
+		start[0] = first_sample; start[1] = first_column;
+		step[0] = stride;        step[1] = 1;
+		edge[0] = nsamples;      edge[1] = ncolumns;
+	}
 
-	matfp = open_mat_file(filename, &trans);
+	return Mat_VarReadData(matfp, matvar, buffer, start, step, edge) == 0;
+}
 
-	if (!matfp) {
-		return;
+// the size of a tile in gather_transpose() (8 doubles are one cache line of the output)
+#define TILE_ROWS 64
+#define TILE_COLUMNS 8
+
+// copies the values of ntargets variables of nrows samples to the interleaved output
+// (dst[j * ncols + targets[t]] = signs[t] * src[j * row_stride + offsets[t]]) in tiles,
+// so both the source and the destination lines stay in the cache
+static void gather_transpose(const double *src, size_t row_stride, const size_t *offsets, const int *targets, const double *signs, size_t ntargets, size_t nrows, double *dst, size_t ncols) {
+
+	for (size_t j0 = 0; j0 < nrows; j0 += TILE_ROWS) {
+
+		const size_t j1 = min(j0 + TILE_ROWS, nrows);
+
+		for (size_t t0 = 0; t0 < ntargets; t0 += TILE_COLUMNS) {
+
+			const size_t t1 = min(t0 + TILE_COLUMNS, ntargets);
+
+			for (size_t j = j0; j < j1; j++) {
+
+				const double *row = src + j * row_stride;
+				double *out = dst + j * ncols;
+
+				for (size_t t = t0; t < t1; t++) {
+					out[targets[t]] = signs[t] * row[offsets[t]];
+				}
+			}
+		}
 	}
+}
+
+// maps the variable names of a result file to their index
+class DsresIndex {
+
+public:
+
+	string filename;
+	time_t mtime;
+	long long size;
+	bool trans;
+
+	MatVar info;	// dataInfo
+	MatVar desc;	// description
 
-	auto info = Mat_VarRead(matfp, "dataInfo");
-	auto name = Mat_VarRead(matfp, "name");
-	auto desc = Mat_VarRead(matfp, "description");
+	DsresIndex(const DsresFile *file, MatVar info, MatVar name, MatVar desc) : 
+		filename(file->filename), mtime(file->mtime), size(file->size), trans(file->trans), info(std::move(info)), desc(std::move(desc)) {
 
-	auto info_data = static_cast<const double *>(info->data);
+		// copy the names into one contiguous buffer
+		const size_t m = name->dims[0];
+		const size_t n = name->dims[1];
+		auto data = static_cast<const char *>(name->data);
 
-	auto data_1 = Mat_VarRead(matfp, "data_1"); // constants
-	auto data_1_info = Mat_VarReadInfo(matfp, "data_1");
+		nvars = trans ? n : m;
+		name_length = trans ? m : n;
 
-	auto data_2 = Mat_VarRead(matfp, "data_2"); // trajectories
-	auto data_2_info = Mat_VarReadInfo(matfp, "data_2");
+		names.resize(nvars * name_length);
+		lengths.resize(nvars);
 
-	auto names = readStringMatrix(name, trans);
-	auto descr = readStringMatrix(desc, trans);
+		for (size_t i = 0; i < nvars; i++) {
 
-	vector<string> var_names;
+			char *dst = &names[i * name_length];
+
+			for (size_t j = 0; j < name_length; j++) {
+				dst[j] = trans ? data[i * m + j] : data[j * m + i];
+			}
+
+			lengths[i] = trimmed_length(dst, name_length);
+		}
+
+		// build the open addressing hash table (load factor <= 0.5)
+		size_t capacity = 16;
+
+		while (capacity < 2 * nvars) {
+			capacity *= 2;
+		}
+
+		slots.assign(capacity, -1);
+
+		for (size_t i = 0; i < nvars; i++) {
+
+			size_t slot = hash(&names[i * name_length], lengths[i]) & (capacity - 1);
+
+			// keep the first variable with a given name
+			while (slots[slot] >= 0 && !equal(static_cast<size_t>(slots[slot]), &names[i * name_length], lengths[i])) {
+				slot = (slot + 1) & (capacity - 1);
+			}
+
+			if (slots[slot] < 0) {
+				slots[slot] = static_cast<int>(i);
+			}
+		}
 
-	// convert names to paths
-	for (auto name : names) {
-		auto var_name = name;
-		std::replace(var_name.begin(), var_name.end(), '.', '/');
-		var_names.push_back('/' + var_name);
+		// count the distinct columns
+		vector<bool> used[2];
+
+		ncolumns = 0;
+
+		for (size_t k = 0; k < nvars; k++) {
+
+			int block, column, sign;
+
+			location(k, &block, &column, &sign);
+
+			if (block < 1 || block > 2 || column < 0) {
+				continue;
+			}
+
+			auto &u = used[block - 1];
+
+			if (static_cast<size_t>(column) >= u.size()) {
+				u.resize(column + 1, false);
+			}
+
+			if (!u[column]) {
+				u[column] = true;
+				ncolumns++;
+			}
+		}
 	}
 
+	// returns the index of the variable with the given path (e.g. "/a/b" for "a.b") or -1 if there is none
+	int find(const char *path) const {
+
+		if (path[0] != '/') {
+			return -1;
+		}
+
+		// search for the name with '.' converted to '/'
+		const char *key = path + 1;
+		const size_t len = strlen(key);
+		const size_t mask = slots.size() - 1;
 
-	// TODO: check nsamples == data_2->dims[1]
-	//auto nsamples = data_2->dims[1];
+		for (size_t slot = hash_path(key, len) & mask; slots[slot] >= 0; slot = (slot + 1) & mask) {
+			if (matches(static_cast<size_t>(slots[slot]), key, len)) {
+				return slots[slot];
+			}
+		}
+
+		return -1;
+	}
 
-	// store the time
-	for (int j = 0; j < nsamples; j++) {
+	// gets the data block (1: constants, 2: trajectories), the column (0-based) and the sign of a variable
+	void location(size_t k, int *block, int *column, int *sign) const {
 
-		double v;
+		auto info_data = static_cast<const double *>(info->data);
+		int x;
 
 		if (trans) {
-			v = static_cast<double *>(data_2->data)[j * data_2->dims[0]];
+			*block = static_cast<int>(info_data[k * info->dims[0]]);
+			x = static_cast<int>(info_data[k * info->dims[0] + 1]);
 		} else {
-			v = static_cast<double *>(data_2->data)[j];
+			*block = static_cast<int>(info_data[k]);
+			x = static_cast<int>(info_data[info->dims[0] + k]);
 		}
 
-		// check unit
-		if (strlen(scale_unit) > 0) {
-			auto unit = get_unit(descr[0]);
-			if (unit != scale_unit) {
-				set_error_message("The scale in '%s' has the wrong unit. Expected '%s' but was '%s'.", filename, scale_unit, unit.c_str());
-				return;
+		*column = abs(x) - 1;
+		*sign = x < 0 ? -1 : 1;
+	}
+
+	// the number of variables
+	size_t variables() const { return nvars; }
+
+	// the number of distinct columns in data_1 and data_2 (i.e. the number of variables without aliases)
+	size_t columns() const { return ncolumns; }
+
+	// returns the description of the variable with the given index
+	string description(size_t k) const {
+
+		const size_t m = desc->dims[0];
+		const size_t n = desc->dims[1];
+		auto data = static_cast<const char *>(desc->data);
+
+		string s;
+
+		if (trans) {
+			s.assign(&data[k * m], m);
+		} else {
+			for (size_t j = 0; j < n; j++) {
+				s.push_back(data[j * m + k]);
 			}
 		}
 
-		data[j * (ndatasets + 1)] = v;
+		s.resize(trimmed_length(s.data(), s.size()));
+
+		return s;
 	}
 
-	for (int i = 0; i < ndatasets; i++) {
+private:
 
-		int k = -1;
+	size_t nvars;
+	size_t ncolumns;
+	size_t name_length;
+	vector<char> names;
+	vector<uint32_t> lengths;
+	vector<int> slots;
 
-		string var_name = dataset_names[i];
+	static size_t trimmed_length(const char *s, size_t n) {
 
-		// find the index
-		for (int j = 0; j < var_names.size(); j++) {
-			if (var_names[j] == var_name) {
-				k = j;
-				break;
+		size_t len = 0;
+
+		// stop at the first '\0' and drop trailing white space
+		while (len < n && s[len] != '\0') {
+			len++;
+		}
+
+		while (len > 0 && isspace(static_cast<unsigned char>(s[len - 1]))) {
+			len--;
+		}
+
+		return len;
+	}
+
+	// FNV-1a of a name as a path ('.' is hashed as '/')
+	static size_t hash(const char *s, size_t n) {
+
+		uint32_t h = 2166136261u;
+
+		for (size_t i = 0; i < n; i++) {
+			h ^= static_cast<unsigned char>(s[i] == '.' ? '/' : s[i]);
+			h *= 16777619u;
+		}
+
+		return h;
+	}
+
+	static size_t hash_path(const char *s, size_t n) {
+
+		uint32_t h = 2166136261u;
+
+		for (size_t i = 0; i < n; i++) {
+			h ^= static_cast<unsigned char>(s[i]);
+			h *= 16777619u;
+		}
+
+		return h;
+	}
+
+	bool equal(size_t k, const char *s, size_t n) const {
+		return lengths[k] == n && memcmp(&names[k * name_length], s, n) == 0;
+	}
+
+	bool matches(size_t k, const char *path, size_t n) const {
+
+		if (lengths[k] != n) {
+			return false;
+		}
+
+		const char *name = &names[k * name_length];
+
+		for (size_t i = 0; i < n; i++) {
+			if ((name[i] == '.' ? '/' : name[i]) != path[i]) {
+				return false;
 			}
 		}
 
+		return true;
+	}
+};
+
+// the indices of the recently read files
+static list<shared_ptr<const DsresIndex>> dsres_indices;
+
+// dsres files are read without the HDF5 lock, so concurrent reads synchronize the access to dsres_indices with this lock
+static mutex dsres_indices_lock;
+
+#define MAX_DSRES_INDICES 4
+
+// the number of values that are read at once when reading trajectories
+#define DSRES_BUFFER_SIZE (1 << 19)
+
+// gets the index of the file from the cache or builds it
+shared_ptr<const DsresIndex> get_index(DsresFile *file) {
+
+	{
+		lock_guard<mutex> guard(dsres_indices_lock);
+
+		for (auto it = dsres_indices.begin(); it != dsres_indices.end(); it++) {
+			auto index = *it;
+			if (index->filename == file->filename && index->mtime == file->mtime && index->size == file->size && index->trans == file->trans) {
+				// move to the front
+				dsres_indices.erase(it);
+				dsres_indices.push_front(index);
+				return index;
+			}
+		}
+	}
+
+	// the index is built without the lock (concurrent readers of the same file may build it twice)
+	auto info = read_var(file->matfp, "dataInfo");
+	auto name = read_var(file->matfp, "name");
+	auto desc = read_var(file->matfp, "description");
+
+	if (!info || !name || !desc) {
+		return nullptr;
+	}
+
+	auto index = make_shared<const DsresIndex>(file, std::move(info), std::move(name), std::move(desc));
+
+	lock_guard<mutex> guard(dsres_indices_lock);
+
+	dsres_indices.push_front(index);
+
+	if (dsres_indices.size() > MAX_DSRES_INDICES) {
+		dsres_indices.pop_back();
+	}
+
+	return index;
+}
+
+// the location of a requested variable
+struct Location {
+	int block;	// 1: constants, 2: trajectories
+	int column;	// 0-based column in the data block
+	int sign;	// -1 for negated aliases, 1 otherwise
+};
+
+// finds the requested variables, checks their units (if dataset_units != nullptr) and gets their locations
+bool resolve(const DsresIndex &index, const char *filename, const int ndatasets, const char **dataset_names, const char **dataset_units, vector<Location> &locations) {
+
+	locations.resize(ndatasets);
+
+	for (int i = 0; i < ndatasets; i++) {
+
+		const char *var_name = dataset_names[i];
+
+		// find the index
+		const int k = index.find(var_name);
+
 		if (k < 0) {
-			set_error_message("Variable '%s' was not found in '%s'", var_name.c_str(), filename);
-			return;
+			set_error_message("Variable '%s' was not found in '%s'", var_name, filename);
+			return false;
 		}
 
 		// check unit
-		if (strlen(dataset_units[i]) > 0) {
-			auto unit = get_unit(descr[k]);
+		if (dataset_units && strlen(dataset_units[i]) > 0) {
+			auto unit = get_unit(index.description(k));
 			if (unit != dataset_units[i]) {
 				set_error_message("Variable '%s' in '%s' has the wrong unit. Expected '%s' but was '%s'.", 
-					var_name.c_str(), filename, dataset_units[i], unit.c_str());
-				return;
+					var_name, filename, dataset_units[i], unit.c_str());
+				return false;
 			}
 		}
 
-		int d; // data block
-		int x;
+		index.location(k, &locations[i].block, &locations[i].column, &locations[i].sign);
+	}
 
-		if (trans) {
-			d = info_data[k * info->dims[0]];
-			x = info_data[k * info->dims[0] + 1];
+	return true;
+}
+
+// a key for a column in a data block
+static long long column_key(const Location &location) {
+	return (static_cast<long long>(location.block) << 32) | static_cast<unsigned int>(location.column);
+}
+
+void get_dsres_aliases(void *dsres, const char *filename, const int ndatasets, const char **dataset_names, int *aliases, int *nvariables, int *ncolumns) {
+
+	auto file = static_cast<DsresFile *>(dsres);
+
+	auto index = get_index(file);
+
+	if (!index) {
+		set_error_message("'%s' has an unsupported file structure", filename);
+		return;
+	}
+
+	vector<Location> locations;
+
+	if (!resolve(*index, filename, ndatasets, dataset_names, nullptr, locations)) {
+		return;
+	}
+
+	unordered_map<long long, int> first;
+
+	for (int i = 0; i < ndatasets; i++) {
+		auto it = first.emplace(column_key(locations[i]), i).first;
+		const int j = it->second;
+		aliases[i] = (j + 1) * locations[i].sign * locations[j].sign;
+	}
+
+	*nvariables = static_cast<int>(index->variables());
+	*ncolumns = static_cast<int>(index->columns());
+}
+
+int read_dsres_time(void *dsres, int index, double *time) {
+
+	auto file = static_cast<DsresFile *>(dsres);
+
+	auto data_2 = read_info(file->matfp, "data_2");
+
+	return data_2 && read_block(file->matfp, data_2.get(), file->trans, 0, 1, index, 1, 1, time) ? 0 : -1;
+}
+
+void read_dsres(void *dsres, const char *filename, const int ndatasets, const char **dataset_names, const char **dataset_units, const char *scale_unit, int start, int nsamples, int stride, double *data) {
+
+	auto file = static_cast<DsresFile *>(dsres);
+	auto matfp = file->matfp;
+	auto trans = file->trans;
+
+	auto index = get_index(file);
+
+	auto data_1 = read_var(matfp, "data_1");   // constants (small)
+	auto data_2 = read_info(matfp, "data_2");  // trajectories (only the requested values are read)
+
+	if (!index || !data_1 || !data_2) {
+		set_error_message("'%s' has an unsupported file structure", filename);
+		return;
+	}
+
+	const int available = static_cast<int>(data_2->dims[trans ? 1 : 0]);
+
+	if (start + static_cast<long long>(nsamples - 1) * stride >= available) {
+		set_error_message("'%s' has only %d samples but %lld were requested", filename, available, start + static_cast<long long>(nsamples - 1) * stride + 1);
+		return;
+	}
+
+	// check unit
+	if (strlen(scale_unit) > 0) {
+		auto unit = get_unit(index->description(0));
+		if (unit != scale_unit) {
+			set_error_message("The scale in '%s' has the wrong unit. Expected '%s' but was '%s'.", filename, scale_unit, unit.c_str());
+			return;
+		}
+	}
+
+	vector<Location> locations;
+
+	if (!resolve(*index, filename, ndatasets, dataset_names, dataset_units, locations)) {
+		return;
+	}
+
+	const size_t ncols = ndatasets + 1;
+
+	// a requested trajectory (or the time)
+	struct Target {
+		int column;		// column in data_2
+		int output;		// column in data
+		double sign;
+		const char *name;
+	};
+
+	vector<Target> targets = { { 0, 0, 1.0, nullptr } };
+
+	for (int i = 0; i < ndatasets; i++) {
+
+		const auto &location = locations[i];
+
+		if (location.block == 1) {
+
+			// constants are only stored once
+			const double v = location.sign * static_cast<double *>(data_1->data)[trans ? location.column : (location.column * data_1->dims[0])];
+
+			for (int j = 0; j < nsamples; j++) {
+				data[j * ncols + i + 1] = v;
+			}
+
+		} else if (location.block == 2) {
+			targets.push_back({ location.column, i + 1, static_cast<double>(location.sign), dataset_names[i] });
 		} else {
-			d = info_data[k];
-			x = info_data[info->dims[0] + k];
+			set_error_message("Unexpected data block");
+			return;
 		}
+	}
+
+	// read the columns in the order they are stored
+	stable_sort(targets.begin(), targets.end(), [](const Target &a, const Target &b) { return a.column < b.column; });
 
-		int c = abs(x) - 1;     // column
-		int s = x < 0 ? -1 : 1; // sign
+	// the number of columns that fit into the buffer
+	const size_t max_columns = max<size_t>(1, DSRES_BUFFER_SIZE / max(nsamples, 1));
 
-		// store the trajectory
-		for (int j = 0; j < nsamples; j++) {
+	vector<double> buffer;
+	vector<size_t> offsets;
+	vector<int> outputs;
+	vector<double> signs;
 
-			double v;
+	for (size_t first = 0; first < targets.size();) {
+
+		// collect the targets of the next max_columns distinct columns (aliases share a column)
+		size_t last = first, ncolumns = 0;
+
+		while (last < targets.size() && (ncolumns < max_columns || targets[last].column == targets[last - 1].column)) {
+			if (last == first || targets[last].column != targets[last - 1].column) {
+				ncolumns++;
+			}
+			last++;
+		}
 
-			if (d == 1) {
-				v = static_cast<double *>(data_1->data)[trans ? c : (c * data_1->dims[0])];
-			} else if (d == 2) {
-				v = static_cast<double *>(data_2->data)[trans ? (j * data_2->dims[0] + c) : (c * data_2->dims[0] + j)];
+		const int first_column = targets[first].column;
+		const int span = targets[last - 1].column - first_column + 1;
+
+		// read the whole range if it's dense enough, otherwise read the columns one by one
+		const bool dense = static_cast<size_t>(span) <= 2 * ncolumns;
+
+		buffer.resize((dense ? span : ncolumns) * static_cast<size_t>(nsamples));
+		offsets.clear();
+		outputs.clear();
+		signs.clear();
+
+		size_t failed = last;
+
+		for (size_t t = first, k = 0; t < last; t++) {
+
+			const auto &target = targets[t];
+
+			if (t > first && target.column != targets[t - 1].column) {
+				k++;
+			}
+
+			if (!dense && (t == first || target.column != targets[t - 1].column) &&
+				!read_block(matfp, data_2.get(), trans, target.column, 1, start, nsamples, stride, &buffer[k * nsamples])) {
+				failed = t;
+				break;
+			}
+
+			const size_t c = dense ? target.column - first_column : k;
+
+			// the layout of the buffer of a dense range in a transposed matrix is sample by sample
+			offsets.push_back(dense && trans ? c : c * nsamples);
+			outputs.push_back(target.output);
+			signs.push_back(target.sign);
+		}
+
+		if (dense && !read_block(matfp, data_2.get(), trans, first_column, span, start, nsamples, stride, buffer.data())) {
+			failed = first;
+		}
+
+		if (failed < last) {
+
+			if (targets[failed].name) {
+				set_error_message("Failed to read variable '%s' in '%s'", targets[failed].name, filename);
 			} else {
-				set_error_message("Unexpected data block");
-				return;
+				set_error_message("Failed to read the time in '%s'", filename);
 			}
 
-			data[j * (ndatasets + 1) + i + 1] = v * s;			 
+			return;
 		}
-	}
 
-	// close the file
-	Mat_Close(matfp);
+		gather_transpose(buffer.data(), dense && trans ? span : 1, offsets.data(), outputs.data(), signs.data(), outputs.size(), nsamples, data, ncols);
+
+		first = last;
+	}
 }
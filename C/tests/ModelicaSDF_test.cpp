@@ -8,11 +8,28 @@
 
 using namespace Catch::Matchers;
 
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/stat.h>
+
+#include "hdf5.h"
+#include "hdf5_hl.h"
+
 #ifndef _WIN32
 #include <dlfcn.h>
+#include <utime.h>
 #define HMODULE void*
 #else
 #include <Windows.h>
+#include <sys/utime.h>
 #endif
 
 template<typename T> T *get(HMODULE libraryHandle, const char *functionName) {
@@ -287,6 +304,13 @@ TEST_CASE("read from and write to an SDF file", "[functions]") {
 			check_data(data);
 		}
 
+		SECTION("with too many samples") {
+			const char *fname = TESTS_DIR "DoublePendulum_Dymola-2012.mat";
+
+			const char *message = read_time_series(fname, 2, dataset_names, dataset_units, scale_unit, 503, reinterpret_cast<double *>(data));
+			REQUIRE_THAT(message, Equals("'" TESTS_DIR "DoublePendulum_Dymola-2012.mat' has only 502 samples but 503 were requested"));
+		}
+
 		SECTION("Dymola 2012 (Save as)") {
 			const char *fname = TESTS_DIR "DoublePendulum_Dymola-2012-SaveAs.mat";
 
@@ -331,3 +355,2005 @@ TEST_CASE("read from and write to an SDF file", "[functions]") {
 # endif
 
 }
+
+
+// writes a 3x2 table /T with the scales /X and /Y
+void make_table(HMODULE l, const char *filename) {
+
+	auto make_dataset_double = get<ModelicaSDF_make_dataset_double> (l, "ModelicaSDF_make_dataset_double");
+	auto attach_scale        = get<ModelicaSDF_attach_scale>        (l, "ModelicaSDF_attach_scale");
+
+	int x_dims[1] = { 3 };
+	double x_data[3] = { 1, 2, 3 };
+
+	int y_dims[1] = { 2 };
+	double y_data[2] = { 10, 20 };
+
+	int t_dims[2] = { 3, 2 };
+	double t_data[3][2] = { { 1.1, 1.2 }, { 2.1, 2.2 }, { 3.1, 3.2 } };
+
+	remove(filename);
+
+	CHECK_THAT(make_dataset_double(filename, "/X", 1, x_dims, x_data, "", "", "m", "", 0), Equals(""));
+	CHECK_THAT(make_dataset_double(filename, "/Y", 1, y_dims, y_data, "", "", "s", "", 0), Equals(""));
+	CHECK_THAT(make_dataset_double(filename, "/T", 2, t_dims, reinterpret_cast<double *>(t_data), "", "", "K", "", 0), Equals(""));
+	CHECK_THAT(attach_scale(filename, "/T", "/X", "x", 0), Equals(""));
+	CHECK_THAT(attach_scale(filename, "/T", "/Y", "y", 1), Equals(""));
+}
+
+
+long file_size(const char *filename) {
+
+	FILE *f = fopen(filename, "rb");
+
+	if (!f) {
+		return -1;
+	}
+
+	fseek(f, 0, SEEK_END);
+	const long size = ftell(f);
+	fclose(f);
+
+	return size;
+}
+
+TEST_CASE("write chunked datasets", "[functions]") {
+
+	// load the shared library
+# ifdef _WIN32
+	auto l = LoadLibraryA(SHARED_LIBRARY_PATH);
+# else
+	auto l = dlopen(SHARED_LIBRARY_PATH, RTLD_LAZY);
+# endif
+
+	REQUIRE(l != nullptr);
+
+	auto make_dataset_double         = get<ModelicaSDF_make_dataset_double>         (l, "ModelicaSDF_make_dataset_double");
+	auto make_chunked_dataset_double = get<ModelicaSDF_make_chunked_dataset_double> (l, "ModelicaSDF_make_chunked_dataset_double");
+	auto make_chunked_dataset_int    = get<ModelicaSDF_make_chunked_dataset_int>    (l, "ModelicaSDF_make_chunked_dataset_int");
+	auto read_dataset_double         = get<ModelicaSDF_read_dataset_double>         (l, "ModelicaSDF_read_dataset_double");
+	auto read_dataset_int            = get<ModelicaSDF_read_dataset_int>            (l, "ModelicaSDF_read_dataset_int");
+	auto close_files                 = get<ModelicaSDF_close_files>                 (l, "ModelicaSDF_close_files");
+
+	const auto filename = TESTS_DIR "chunked.sdf";
+
+	// a smooth signal that compresses well
+	int dims[2] = { 1000, 50 };
+	std::vector<double> values(1000 * 50);
+	std::vector<int> counts(1000 * 50);
+
+	for (size_t i = 0; i < values.size(); i++) {
+		values[i] = static_cast<double>(i / 50);
+		counts[i] = 1000 + static_cast<int>(i % 50);
+	}
+
+	remove(filename);
+
+	SECTION("round trip") {
+
+		int chunk_dims[2] = { 100, 10 };
+		std::vector<double> double_buf(values.size());
+		std::vector<int> int_buf(counts.size());
+
+		CHECK_THAT(make_chunked_dataset_double(filename, "/auto", 2, dims, values.data(), "Comment", "", "m", "", 0, nullptr, 4, 1), Equals(""));
+		CHECK_THAT(read_dataset_double(filename, "/auto", "m", double_buf.data()), Equals(""));
+		CHECK(double_buf == values);
+
+		CHECK_THAT(make_chunked_dataset_double(filename, "/chunks", 2, dims, values.data(), "", "", "", "", 0, chunk_dims, 0, 0), Equals(""));
+		CHECK_THAT(read_dataset_double(filename, "/chunks", "", double_buf.data()), Equals(""));
+		CHECK(double_buf == values);
+
+		CHECK_THAT(make_chunked_dataset_int(filename, "/counts", 2, dims, counts.data(), "", "", "", "", 0, chunk_dims, 1, 1, 1), Equals(""));
+		CHECK_THAT(read_dataset_int(filename, "/counts", "", int_buf.data()), Equals(""));
+		CHECK(int_buf == counts);
+	}
+
+	SECTION("compression") {
+
+		const auto contiguous = TESTS_DIR "contiguous.sdf";
+
+		remove(contiguous);
+
+		CHECK_THAT(make_dataset_double(contiguous, "/values", 2, dims, values.data(), "", "", "", "", 0), Equals(""));
+		CHECK_THAT(make_chunked_dataset_double(filename, "/values", 2, dims, values.data(), "", "", "", "", 0, nullptr, 4, 1), Equals(""));
+
+		close_files();
+
+		CHECK(file_size(filename) * 10 < file_size(contiguous));
+
+		remove(contiguous);
+	}
+
+	SECTION("invalid arguments") {
+
+		int chunk_dims[2] = { 10, 0 };
+
+		CHECK_THAT(make_chunked_dataset_double(filename, "/values", 0, dims, values.data(), "", "", "", "", 0, nullptr, 4, 1), Equals("Chunked datasets must have 1 to 32 dimensions"));
+		CHECK_THAT(make_chunked_dataset_double(filename, "/values", 2, dims, values.data(), "", "", "", "", 0, nullptr, 10, 1), Equals("The deflate level must be in the range [0, 9]"));
+		CHECK_THAT(make_chunked_dataset_double(filename, "/values", 2, dims, values.data(), "", "", "", "", 0, chunk_dims, 4, 1), Equals("The chunk dimensions must be > 0"));
+	}
+
+	close_files();
+
+	remove(filename);
+}
+
+TEST_CASE("benchmark write chunked datasets", "[.][benchmark]") {
+
+# ifdef _WIN32
+	auto l = LoadLibraryA(SHARED_LIBRARY_PATH);
+# else
+	auto l = dlopen(SHARED_LIBRARY_PATH, RTLD_LAZY);
+# endif
+
+	REQUIRE(l != nullptr);
+
+	auto make_dataset_double         = get<ModelicaSDF_make_dataset_double>         (l, "ModelicaSDF_make_dataset_double");
+	auto make_chunked_dataset_double = get<ModelicaSDF_make_chunked_dataset_double> (l, "ModelicaSDF_make_chunked_dataset_double");
+	auto close_files                 = get<ModelicaSDF_close_files>                 (l, "ModelicaSDF_close_files");
+
+	const auto filename = TESTS_DIR "chunked.sdf";
+
+	// 20000 samples of 100 signals (16 MB) with noise in the lower bits
+	int dims[2] = { 20000, 100 };
+	std::vector<double> values(static_cast<size_t>(dims[0]) * dims[1]);
+
+	for (size_t i = 0; i < values.size(); i++) {
+		const double t = 1e-3 * (i / dims[1]);
+		values[i] = sin(t * (1 + i % dims[1])) + 1e-9 * static_cast<double>((i * 7919) % 1000);
+	}
+
+	struct Setting {
+		const char *name;
+		int deflate_level;
+		int shuffle;
+	};
+
+	for (auto setting : { Setting{ "chunked", 0, 0 }, Setting{ "deflate 1", 1, 0 }, Setting{ "shuffle, deflate 1", 1, 1 }, Setting{ "shuffle, deflate 6", 6, 1 } }) {
+
+		BENCHMARK(std::string("write 16 MB, ") + setting.name) {
+			return make_chunked_dataset_double(filename, "/values", 2, dims, values.data(), "", "", "", "", 0, nullptr, setting.deflate_level, setting.shuffle);
+		};
+
+		close_files();
+
+		WARN(setting.name << ": " << file_size(filename) << " bytes");
+	}
+
+	BENCHMARK("write 16 MB, contiguous") {
+		return make_dataset_double(filename, "/values", 2, dims, values.data(), "", "", "", "", 0);
+	};
+
+	close_files();
+
+	WARN("contiguous: " << file_size(filename) << " bytes");
+
+	remove(filename);
+}
+
+TEST_CASE("append rows", "[functions]") {
+
+	// load the shared library
+# ifdef _WIN32
+	auto l = LoadLibraryA(SHARED_LIBRARY_PATH);
+# else
+	auto l = dlopen(SHARED_LIBRARY_PATH, RTLD_LAZY);
+# endif
+
+	REQUIRE(l != nullptr);
+
+	auto append_rows          = get<ModelicaSDF_append_rows>          (l, "ModelicaSDF_append_rows");
+	auto get_time_series_size = get<ModelicaSDF_get_time_series_size> (l, "ModelicaSDF_get_time_series_size");
+	auto read_time_series     = get<ModelicaSDF_read_time_series>     (l, "ModelicaSDF_read_time_series");
+	auto make_dataset_double  = get<ModelicaSDF_make_dataset_double>  (l, "ModelicaSDF_make_dataset_double");
+	auto close_files          = get<ModelicaSDF_close_files>          (l, "ModelicaSDF_close_files");
+
+	const auto filename = TESTS_DIR "append.sdf";
+
+	remove(filename);
+
+	const char *names[2] = { "/x", "/y" };
+	const char *units[2] = { "m", "" };
+
+	double rows1[3][3] = { { 0, 1, 10 }, { 1, 2, 20 }, { 2, 3, 30 } };
+	double rows2[2][3] = { { 3, 4, 40 }, { 4, 5, 50 } };
+
+	REQUIRE_THAT(append_rows(filename, "/time", "s", 2, names, units, 3, &rows1[0][0]), Equals(""));
+	REQUIRE_THAT(append_rows(filename, "/time", "s", 2, names, units, 2, &rows2[0][0]), Equals(""));
+
+	int size = 0;
+	double data[5][3] = { 0 };
+
+	// read while the file is open for appending
+	REQUIRE_THAT(get_time_series_size(filename, names, &size), Equals(""));
+	REQUIRE(size == 5);
+	REQUIRE_THAT(read_time_series(filename, 2, names, units, "s", size, &data[0][0]), Equals(""));
+
+	for (int j = 0; j < 5; j++) {
+		CHECK(data[j][0] == j);
+		CHECK(data[j][1] == j + 1);
+		CHECK(data[j][2] == 10 * (j + 1));
+	}
+
+	// a dataset that is added later is filled with NaN
+	const char *xz_names[2] = { "/x", "/z" };
+	double rows3[1][3] = { { 5, 6, -1 } };
+
+	REQUIRE_THAT(append_rows(filename, "/time", "s", 2, xz_names, units, 1, &rows3[0][0]), Equals(""));
+
+	double z[6][2] = { 0 };
+	const char *z_names[1] = { "/z" };
+	const char *z_units[1] = { "" };
+
+	REQUIRE_THAT(read_time_series(filename, 1, z_names, z_units, "s", 6, &z[0][0]), Equals(""));
+	CHECK(std::isnan(z[4][1]));
+	CHECK(z[5][0] == 5);
+	CHECK(z[5][1] == -1);
+
+	// "/y" has not been appended
+	CHECK_THAT(append_rows(filename, "/time", "s", 2, names, units, 1, &rows3[0][0]), Equals("Dataset '/y' in '" TESTS_DIR "append.sdf' must have the same size as the scale '/time'"));
+
+	// other writes close the file
+	int dims[1] = { 1 };
+	double value = 1;
+
+	CHECK_THAT(make_dataset_double(filename, "/value", 1, dims, &value, "", "", "", "", 0), Equals(""));
+	CHECK_THAT(append_rows(filename, "/time", "s", 2, xz_names, units, 1, &rows3[0][0]), Equals(""));
+
+	// a fixed size dataset can't be appended
+	CHECK_THAT(append_rows(filename, "/value", "s", 2, xz_names, units, 1, &rows3[0][0]), Equals("Dataset '/value' in '" TESTS_DIR "append.sdf' is not an appendable one-dimensional dataset"));
+
+	close_files();
+
+	remove(filename);
+}
+
+TEST_CASE("benchmark append rows", "[.][benchmark]") {
+
+# ifdef _WIN32
+	auto l = LoadLibraryA(SHARED_LIBRARY_PATH);
+# else
+	auto l = dlopen(SHARED_LIBRARY_PATH, RTLD_LAZY);
+# endif
+
+	REQUIRE(l != nullptr);
+
+	auto append_rows         = get<ModelicaSDF_append_rows>         (l, "ModelicaSDF_append_rows");
+	auto make_dataset_double = get<ModelicaSDF_make_dataset_double> (l, "ModelicaSDF_make_dataset_double");
+	auto close_files         = get<ModelicaSDF_close_files>         (l, "ModelicaSDF_close_files");
+
+	const auto filename = TESTS_DIR "append.sdf";
+
+	// 10 signals, batches of 100 rows on top of 100000 rows
+	const int nsignals = 10, nrows = 100, nexisting = 100000;
+
+	std::vector<std::string> names;
+	std::vector<const char *> name_ptrs, unit_ptrs;
+
+	for (int i = 0; i < nsignals; i++) {
+		names.push_back("/s" + std::to_string(i));
+	}
+
+	for (auto &name : names) {
+		name_ptrs.push_back(name.c_str());
+		unit_ptrs.push_back("");
+	}
+
+	std::vector<double> rows(static_cast<size_t>(nexisting) * (nsignals + 1), 1.0);
+
+	remove(filename);
+
+	REQUIRE_THAT(append_rows(filename, "/time", "s", nsignals, name_ptrs.data(), unit_ptrs.data(), nexisting, rows.data()), Equals(""));
+
+	BENCHMARK("append 100 rows") {
+		return append_rows(filename, "/time", "s", nsignals, name_ptrs.data(), unit_ptrs.data(), nrows, rows.data());
+	};
+
+	close_files();
+
+	int dims[2] = { nexisting, nsignals + 1 };
+
+	BENCHMARK("rewrite 100000 rows") {
+		return make_dataset_double(filename, "/table", 2, dims, rows.data(), "", "", "", "", 0);
+	};
+
+	close_files();
+
+	remove(filename);
+}
+
+TEST_CASE("buffered writer", "[functions]") {
+
+	// load the shared library
+# ifdef _WIN32
+	auto l = LoadLibraryA(SHARED_LIBRARY_PATH);
+# else
+	auto l = dlopen(SHARED_LIBRARY_PATH, RTLD_LAZY);
+# endif
+
+	REQUIRE(l != nullptr);
+
+	auto open_writer          = get<ModelicaSDF_open_writer>          (l, "ModelicaSDF_open_writer");
+	auto write_row            = get<ModelicaSDF_write_row>            (l, "ModelicaSDF_write_row");
+	auto flush_writer         = get<ModelicaSDF_flush_writer>         (l, "ModelicaSDF_flush_writer");
+	auto close_writer         = get<ModelicaSDF_close_writer>         (l, "ModelicaSDF_close_writer");
+	auto get_time_series_size = get<ModelicaSDF_get_time_series_size> (l, "ModelicaSDF_get_time_series_size");
+	auto read_time_series     = get<ModelicaSDF_read_time_series>     (l, "ModelicaSDF_read_time_series");
+	auto close_files          = get<ModelicaSDF_close_files>          (l, "ModelicaSDF_close_files");
+	auto make_dataset_double  = get<ModelicaSDF_make_dataset_double>  (l, "ModelicaSDF_make_dataset_double");
+
+	const auto filename = TESTS_DIR "writer.sdf";
+
+	remove(filename);
+
+	const char *names[2] = { "/x", "/y" };
+	const char *units[2] = { "m", "" };
+
+	ModelicaSDF_Writer *writer = nullptr;
+
+	CHECK_THAT(open_writer(filename, "/time", "s", 0, names, units, 4, 1, &writer), Equals("Number of datasets must be > 0"));
+	CHECK_THAT(open_writer(filename, "/time", "s", 2, names, units, 1, 1, &writer), Equals("The capacity must be >= 2"));
+	CHECK_THAT(open_writer(filename, "/time", "s", 2, names, units, 4, 0, &writer), Equals("The flush interval must be > 0"));
+	CHECK(writer == nullptr);
+
+	// a small buffer to test the back-pressure
+	REQUIRE_THAT(open_writer(filename, "/time", "s", 2, names, units, 3, 60, &writer), Equals(""));
+	REQUIRE(writer != nullptr);
+
+	const int nrows = 1000;
+
+	for (int i = 0; i < nrows; i++) {
+		double row[3] = { 0.1 * i, static_cast<double>(i), -2.0 * i };
+		REQUIRE_THAT(write_row(writer, row, 3), Equals(""));
+	}
+
+	double row[2] = { 0 };
+	CHECK_THAT(write_row(writer, row, 2), Equals("The row must have 3 values but has 2"));
+
+	REQUIRE_THAT(flush_writer(writer), Equals(""));
+
+	int size = 0;
+	REQUIRE_THAT(get_time_series_size(filename, names, &size), Equals(""));
+	REQUIRE(size == nrows);
+
+	std::vector<double> data(nrows * 3);
+	REQUIRE_THAT(read_time_series(filename, 2, names, units, "s", size, data.data()), Equals(""));
+
+	for (int i = 0; i < nrows; i++) {
+		CHECK(data[i * 3] == 0.1 * i);
+		CHECK(data[i * 3 + 1] == i);
+		CHECK(data[i * 3 + 2] == -2.0 * i);
+	}
+
+	// the remaining rows are written on close
+	double last[3] = { 100, 1, 2 };
+	REQUIRE_THAT(write_row(writer, last, 3), Equals(""));
+	REQUIRE_THAT(close_writer(writer), Equals(""));
+
+	REQUIRE_THAT(get_time_series_size(filename, names, &size), Equals(""));
+	CHECK(size == nrows + 1);
+
+	CHECK_THAT(close_writer(nullptr), Equals(""));
+
+	close_files();
+
+	remove(filename);
+
+	// the error of the worker is reported by the next call
+	REQUIRE_THAT(open_writer(filename, "/time", "s", 2, names, units, 4, 60, &writer), Equals(""));
+
+	// replace "/x" with a dataset that is not appendable
+	int x_dims[2] = { 2, 2 };
+	double x[4] = { 0 };
+	REQUIRE_THAT(make_dataset_double(filename, "/x", 2, x_dims, x, "", "", "", "", 0), Equals(""));
+
+	std::string message;
+
+	for (int i = 0; i < nrows && message.empty(); i++) {
+		double row[3] = { 0.1 * i, static_cast<double>(i), -2.0 * i };
+		message = write_row(writer, row, 3);
+	}
+
+	CHECK(!message.empty());
+	CHECK_THAT(close_writer(writer), Equals(message));
+
+	close_files();
+
+	remove(filename);
+}
+
+TEST_CASE("flush the buffered writer while a batch is appended", "[functions]") {
+
+# ifdef _WIN32
+	auto l = LoadLibraryA(SHARED_LIBRARY_PATH);
+# else
+	auto l = dlopen(SHARED_LIBRARY_PATH, RTLD_LAZY);
+# endif
+
+	REQUIRE(l != nullptr);
+
+	auto open_writer  = get<ModelicaSDF_open_writer>  (l, "ModelicaSDF_open_writer");
+	auto write_row    = get<ModelicaSDF_write_row>    (l, "ModelicaSDF_write_row");
+	auto flush_writer = get<ModelicaSDF_flush_writer> (l, "ModelicaSDF_flush_writer");
+	auto close_writer = get<ModelicaSDF_close_writer> (l, "ModelicaSDF_close_writer");
+	auto close_files  = get<ModelicaSDF_close_files>  (l, "ModelicaSDF_close_files");
+
+	const auto filename = TESTS_DIR "writer.sdf";
+
+	remove(filename);
+
+	const char *names[1] = { "/x" };
+	const char *units[1] = { "" };
+
+	// a long flush interval, so only the half buffer and the flush requests trigger the worker
+	const int capacity = 1 << 14;
+
+	ModelicaSDF_Writer *writer = nullptr;
+
+	REQUIRE_THAT(open_writer(filename, "/time", "s", 1, names, units, capacity, 3600, &writer), Equals(""));
+
+	int nrows = 0;
+
+	for (int i = 0; i < 20; i++) {
+
+		// filling half of the buffer starts a batch in the worker...
+		for (int j = 0; j < capacity / 2; j++, nrows++) {
+			double row[2] = { 0.1 * nrows, static_cast<double>(nrows) };
+			REQUIRE_THAT(write_row(writer, row, 2), Equals(""));
+		}
+
+		// ...that is still being appended when (most of) the flush requests arrive
+		std::this_thread::sleep_for(std::chrono::microseconds(100 * i));
+
+		REQUIRE_THAT(flush_writer(writer), Equals(""));
+
+		// the flushed file must at least contain the raw data of both datasets
+		struct stat st;
+		REQUIRE(stat(filename, &st) == 0);
+		CHECK(st.st_size >= static_cast<off_t>(nrows * 2 * sizeof(double)));
+	}
+
+	REQUIRE_THAT(close_writer(writer), Equals(""));
+
+	close_files();
+
+	remove(filename);
+}
+
+TEST_CASE("benchmark buffered writer", "[.][benchmark]") {
+
+# ifdef _WIN32
+	auto l = LoadLibraryA(SHARED_LIBRARY_PATH);
+# else
+	auto l = dlopen(SHARED_LIBRARY_PATH, RTLD_LAZY);
+# endif
+
+	REQUIRE(l != nullptr);
+
+	auto open_writer         = get<ModelicaSDF_open_writer>         (l, "ModelicaSDF_open_writer");
+	auto write_row           = get<ModelicaSDF_write_row>           (l, "ModelicaSDF_write_row");
+	auto close_writer        = get<ModelicaSDF_close_writer>        (l, "ModelicaSDF_close_writer");
+	auto append_rows         = get<ModelicaSDF_append_rows>         (l, "ModelicaSDF_append_rows");
+	auto make_dataset_double = get<ModelicaSDF_make_dataset_double> (l, "ModelicaSDF_make_dataset_double");
+	auto close_files         = get<ModelicaSDF_close_files>         (l, "ModelicaSDF_close_files");
+
+	const auto filename = TESTS_DIR "writer.sdf";
+
+	// log 10 signals
+	const int nsignals = 10;
+
+	std::vector<std::string> names;
+	std::vector<const char *> name_ptrs, unit_ptrs;
+
+	for (int i = 0; i < nsignals; i++) {
+		names.push_back("/s" + std::to_string(i));
+	}
+
+	for (auto &name : names) {
+		name_ptrs.push_back(name.c_str());
+		unit_ptrs.push_back("");
+	}
+
+	std::vector<double> row(nsignals + 1, 1.0);
+
+	remove(filename);
+
+	ModelicaSDF_Writer *writer = nullptr;
+
+	REQUIRE_THAT(open_writer(filename, "/time", "s", nsignals, name_ptrs.data(), unit_ptrs.data(), 4096, 1, &writer), Equals(""));
+
+	BENCHMARK("buffered write_row") {
+		return write_row(writer, row.data(), nsignals + 1);
+	};
+
+	REQUIRE_THAT(close_writer(writer), Equals(""));
+
+	close_files();
+
+	remove(filename);
+
+	BENCHMARK("synchronous append_rows") {
+		return append_rows(filename, "/time", "s", nsignals, name_ptrs.data(), unit_ptrs.data(), 1, row.data());
+	};
+
+	close_files();
+
+	remove(filename);
+
+	// the synchronous path without appending: rewrite the current row
+	int dims[1] = { nsignals + 1 };
+
+	BENCHMARK("synchronous make_dataset_double") {
+		return make_dataset_double(filename, "/row", 1, dims, row.data(), "", "", "", "", 0);
+	};
+
+	remove(filename);
+}
+
+TEST_CASE("concurrent error messages", "[functions]") {
+
+	// load the shared library
+# ifdef _WIN32
+	auto l = LoadLibraryA(SHARED_LIBRARY_PATH);
+# else
+	auto l = dlopen(SHARED_LIBRARY_PATH, RTLD_LAZY);
+# endif
+
+	REQUIRE(l != nullptr);
+
+	auto open_writer  = get<ModelicaSDF_open_writer>  (l, "ModelicaSDF_open_writer");
+	auto write_row    = get<ModelicaSDF_write_row>    (l, "ModelicaSDF_write_row");
+	auto close_writer = get<ModelicaSDF_close_writer> (l, "ModelicaSDF_close_writer");
+	auto close_files  = get<ModelicaSDF_close_files>  (l, "ModelicaSDF_close_files");
+
+	const auto filename = TESTS_DIR "errors.sdf";
+
+	remove(filename);
+
+	const char *names[1] = { "/x" };
+	const char *units[1] = { "" };
+
+	ModelicaSDF_Writer *writer = nullptr;
+
+	REQUIRE_THAT(open_writer(filename, "/time", "s", 1, names, units, 4, 60, &writer), Equals(""));
+
+	const int nthreads = 8, iterations = 10000;
+
+	std::atomic<int> mismatches(0);
+	std::vector<std::thread> threads;
+
+	// rows with the wrong size are rejected before they are buffered, so every thread can produce its own message
+	for (int t = 0; t < nthreads; t++) {
+		threads.emplace_back([t, writer, write_row, &mismatches]() {
+
+			std::vector<double> row(3 + t);
+			const std::string expected = "The row must have 2 values but has " + std::to_string(row.size());
+
+			for (int i = 0; i < iterations; i++) {
+
+				const char *message = write_row(writer, row.data(), static_cast<int>(row.size()));
+
+				std::this_thread::yield();
+
+				if (expected != message) {
+					mismatches++;
+				}
+			}
+		});
+	}
+
+	for (auto &thread : threads) {
+		thread.join();
+	}
+
+	CHECK(mismatches == 0);
+
+	CHECK_THAT(close_writer(writer), Equals(""));
+
+	close_files();
+
+	remove(filename);
+}
+
+TEST_CASE("open and fill tables and time series", "[functions]") {
+
+	// load the shared library
+# ifdef _WIN32
+	auto l = LoadLibraryA(SHARED_LIBRARY_PATH);
+# else
+	auto l = dlopen(SHARED_LIBRARY_PATH, RTLD_LAZY);
+# endif
+
+	REQUIRE(l != nullptr);
+
+	auto open_table           = get<ModelicaSDF_open_table>           (l, "ModelicaSDF_open_table");
+	auto fill_table           = get<ModelicaSDF_fill_table>           (l, "ModelicaSDF_fill_table");
+	auto open_time_series     = get<ModelicaSDF_open_time_series>     (l, "ModelicaSDF_open_time_series");
+	auto fill_time_series     = get<ModelicaSDF_fill_time_series>     (l, "ModelicaSDF_fill_time_series");
+	auto close_handle         = get<ModelicaSDF_close_handle>         (l, "ModelicaSDF_close_handle");
+	auto get_table_data_size  = get<ModelicaSDF_get_table_data_size>  (l, "ModelicaSDF_get_table_data_size");
+	auto read_table_data      = get<ModelicaSDF_read_table_data>      (l, "ModelicaSDF_read_table_data");
+	auto make_dataset_double  = get<ModelicaSDF_make_dataset_double>  (l, "ModelicaSDF_make_dataset_double");
+	auto close_files          = get<ModelicaSDF_close_files>          (l, "ModelicaSDF_close_files");
+
+	const auto filename = TESTS_DIR "table.sdf";
+
+	make_table(l, filename);
+
+	const char *scale_units[2] = { "m", "s" };
+	ModelicaSDF_Handle *handle = nullptr;
+	int size = 0;
+	double data[14] = { 0 };
+
+	SECTION("table") {
+
+		CHECK_THAT(open_table(filename, "/T", &handle, &size), Equals(""));
+		REQUIRE(handle != nullptr);
+		CHECK(size == 14);
+
+		CHECK_THAT(fill_table(handle, 1, "", scale_units, data), Equals("Dataset '/T' in '" TESTS_DIR "table.sdf' has the wrong number of dimension. Expected 1 but was 2."));
+
+		CHECK_THAT(fill_table(handle, 2, "", scale_units, data), Equals(""));
+		CHECK(data[0] == 2);
+		CHECK(data[5] == 3);
+		CHECK(data[7] == 20);
+		CHECK(data[13] == 3.2);
+
+		CHECK_THAT(fill_time_series(handle, 1, nullptr, nullptr, "", 3, data), Equals("'/T' in '" TESTS_DIR "table.sdf' has not been opened as a time series"));
+
+		close_handle(handle);
+
+		CHECK_THAT(open_table(filename, "/DoesNotExist", &handle, &size), Equals("Failed to open dataset '/DoesNotExist' in '" TESTS_DIR "table.sdf'"));
+		CHECK(handle == nullptr);
+	}
+
+	SECTION("a modified file is read again") {
+
+		double t_data[2] = { 5, 6 };
+		int t_dims[2] = { 1, 2 };
+
+		CHECK_THAT(get_table_data_size(filename, "/T", &size), Equals(""));
+		CHECK(size == 14);
+
+		// replace /T with a 1x2 table without scales
+		CHECK_THAT(make_dataset_double(filename, "/T", 2, t_dims, t_data, "", "", "", "", 0), Equals(""));
+
+		CHECK_THAT(read_table_data(filename, "/T", 2, "", scale_units, data), Equals("Dataset '/T' in '" TESTS_DIR "table.sdf' has no scale for dimension 1"));
+	}
+
+	SECTION("time series") {
+
+		const char *dataset_names[2] = { "/boxBody1/density", "/boxBody1/frame_a/t[3]" };
+		const char *dataset_units[2] = { "kg/m3", "N.m" };
+		double ts[502][3] = { 0 };
+
+		CHECK_THAT(open_time_series(TESTS_DIR "DoublePendulum_Dymola-2012.mat", dataset_names, &handle, &size), Equals(""));
+		REQUIRE(handle != nullptr);
+		CHECK(size == 502);
+
+		CHECK_THAT(fill_time_series(handle, 2, dataset_names, dataset_units, "s", size, reinterpret_cast<double *>(ts)), Equals(""));
+		check_data(ts);
+
+		close_handle(handle);
+
+		const char *table_names[1] = { "/X" };
+		const char *table_units[1] = { "" };
+		double xs[3][2] = { 0 };
+
+		// a dataset without a scale
+		CHECK_THAT(open_time_series(filename, table_names, &handle, &size), Equals(""));
+		CHECK(size == 3);
+		CHECK_THAT(fill_time_series(handle, 1, table_names, table_units, "", size, reinterpret_cast<double *>(xs)), Equals("Dataset '/X' in '" TESTS_DIR "table.sdf' has no scale"));
+		close_handle(handle);
+	}
+
+	close_files();
+
+	remove(filename);
+}
+
+
+TEST_CASE("read time series windows", "[functions]") {
+
+	// load the shared library
+# ifdef _WIN32
+	auto l = LoadLibraryA(SHARED_LIBRARY_PATH);
+# else
+	auto l = dlopen(SHARED_LIBRARY_PATH, RTLD_LAZY);
+# endif
+
+	REQUIRE(l != nullptr);
+
+	auto make_dataset_double        = get<ModelicaSDF_make_dataset_double>        (l, "ModelicaSDF_make_dataset_double");
+	auto attach_scale               = get<ModelicaSDF_attach_scale>               (l, "ModelicaSDF_attach_scale");
+	auto get_time_series_size       = get<ModelicaSDF_get_time_series_size>       (l, "ModelicaSDF_get_time_series_size");
+	auto read_time_series           = get<ModelicaSDF_read_time_series>           (l, "ModelicaSDF_read_time_series");
+	auto get_time_series_window     = get<ModelicaSDF_get_time_series_window>     (l, "ModelicaSDF_get_time_series_window");
+	auto read_time_series_window    = get<ModelicaSDF_read_time_series_window>    (l, "ModelicaSDF_read_time_series_window");
+	auto close_files                = get<ModelicaSDF_close_files>                (l, "ModelicaSDF_close_files");
+
+	const auto filename = TESTS_DIR "time_series.sdf";
+
+	// t = 0, 0.5,... 49.5, u = i, v = -i
+	int dims[1] = { 100 };
+	double t[100], u[100], v[100];
+
+	for (int i = 0; i < 100; i++) {
+		t[i] = 0.5 * i;
+		u[i] = i;
+		v[i] = -i;
+	}
+
+	remove(filename);
+
+	REQUIRE_THAT(make_dataset_double(filename, "/time", 1, dims, t, "", "", "s", "", 0), Equals(""));
+	REQUIRE_THAT(make_dataset_double(filename, "/u", 1, dims, u, "", "", "V", "", 0), Equals(""));
+	REQUIRE_THAT(make_dataset_double(filename, "/v", 1, dims, v, "", "", "A", "", 0), Equals(""));
+	REQUIRE_THAT(attach_scale(filename, "/u", "/time", "t", 0), Equals(""));
+	REQUIRE_THAT(attach_scale(filename, "/v", "/time", "t", 0), Equals(""));
+
+	const char *dataset_names[2] = { "/u", "/v" };
+	const char *dataset_units[2] = { "V", "A" };
+	int start = -1, count = -1;
+
+	SECTION("time ranges") {
+
+		// from the last sample <= start time to the first sample >= stop time
+		CHECK_THAT(get_time_series_window(filename, dataset_names, 5.2, 10, 1, &start, &count), Equals(""));
+		CHECK(start == 10);
+		CHECK(count == 11);
+
+		CHECK_THAT(get_time_series_window(filename, dataset_names, 5.2, 10, 3, &start, &count), Equals(""));
+		CHECK(start == 10);
+		CHECK(count == 5);
+
+		// before the first sample
+		CHECK_THAT(get_time_series_window(filename, dataset_names, -10, 0.2, 1, &start, &count), Equals(""));
+		CHECK(start == 0);
+		CHECK(count == 2);
+
+		// without reading beyond the last sample
+		CHECK_THAT(get_time_series_window(filename, dataset_names, 45, 1000, 4, &start, &count), Equals(""));
+		CHECK(start == 90);
+		CHECK(count == 3);
+
+		CHECK_THAT(get_time_series_window(filename, dataset_names, 0, 1, 0, &start, &count), Equals("The stride must be > 0"));
+		CHECK_THAT(get_time_series_window(filename, dataset_names, 1, 0, 1, &start, &count), Equals("The stop time must be >= the start time"));
+	}
+
+	SECTION("samples") {
+
+		double data[5][3] = { 0 };
+
+		CHECK_THAT(get_time_series_window(filename, dataset_names, 5.2, 10, 3, &start, &count), Equals(""));
+		REQUIRE(count == 5);
+
+		CHECK_THAT(read_time_series_window(filename, 2, dataset_names, dataset_units, "s", start, count, 3, &data[0][0]), Equals(""));
+
+		for (int j = 0; j < 5; j++) {
+			CHECK(data[j][0] == t[10 + 3 * j]);
+			CHECK(data[j][1] == u[10 + 3 * j]);
+			CHECK(data[j][2] == v[10 + 3 * j]);
+		}
+
+		CHECK_THAT(read_time_series_window(filename, 2, dataset_names, dataset_units, "s", 90, 5, 3, &data[0][0]), Equals("Dataset '/time' has the wrong number of elements"));
+		CHECK_THAT(read_time_series_window(filename, 2, dataset_names, dataset_units, "s", 0, 5, 0, &data[0][0]), Equals("The first sample must be >= 0 and the stride must be > 0"));
+	}
+
+	SECTION("datasets with different sizes") {
+
+		double data[5][3] = { 0 };
+
+		// a dataset with fewer samples than its scale
+		int w_dims[1] = { 90 };
+		REQUIRE_THAT(make_dataset_double(filename, "/w", 1, w_dims, u, "", "", "V", "", 0), Equals(""));
+		REQUIRE_THAT(attach_scale(filename, "/w", "/time", "t", 0), Equals(""));
+
+		const char *names_uw[2] = { "/u", "/w" };
+		const char *names_wu[2] = { "/w", "/u" };
+		const char *units_vv[2] = { "V", "V" };
+
+		// the window lies within all datasets, but their sizes differ
+		CHECK_THAT(read_time_series_window(filename, 2, names_uw, units_vv, "s", 0, 5, 1, &data[0][0]), Equals("Dataset '/w' has the wrong number of elements"));
+		CHECK_THAT(read_time_series_window(filename, 2, names_wu, units_vv, "s", 0, 5, 1, &data[0][0]), Equals("Dataset '/time' has the wrong number of elements"));
+	}
+
+	SECTION("Dymola result") {
+
+		const char *fname = TESTS_DIR "DoublePendulum_Dymola-2012.mat";
+		const char *names[2] = { "/boxBody1/density", "/boxBody1/frame_a/t[3]" };
+		const char *units[2] = { "kg/m3", "N.m" };
+		double all[502][3] = { 0 };
+		double data[502][3] = { 0 };
+		int size = 0;
+
+		REQUIRE_THAT(get_time_series_size(fname, names, &size), Equals(""));
+		REQUIRE_THAT(read_time_series(fname, 2, names, units, "s", size, &all[0][0]), Equals(""));
+
+		CHECK_THAT(get_time_series_window(fname, names, 0.5, 1, 2, &start, &count), Equals(""));
+		REQUIRE(count > 1);
+		REQUIRE(start + (count - 1) * 2 < size);
+		CHECK(all[start][0] <= 0.5);
+		CHECK(all[start + (count - 1) * 2][0] >= 1);
+
+		CHECK_THAT(read_time_series_window(fname, 2, names, units, "s", start, count, 2, &data[0][0]), Equals(""));
+
+		for (int j = 0; j < count; j++) {
+			for (int i = 0; i < 3; i++) {
+				CHECK(data[j][i] == all[start + 2 * j][i]);
+			}
+		}
+	}
+
+	close_files();
+
+	remove(filename);
+}
+
+TEST_CASE("share table data", "[functions]") {
+
+	// load the shared library
+# ifdef _WIN32
+	auto l = LoadLibraryA(SHARED_LIBRARY_PATH);
+# else
+	auto l = dlopen(SHARED_LIBRARY_PATH, RTLD_LAZY);
+# endif
+
+	REQUIRE(l != nullptr);
+
+	auto acquire_table_data         = get<ModelicaSDF_acquire_table_data>         (l, "ModelicaSDF_acquire_table_data");
+	auto release_table_data         = get<ModelicaSDF_release_table_data>         (l, "ModelicaSDF_release_table_data");
+	auto get_table_cache_statistics = get<ModelicaSDF_get_table_cache_statistics> (l, "ModelicaSDF_get_table_cache_statistics");
+
+	const auto filename = TESTS_DIR "table.sdf";
+
+	make_table(l, filename);
+
+	const char *scale_units[2] = { "m", "s" };
+	const char *no_scale_units[2] = { "", "" };
+	const double *data1 = nullptr, *data2 = nullptr, *data3 = nullptr, *data4 = nullptr, *data5 = nullptr;
+	int size1 = 0, size2 = 0, size3 = 0, size4 = 0, size5 = 0, entries = 0, hits = 0, misses = 0;
+	double bytes_cached = 0, bytes_saved = 0;
+
+	// the first request reads the file
+	CHECK_THAT(acquire_table_data(filename, "/T", 2, "K", scale_units, &data1, &size1), Equals(""));
+	REQUIRE(size1 == 1 + 2 + 3 + 2 + 6);
+	CHECK(data1[0] == 2);
+	CHECK(data1[1] == 3);
+	CHECK(data1[2] == 2);
+	CHECK(data1[3] == 1);
+	CHECK(data1[6] == 10);
+	CHECK(data1[8] == 1.1);
+	CHECK(data1[13] == 3.2);
+
+	// the same table is shared
+	CHECK_THAT(acquire_table_data(filename, "/T", 2, "K", scale_units, &data2, &size2), Equals(""));
+	CHECK(data2 == data1);
+	CHECK(size2 == size1);
+
+	// different units are a different table
+	CHECK_THAT(acquire_table_data(filename, "/T", 2, "", no_scale_units, &data3, &size3), Equals(""));
+	CHECK(data3 != data1);
+
+	get_table_cache_statistics(&entries, &hits, &misses, &bytes_cached, &bytes_saved);
+	CHECK(entries == 2);
+	CHECK(hits == 1);
+	CHECK(misses == 2);
+	CHECK(bytes_cached == 2 * size1 * sizeof(double));
+	CHECK(bytes_saved == size1 * sizeof(double));
+
+	// errors are not cached
+	const char *wrong_scale_units[2] = { "A", "s" };
+	const double *invalid = nullptr;
+	int invalid_size = -1;
+	CHECK_THAT(acquire_table_data(filename, "/T", 2, "K", wrong_scale_units, &invalid, &invalid_size), Equals("Attribute 'UNIT' in '/X' has the wrong value. Expected 'A' but was 'm'."));
+	CHECK(invalid == nullptr);
+	CHECK(invalid_size == 0);
+
+	// a modified file is read again
+	struct utimbuf times;
+	times.actime = times.modtime = time(nullptr) + 10;
+	REQUIRE(utime(filename, &times) == 0);
+
+	CHECK_THAT(acquire_table_data(filename, "/T", 2, "K", scale_units, &data4, &size4), Equals(""));
+	CHECK(data4 != data1);
+
+	// a file that is rewritten within the resolution of the modification time is read again, too
+	FILE *file = fopen(filename, "ab");
+	REQUIRE(file != nullptr);
+	fputc(0, file);
+	fclose(file);
+	REQUIRE(utime(filename, &times) == 0);
+
+	CHECK_THAT(acquire_table_data(filename, "/T", 2, "K", scale_units, &data5, &size5), Equals(""));
+	CHECK(data5 != data4);
+
+	// the data is freed with the last reference
+	release_table_data(data1);
+	release_table_data(data3);
+	release_table_data(data4);
+	release_table_data(data5);
+
+	get_table_cache_statistics(&entries, &hits, &misses, &bytes_cached, &bytes_saved);
+	CHECK(entries == 1);
+	CHECK(misses == 4);
+
+	release_table_data(data2);
+
+	get_table_cache_statistics(&entries, &hits, &misses, &bytes_cached, &bytes_saved);
+	CHECK(entries == 0);
+	CHECK(bytes_cached == 0);
+
+	remove(filename);
+}
+
+
+void make_large_table(HMODULE l, const char *filename, int nx, int ny, bool chunked, bool single = false) {
+
+	auto make_dataset_double         = get<ModelicaSDF_make_dataset_double>         (l, "ModelicaSDF_make_dataset_double");
+	auto make_dataset_float          = get<ModelicaSDF_make_dataset_float>          (l, "ModelicaSDF_make_dataset_float");
+	auto make_chunked_dataset_double = get<ModelicaSDF_make_chunked_dataset_double> (l, "ModelicaSDF_make_chunked_dataset_double");
+	auto attach_scale                = get<ModelicaSDF_attach_scale>                (l, "ModelicaSDF_attach_scale");
+
+	std::vector<double> x(nx), y(ny), t(static_cast<size_t>(nx) * ny);
+
+	for (int i = 0; i < nx; i++) x[i] = i;
+	for (int j = 0; j < ny; j++) y[j] = j;
+	for (size_t k = 0; k < t.size(); k++) t[k] = 0.5 * k;
+
+	int x_dims[1] = { nx }, y_dims[1] = { ny }, t_dims[2] = { nx, ny };
+
+	remove(filename);
+
+	REQUIRE_THAT(make_dataset_double(filename, "/X", 1, x_dims, x.data(), "", "", "", "", 0), Equals(""));
+	REQUIRE_THAT(make_dataset_double(filename, "/Y", 1, y_dims, y.data(), "", "", "", "", 0), Equals(""));
+
+	if (chunked) {
+		REQUIRE_THAT(make_chunked_dataset_double(filename, "/T", 2, t_dims, t.data(), "", "", "", "", 0, nullptr, 0, 0), Equals(""));
+	} else if (single) {
+		REQUIRE_THAT(make_dataset_float(filename, "/T", 2, t_dims, t.data(), "", "", "", "", 0), Equals(""));
+	} else {
+		REQUIRE_THAT(make_dataset_double(filename, "/T", 2, t_dims, t.data(), "", "", "", "", 0), Equals(""));
+	}
+
+	REQUIRE_THAT(attach_scale(filename, "/T", "/X", "x", 0), Equals(""));
+	REQUIRE_THAT(attach_scale(filename, "/T", "/Y", "y", 1), Equals(""));
+}
+
+TEST_CASE("map shared tables", "[functions]") {
+
+	// load the shared library
+# ifdef _WIN32
+	auto l = LoadLibraryA(SHARED_LIBRARY_PATH);
+# else
+	auto l = dlopen(SHARED_LIBRARY_PATH, RTLD_LAZY);
+# endif
+
+	REQUIRE(l != nullptr);
+
+	auto acquire_table              = get<ModelicaSDF_acquire_table>              (l, "ModelicaSDF_acquire_table");
+	auto acquire_table_data         = get<ModelicaSDF_acquire_table_data>         (l, "ModelicaSDF_acquire_table_data");
+	auto release_table_data         = get<ModelicaSDF_release_table_data>         (l, "ModelicaSDF_release_table_data");
+	auto get_table_cache_statistics = get<ModelicaSDF_get_table_cache_statistics> (l, "ModelicaSDF_get_table_cache_statistics");
+	auto close_files                = get<ModelicaSDF_close_files>                (l, "ModelicaSDF_close_files");
+	auto make_dataset_double        = get<ModelicaSDF_make_dataset_double>        (l, "ModelicaSDF_make_dataset_double");
+	auto append_rows                = get<ModelicaSDF_append_rows>                (l, "ModelicaSDF_append_rows");
+	auto attach_scale               = get<ModelicaSDF_attach_scale>               (l, "ModelicaSDF_attach_scale");
+
+	const auto filename = TESTS_DIR "large_table.sdf";
+	const int nx = 512, ny = 300, nheader = 1 + 2 + nx + ny;
+	const char *scale_units[2] = { "", "" };
+
+	const double *data = nullptr, *copy = nullptr;
+	const void *values = nullptr;
+	long long size = 0;
+	int single = 0, copy_size = 0, entries = 0, hits = 0, misses = 0;
+	double bytes_cached = 0, bytes_saved = 0;
+
+	SECTION("contiguous") {
+
+		make_large_table(l, filename, nx, ny, false);
+
+		// the values are mapped from the file
+		REQUIRE_THAT(acquire_table(filename, "/T", 2, "", scale_units, &single, &data, &size, &values), Equals(""));
+		CHECK(single == 0);
+		CHECK(size == nheader);
+		CHECK(data[0] == 2);
+		CHECK(data[1] == nx);
+		CHECK(data[2] == ny);
+		CHECK(data[3 + nx - 1] == nx - 1);
+		CHECK(data[3 + nx + ny - 1] == ny - 1);
+		REQUIRE(values != nullptr);
+		auto doubles = static_cast<const double *>(values);
+		CHECK((doubles < data || doubles >= data + size));
+
+		// the copy has the same values
+		REQUIRE_THAT(acquire_table_data(filename, "/T", 2, "", scale_units, &copy, &copy_size), Equals(""));
+		REQUIRE(copy_size == nheader + nx * ny);
+		CHECK(copy != data);
+		CHECK(std::memcmp(copy + nheader, doubles, sizeof(double) * nx * ny) == 0);
+		CHECK(doubles[nx * ny - 1] == 0.5 * (nx * ny - 1));
+
+		get_table_cache_statistics(&entries, &hits, &misses, &bytes_cached, &bytes_saved);
+		CHECK(entries == 2);
+		CHECK(bytes_cached == 2.0 * copy_size * sizeof(double));
+
+		// the mapped table is shared
+		const double *data2 = nullptr;
+		const void *values2 = nullptr;
+		long long size2 = 0;
+		int single2 = 0;
+		REQUIRE_THAT(acquire_table(filename, "/T", 2, "", scale_units, &single2, &data2, &size2, &values2), Equals(""));
+		CHECK(data2 == data);
+		CHECK(values2 == values);
+
+		release_table_data(data2);
+	}
+
+	SECTION("chunked") {
+
+		make_large_table(l, filename, nx, ny, true);
+
+		// chunked values are read
+		REQUIRE_THAT(acquire_table(filename, "/T", 2, "", scale_units, &single, &data, &size, &values), Equals(""));
+		CHECK(size == nheader + nx * ny);
+		CHECK(values == data + nheader);
+		CHECK(static_cast<const double *>(values)[nx * ny - 1] == 0.5 * (nx * ny - 1));
+
+		REQUIRE_THAT(acquire_table_data(filename, "/T", 2, "", scale_units, &copy, &copy_size), Equals(""));
+		CHECK(std::memcmp(copy, data, sizeof(double) * size) == 0);
+	}
+
+	SECTION("rewrite while mapped") {
+
+		make_large_table(l, filename, nx, ny, false);
+
+		REQUIRE_THAT(acquire_table(filename, "/T", 2, "", scale_units, &single, &data, &size, &values), Equals(""));
+		REQUIRE(size == nheader);
+
+		// the file is not written while the values are mapped
+		const std::string message = "Failed to open '" + std::string(filename) + "' for writing because tables are mapped from it";
+		std::vector<double> zeros(static_cast<size_t>(nx) * ny, 0.0);
+		int t_dims[2] = { nx, ny };
+		const char *names[1] = { "/u" };
+		const char *units[1] = { "" };
+		double row[2] = { 0, 1 };
+
+		CHECK_THAT(make_dataset_double(filename, "/T", 2, t_dims, zeros.data(), "", "", "", "", 0), Equals(message));
+		CHECK_THAT(append_rows(filename, "/time", "s", 1, names, units, 1, row), Equals(message));
+		CHECK_THAT(attach_scale(filename, "/T", "/X", "x", 0), Equals(message));
+
+		auto doubles = static_cast<const double *>(values);
+		CHECK(doubles[nx * ny - 1] == 0.5 * (nx * ny - 1));
+
+		// but again after the last reference has been released
+		release_table_data(data);
+		data = nullptr;
+
+		CHECK_THAT(make_dataset_double(filename, "/T", 2, t_dims, zeros.data(), "", "", "", "", 0), Equals(""));
+	}
+
+	release_table_data(data);
+	release_table_data(copy);
+
+	get_table_cache_statistics(&entries, &hits, &misses, &bytes_cached, &bytes_saved);
+	CHECK(entries == 0);
+
+	close_files();
+
+	remove(filename);
+}
+
+TEST_CASE("single precision shared tables", "[functions]") {
+
+	// load the shared library
+# ifdef _WIN32
+	auto l = LoadLibraryA(SHARED_LIBRARY_PATH);
+# else
+	auto l = dlopen(SHARED_LIBRARY_PATH, RTLD_LAZY);
+# endif
+
+	REQUIRE(l != nullptr);
+
+	auto acquire_table              = get<ModelicaSDF_acquire_table>              (l, "ModelicaSDF_acquire_table");
+	auto acquire_table_data         = get<ModelicaSDF_acquire_table_data>         (l, "ModelicaSDF_acquire_table_data");
+	auto release_table_data         = get<ModelicaSDF_release_table_data>         (l, "ModelicaSDF_release_table_data");
+	auto get_table_cache_statistics = get<ModelicaSDF_get_table_cache_statistics> (l, "ModelicaSDF_get_table_cache_statistics");
+	auto close_files                = get<ModelicaSDF_close_files>                (l, "ModelicaSDF_close_files");
+
+	const auto filename = TESTS_DIR "large_table.sdf";
+	const int nx = 512, ny = 300, nheader = 1 + 2 + nx + ny;
+	const char *scale_units[2] = { "", "" };
+
+	const double *data = nullptr, *copy = nullptr;
+	const void *values = nullptr;
+	long long size = 0;
+	int single = 0, copy_size = 0, entries = 0, hits = 0, misses = 0;
+	double bytes_cached = 0, bytes_saved = 0;
+
+	SECTION("stored as floats") {
+
+		make_large_table(l, filename, nx, ny, false, true);
+
+		// the floats are detected and mapped from the file
+		REQUIRE_THAT(acquire_table(filename, "/T", 2, "", scale_units, &single, &data, &size, &values), Equals(""));
+		CHECK(single == 1);
+		CHECK(size == nheader);
+		CHECK(data[3 + nx + ny - 1] == ny - 1);
+		REQUIRE(values != nullptr);
+		CHECK(reinterpret_cast<size_t>(values) % sizeof(float) == 0);
+
+		auto floats = static_cast<const float *>(values);
+		CHECK(floats[nx * ny - 1] == 0.5f * (nx * ny - 1));
+
+		// the values are converted to doubles
+		REQUIRE_THAT(acquire_table_data(filename, "/T", 2, "", scale_units, &copy, &copy_size), Equals(""));
+		REQUIRE(copy_size == nheader + nx * ny);
+		CHECK(copy[nheader + nx * ny - 1] == static_cast<double>(floats[nx * ny - 1]));
+
+		get_table_cache_statistics(&entries, &hits, &misses, &bytes_cached, &bytes_saved);
+		CHECK(entries == 2);
+		CHECK(bytes_cached == (2.0 * nheader + nx * ny) * sizeof(double) + nx * ny * sizeof(float));
+	}
+
+	SECTION("stored as doubles") {
+
+		make_large_table(l, filename, nx, ny, false);
+
+		// the values are converted to floats
+		single = 1;
+		REQUIRE_THAT(acquire_table(filename, "/T", 2, "", scale_units, &single, &data, &size, &values), Equals(""));
+		CHECK(single == 1);
+		CHECK(size == nheader);
+		CHECK(values == data + size);
+
+		auto floats = static_cast<const float *>(values);
+		CHECK(floats[1] == 0.5f);
+		CHECK(floats[nx * ny - 1] == static_cast<float>(0.5 * (nx * ny - 1)));
+
+		// requests for doubles are not served by the float entry
+		const double *data2 = nullptr;
+		const void *values2 = nullptr;
+		long long size2 = 0;
+		int single2 = 0;
+		REQUIRE_THAT(acquire_table(filename, "/T", 2, "", scale_units, &single2, &data2, &size2, &values2), Equals(""));
+		CHECK(single2 == 0);
+		CHECK(data2 != data);
+		CHECK(static_cast<const double *>(values2)[nx * ny - 1] == 0.5 * (nx * ny - 1));
+
+		// but the float entry is shared
+		long long size3 = 0;
+		REQUIRE_THAT(acquire_table(filename, "/T", 2, "", scale_units, &single, &copy, &size3, &values2), Equals(""));
+		CHECK(single == 1);
+		CHECK(copy == data);
+		CHECK(values2 == values);
+
+		release_table_data(data2);
+	}
+
+	release_table_data(data);
+	release_table_data(copy);
+
+	get_table_cache_statistics(&entries, &hits, &misses, &bytes_cached, &bytes_saved);
+	CHECK(entries == 0);
+
+	close_files();
+
+	remove(filename);
+}
+
+// writes a float table with more than 2^31 values whose storage is allocated but not written
+// (a sparse file on most file systems) except for the last two rows
+static void make_sparse_table(HMODULE l, const char *filename, int nx, int ny) {
+
+	auto attach_scale = get<ModelicaSDF_attach_scale> (l, "ModelicaSDF_attach_scale");
+
+	std::vector<double> x(nx), y(ny);
+
+	for (int i = 0; i < nx; i++) x[i] = i;
+	for (int j = 0; j < ny; j++) y[j] = j;
+
+	std::vector<float> rows(2 * static_cast<size_t>(ny));
+
+	for (size_t k = 0; k < rows.size(); k++) rows[k] = static_cast<float>(k);
+
+	remove(filename);
+
+	hid_t file_id = H5Fcreate(filename, H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+	REQUIRE(file_id >= 0);
+
+	hsize_t x_dims[1] = { static_cast<hsize_t>(nx) }, y_dims[1] = { static_cast<hsize_t>(ny) };
+	REQUIRE(H5LTmake_dataset_double(file_id, "/X", 1, x_dims, x.data()) >= 0);
+	REQUIRE(H5LTmake_dataset_double(file_id, "/Y", 1, y_dims, y.data()) >= 0);
+
+	// contiguous storage that is allocated when the dataset is created and never filled
+	hsize_t t_dims[2] = { static_cast<hsize_t>(nx), static_cast<hsize_t>(ny) };
+	hid_t space_id = H5Screate_simple(2, t_dims, nullptr);
+	hid_t dcpl_id = H5Pcreate(H5P_DATASET_CREATE);
+	REQUIRE(H5Pset_alloc_time(dcpl_id, H5D_ALLOC_TIME_EARLY) >= 0);
+	REQUIRE(H5Pset_fill_time(dcpl_id, H5D_FILL_TIME_NEVER) >= 0);
+	hid_t dset_id = H5Dcreate2(file_id, "/T", H5T_IEEE_F32LE, space_id, H5P_DEFAULT, dcpl_id, H5P_DEFAULT);
+	REQUIRE(dset_id >= 0);
+
+	hsize_t start[2] = { static_cast<hsize_t>(nx - 2), 0 }, count[2] = { 2, static_cast<hsize_t>(ny) };
+	hid_t mem_space_id = H5Screate_simple(2, count, nullptr);
+	REQUIRE(H5Sselect_hyperslab(space_id, H5S_SELECT_SET, start, nullptr, count, nullptr) >= 0);
+	REQUIRE(H5Dwrite(dset_id, H5T_NATIVE_FLOAT, mem_space_id, space_id, H5P_DEFAULT, rows.data()) >= 0);
+
+	H5Sclose(mem_space_id);
+	H5Dclose(dset_id);
+	H5Pclose(dcpl_id);
+	H5Sclose(space_id);
+	H5Fclose(file_id);
+
+	REQUIRE_THAT(attach_scale(filename, "/T", "/X", "x", 0), Equals(""));
+	REQUIRE_THAT(attach_scale(filename, "/T", "/Y", "y", 1), Equals(""));
+}
+
+TEST_CASE("tables with more than 2^31 elements", "[functions]") {
+
+	// load the shared library
+# ifdef _WIN32
+	auto l = LoadLibraryA(SHARED_LIBRARY_PATH);
+# else
+	auto l = dlopen(SHARED_LIBRARY_PATH, RTLD_LAZY);
+# endif
+
+	REQUIRE(l != nullptr);
+
+	auto get_table_data_size   = get<ModelicaSDF_get_table_data_size>   (l, "ModelicaSDF_get_table_data_size");
+	auto get_table_data_size64 = get<ModelicaSDF_get_table_data_size64> (l, "ModelicaSDF_get_table_data_size64");
+	auto get_dataset_dims      = get<ModelicaSDF_get_dataset_dims>      (l, "ModelicaSDF_get_dataset_dims");
+	auto get_dataset_dims64    = get<ModelicaSDF_get_dataset_dims64>    (l, "ModelicaSDF_get_dataset_dims64");
+	auto acquire_table         = get<ModelicaSDF_acquire_table>         (l, "ModelicaSDF_acquire_table");
+	auto acquire_table_data    = get<ModelicaSDF_acquire_table_data>    (l, "ModelicaSDF_acquire_table_data");
+	auto release_table_data    = get<ModelicaSDF_release_table_data>    (l, "ModelicaSDF_release_table_data");
+	auto close_files           = get<ModelicaSDF_close_files>           (l, "ModelicaSDF_close_files");
+
+	// 65536 x 32769 = 2147549184 values (8 GB)
+	const auto filename = TESTS_DIR "sparse_table.sdf";
+	const int nx = 65536, ny = 32769;
+	const long long numel = static_cast<long long>(nx) * ny, nheader = 1 + 2 + nx + ny;
+	const char *scale_units[2] = { "", "" };
+
+	make_sparse_table(l, filename, nx, ny);
+
+	// the sizes that don't fit into an int are reported as errors
+	int size = -1;
+	CHECK_THAT(get_table_data_size(filename, "/T", &size), Equals("The table data of dataset '/T' in '" + std::string(filename) + "' has 2147647492 elements which exceeds the maximum of 2147483647"));
+	CHECK(size == 0);
+
+	long long size64 = -1;
+	CHECK_THAT(get_table_data_size64(filename, "/T", &size64), Equals(""));
+	CHECK(size64 == nheader + numel);
+
+	int dims[32] = { 0 };
+	CHECK_THAT(get_dataset_dims(filename, "/T", dims), Equals(""));
+	CHECK(dims[0] == nx);
+	CHECK(dims[1] == ny);
+
+	long long dims64[32] = { 0 };
+	CHECK_THAT(get_dataset_dims64(filename, "/T", dims64), Equals(""));
+	CHECK(dims64[0] == nx);
+	CHECK(dims64[1] == ny);
+
+	const double *data = nullptr;
+	CHECK_THAT(acquire_table_data(filename, "/T", 2, "", scale_units, &data, &size), ContainsSubstring("exceeds the maximum"));
+	CHECK(data == nullptr);
+
+	// the values are mapped from the file
+	const void *values = nullptr;
+	int single = 0;
+	REQUIRE_THAT(acquire_table(filename, "/T", 2, "", scale_units, &single, &data, &size64, &values), Equals(""));
+	CHECK(single == 1);
+	CHECK(size64 == nheader);
+	CHECK(data[1] == nx);
+	CHECK(data[2] == ny);
+
+	auto floats = static_cast<const float *>(values);
+	const size_t last_rows = static_cast<size_t>(nx - 2) * ny;
+	CHECK(floats[0] == 0);
+	CHECK(floats[last_rows - 1] == 0);
+	CHECK(floats[last_rows] == 0);
+	CHECK(floats[last_rows + 1] == 1);
+	CHECK(floats[static_cast<size_t>(numel) - 1] == 2 * ny - 1);
+
+	release_table_data(data);
+
+	close_files();
+
+	remove(filename);
+}
+
+TEST_CASE("benchmark map shared tables", "[.][benchmark]") {
+
+# ifdef _WIN32
+	auto l = LoadLibraryA(SHARED_LIBRARY_PATH);
+# else
+	auto l = dlopen(SHARED_LIBRARY_PATH, RTLD_LAZY);
+# endif
+
+	REQUIRE(l != nullptr);
+
+	auto acquire_table      = get<ModelicaSDF_acquire_table>      (l, "ModelicaSDF_acquire_table");
+	auto acquire_table_data = get<ModelicaSDF_acquire_table_data> (l, "ModelicaSDF_acquire_table_data");
+	auto release_table_data = get<ModelicaSDF_release_table_data> (l, "ModelicaSDF_release_table_data");
+	auto close_files        = get<ModelicaSDF_close_files>        (l, "ModelicaSDF_close_files");
+
+	// a table with 2000 x 2000 values (32 MB)
+	const auto filename = TESTS_DIR "large_table.sdf";
+	const char *scale_units[2] = { "", "" };
+
+	make_large_table(l, filename, 2000, 2000, false);
+
+	BENCHMARK("acquire 32 MB table (read)") {
+		const double *data = nullptr;
+		int size = 0;
+		acquire_table_data(filename, "/T", 2, "", scale_units, &data, &size);
+		const double value = data[size - 1];
+		release_table_data(data);
+		return value;
+	};
+
+	BENCHMARK("acquire 32 MB table (mapped)") {
+		const double *data = nullptr;
+		const void *values = nullptr;
+		long long size = 0;
+		int single = 0;
+		acquire_table(filename, "/T", 2, "", scale_units, &single, &data, &size, &values);
+		const double value = static_cast<const double *>(values)[2000 * 2000 - 1];
+		release_table_data(data);
+		return value;
+	};
+
+	BENCHMARK("acquire 32 MB table (mapped, touch all pages)") {
+		const double *data = nullptr;
+		const void *values = nullptr;
+		long long size = 0;
+		int single = 0;
+		double sum = 0;
+		acquire_table(filename, "/T", 2, "", scale_units, &single, &data, &size, &values);
+		for (int k = 0; k < 2000 * 2000; k += 512) sum += static_cast<const double *>(values)[k];
+		release_table_data(data);
+		return sum;
+	};
+
+	close_files();
+
+	remove(filename);
+}
+
+TEST_CASE("keep files open", "[functions]") {
+
+	// load the shared library
+# ifdef _WIN32
+	auto l = LoadLibraryA(SHARED_LIBRARY_PATH);
+# else
+	auto l = dlopen(SHARED_LIBRARY_PATH, RTLD_LAZY);
+# endif
+
+	REQUIRE(l != nullptr);
+
+	auto make_dataset_double = get<ModelicaSDF_make_dataset_double> (l, "ModelicaSDF_make_dataset_double");
+	auto read_dataset_double = get<ModelicaSDF_read_dataset_double> (l, "ModelicaSDF_read_dataset_double");
+	auto close_files         = get<ModelicaSDF_close_files>         (l, "ModelicaSDF_close_files");
+
+	const auto filename = TESTS_DIR "pool.sdf";
+
+	double value = 1, buffer = 0;
+
+	remove(filename);
+
+	CHECK_THAT(make_dataset_double(filename, "/DS1", 0, nullptr, &value, "", "", "", "", 0), Equals(""));
+
+	CHECK_THAT(read_dataset_double(filename, "/DS1", "", &buffer), Equals(""));
+	CHECK(buffer == 1);
+
+	SECTION("write to an open file") {
+
+		value = 2;
+		CHECK_THAT(make_dataset_double(filename, "/DS1", 0, nullptr, &value, "", "", "", "", 0), Equals(""));
+
+		CHECK_THAT(read_dataset_double(filename, "/DS1", "", &buffer), Equals(""));
+		CHECK(buffer == 2);
+	}
+
+	SECTION("read a replaced file") {
+
+		const auto other = TESTS_DIR "pool2.sdf";
+
+		value = 3;
+		remove(other);
+		CHECK_THAT(make_dataset_double(other, "/DS1", 0, nullptr, &value, "", "", "", "", 0), Equals(""));
+		CHECK_THAT(make_dataset_double(other, "/DS2", 0, nullptr, &value, "", "", "", "", 0), Equals(""));
+
+		// replace the file while it is open
+		REQUIRE(remove(filename) == 0);
+		REQUIRE(rename(other, filename) == 0);
+
+		CHECK_THAT(read_dataset_double(filename, "/DS1", "", &buffer), Equals(""));
+		CHECK(buffer == 3);
+	}
+
+	SECTION("read more files than are kept open") {
+
+		for (int i = 0; i < 20; i++) {
+			const std::string name = std::string(TESTS_DIR "pool") + std::to_string(i) + ".sdf";
+			value = i;
+			remove(name.c_str());
+			CHECK_THAT(make_dataset_double(name.c_str(), "/DS1", 0, nullptr, &value, "", "", "", "", 0), Equals(""));
+		}
+
+		for (int k = 0; k < 3; k++) {
+			for (int i = 0; i < 20; i++) {
+				const std::string name = std::string(TESTS_DIR "pool") + std::to_string(i) + ".sdf";
+				CHECK_THAT(read_dataset_double(name.c_str(), "/DS1", "", &buffer), Equals(""));
+				CHECK(buffer == i);
+			}
+		}
+
+		close_files();
+
+		for (int i = 0; i < 20; i++) {
+			const std::string name = std::string(TESTS_DIR "pool") + std::to_string(i) + ".sdf";
+			remove(name.c_str());
+		}
+	}
+
+	close_files();
+
+	remove(filename);
+}
+
+
+TEST_CASE("benchmark keep files open", "[.][benchmark]") {
+
+# ifdef _WIN32
+	auto l = LoadLibraryA(SHARED_LIBRARY_PATH);
+# else
+	auto l = dlopen(SHARED_LIBRARY_PATH, RTLD_LAZY);
+# endif
+
+	REQUIRE(l != nullptr);
+
+	auto make_dataset_double = get<ModelicaSDF_make_dataset_double> (l, "ModelicaSDF_make_dataset_double");
+	auto read_dataset_double = get<ModelicaSDF_read_dataset_double> (l, "ModelicaSDF_read_dataset_double");
+	auto close_files         = get<ModelicaSDF_close_files>         (l, "ModelicaSDF_close_files");
+
+	const auto filename = TESTS_DIR "pool.sdf";
+
+	remove(filename);
+
+	for (int i = 0; i < 100; i++) {
+		const std::string name = "/P" + std::to_string(i);
+		double value = i;
+		make_dataset_double(filename, name.c_str(), 0, nullptr, &value, "", "", "U", "", 0);
+	}
+
+	BENCHMARK("read 100 parameters (reopen)") {
+		double sum = 0, value;
+		for (int i = 0; i < 100; i++) {
+			const std::string name = "/P" + std::to_string(i);
+			close_files();
+			read_dataset_double(filename, name.c_str(), "U", &value);
+			sum += value;
+		}
+		return sum;
+	};
+
+	BENCHMARK("read 100 parameters (keep open)") {
+		double sum = 0, value;
+		for (int i = 0; i < 100; i++) {
+			const std::string name = "/P" + std::to_string(i);
+			read_dataset_double(filename, name.c_str(), "U", &value);
+			sum += value;
+		}
+		return sum;
+	};
+
+	close_files();
+
+	remove(filename);
+}
+
+
+// writes a column-major matrix to a MAT 4 file (type 0: double, 51: text)
+void write_mat4(FILE *f, const char *name, int type, int mrows, int ncols, const void *data) {
+
+	const int header[5] = { type, mrows, ncols, 0, static_cast<int>(strlen(name) + 1) };
+
+	fwrite(header, sizeof(int), 5, f);
+	fwrite(name, 1, strlen(name) + 1, f);
+	fwrite(data, type == 51 ? 1 : sizeof(double), static_cast<size_t>(mrows) * ncols, f);
+}
+
+// writes a string matrix with one string per row (or column if trans)
+void write_mat4_strings(FILE *f, const char *name, const std::vector<std::string> &strings, bool trans) {
+
+	size_t len = 1;
+
+	for (auto &s : strings) {
+		len = std::max(len, s.size());
+	}
+
+	const size_t n = strings.size();
+	std::vector<char> data(n * len, ' ');
+
+	for (size_t i = 0; i < n; i++) {
+		for (size_t j = 0; j < strings[i].size(); j++) {
+			data[trans ? (i * len + j) : (j * n + i)] = strings[i][j];
+		}
+	}
+
+	if (trans) {
+		write_mat4(f, name, 51, static_cast<int>(len), static_cast<int>(n), data.data());
+	} else {
+		write_mat4(f, name, 51, static_cast<int>(n), static_cast<int>(len), data.data());
+	}
+}
+
+// a synthetic Dymola result with the variables "Time" and "c<k>.x" (k = 1...nvars-1)
+struct SyntheticDsres {
+
+	int nvars, nsamples;
+
+	// variable k: every 10th is a constant, every 7th is negated and every 5th is an alias of the previous one
+	static bool is_constant(int k) { return k % 10 == 0; }
+	static int sign(int k) { return k % 7 == 0 ? -1 : 1; }
+	static int base(int k) { return k % 5 == 4 ? k - 1 : k; }
+	static std::string name(int k) { return k == 0 ? "Time" : "c" + std::to_string(k) + ".x"; }
+	static std::string unit(int k) { return k == 0 ? "s" : (k % 3 == 0 ? "m" : "V"); }
+
+	double value(int k, int j) const {
+		const int b = base(k);
+		return k == 0 ? 0.1 * j : sign(k) * (is_constant(b) ? b : b + 0.001 * j);
+	}
+
+	SyntheticDsres(const char *filename, bool trans, int nvars, int nsamples) : nvars(nvars), nsamples(nsamples) {
+
+		FILE *f = fopen(filename, "wb");
+
+		write_mat4_strings(f, "Aclass", { "Atrajectory", "1.1", "", trans ? "binTrans" : "binNormal" }, false);
+
+		std::vector<std::string> names, descriptions;
+		std::vector<double> info(4 * nvars, 0), data_1, data_2;
+		int n1 = 0, n2 = 1;
+
+		for (int k = 0; k < nvars; k++) {
+			names.push_back(name(k));
+			descriptions.push_back("Variable " + std::to_string(k) + " [" + unit(k) + "]");
+		}
+
+		// the columns of the variables
+		std::vector<int> block(nvars), column(nvars);
+
+		for (int k = 0; k < nvars; k++) {
+			if (k > 0 && base(k) != k) {
+				block[k] = block[base(k)];
+				column[k] = column[base(k)];
+			} else {
+				block[k] = k == 0 ? 0 : (is_constant(k) ? 1 : 2);
+				column[k] = k == 0 ? 1 : (is_constant(k) ? ++n1 : ++n2);
+			}
+			info[trans ? 4 * k : k] = block[k];
+			info[trans ? 4 * k + 1 : nvars + k] = sign(k) * column[k];
+		}
+
+		data_1.resize(2 * n1);
+		data_2.resize(static_cast<size_t>(n2) * nsamples);
+
+		for (int k = 0; k < nvars; k++) {
+			const int c = column[k] - 1;
+			if (base(k) != k) {
+				continue;
+			} else if (block[k] == 1) {
+				data_1[trans ? c : 2 * c] = value(k, 0) * sign(k);
+				data_1[trans ? n1 + c : 2 * c + 1] = value(k, 0) * sign(k);
+			} else {
+				for (int j = 0; j < nsamples; j++) {
+					data_2[trans ? (static_cast<size_t>(j) * n2 + c) : (static_cast<size_t>(c) * nsamples + j)] = value(k, j) * (k == 0 ? 1 : sign(k));
+				}
+			}
+		}
+
+		write_mat4_strings(f, "name", names, trans);
+		write_mat4_strings(f, "description", descriptions, trans);
+
+		if (trans) {
+			write_mat4(f, "dataInfo", 0, 4, nvars, info.data());
+			write_mat4(f, "data_1", 0, n1, 2, data_1.data());
+			write_mat4(f, "data_2", 0, n2, nsamples, data_2.data());
+		} else {
+			write_mat4(f, "dataInfo", 0, nvars, 4, info.data());
+			write_mat4(f, "data_1", 0, 2, n1, data_1.data());
+			write_mat4(f, "data_2", 0, nsamples, n2, data_2.data());
+		}
+
+		fclose(f);
+	}
+};
+
+
+TEST_CASE("read synthetic result files", "[functions]") {
+
+	// load the shared library
+# ifdef _WIN32
+	auto l = LoadLibraryA(SHARED_LIBRARY_PATH);
+# else
+	auto l = dlopen(SHARED_LIBRARY_PATH, RTLD_LAZY);
+# endif
+
+	REQUIRE(l != nullptr);
+
+	auto get_time_series_size = get<ModelicaSDF_get_time_series_size> (l, "ModelicaSDF_get_time_series_size");
+	auto read_time_series     = get<ModelicaSDF_read_time_series>     (l, "ModelicaSDF_read_time_series");
+	auto get_alias_statistics = get<ModelicaSDF_get_alias_statistics> (l, "ModelicaSDF_get_alias_statistics");
+	auto close_files          = get<ModelicaSDF_close_files>          (l, "ModelicaSDF_close_files");
+
+	const auto filename = TESTS_DIR "synthetic.mat";
+
+	for (bool trans : { true, false }) {
+
+		SyntheticDsres dsres(filename, trans, 100, 5);
+
+		// with aliases (4, 3), (14, 13) and (99, 98)
+		const std::vector<int> vars = { 1, 10, 4, 14, 70, 99, 2, 3, 13, 98 };
+		std::vector<std::string> names, units;
+		std::vector<const char *> name_ptrs, unit_ptrs;
+
+		for (int k : vars) {
+			names.push_back("/c" + std::to_string(k) + "/x");
+			units.push_back(SyntheticDsres::unit(k));
+		}
+
+		for (size_t i = 0; i < vars.size(); i++) {
+			name_ptrs.push_back(names[i].c_str());
+			unit_ptrs.push_back(units[i].c_str());
+		}
+
+		int size = -1;
+		REQUIRE_THAT(get_time_series_size(filename, name_ptrs.data(), &size), Equals(""));
+		REQUIRE(size == 5);
+
+		// read twice to use the index of the file
+		for (int r = 0; r < 2; r++) {
+
+			std::vector<double> data(size * (vars.size() + 1), -1);
+
+			REQUIRE_THAT(read_time_series(filename, static_cast<int>(vars.size()), name_ptrs.data(), unit_ptrs.data(), "s", size, data.data()), Equals(""));
+
+			for (int j = 0; j < size; j++) {
+				CHECK(data[j * (vars.size() + 1)] == dsres.value(0, j));
+				for (size_t i = 0; i < vars.size(); i++) {
+					CHECK(data[j * (vars.size() + 1) + i + 1] == dsres.value(vars[i], j));
+				}
+			}
+		}
+
+		// read all variables (with ranges that are read at once)
+		std::vector<std::string> all_names;
+		std::vector<const char *> all_name_ptrs, all_unit_ptrs;
+
+		for (int k = 1; k < 100; k++) {
+			all_names.push_back("/c" + std::to_string(k) + "/x");
+		}
+
+		for (auto &name : all_names) {
+			all_name_ptrs.push_back(name.c_str());
+			all_unit_ptrs.push_back("");
+		}
+
+		std::vector<double> all(size * 100, -1);
+
+		REQUIRE_THAT(read_time_series(filename, 99, all_name_ptrs.data(), all_unit_ptrs.data(), "", size, all.data()), Equals(""));
+
+		for (int j = 0; j < size; j++) {
+			for (int k = 0; k < 100; k++) {
+				CHECK(all[j * 100 + k] == dsres.value(k, j));
+			}
+		}
+
+		std::vector<int> aliases(vars.size());
+		int nvariables = 0, ncolumns = 0;
+
+		REQUIRE_THAT(get_alias_statistics(filename, static_cast<int>(vars.size()), name_ptrs.data(), aliases.data(), &nvariables, &ncolumns), Equals(""));
+		CHECK(aliases == std::vector<int>({ 1, 2, 3, 4, 5, 6, 7, 3, -4, -6 }));
+		CHECK(nvariables == 100);
+		CHECK(ncolumns == 79);  // 100 variables without "Time" and the 20 aliases
+
+		const char *unknown[1] = { "/c1.x" };
+		const char *no_unit[1] = { "" };
+		double buffer[5][2];
+
+		CHECK_THAT(read_time_series(filename, 1, unknown, no_unit, "", size, &buffer[0][0]), Equals("Variable '/c1.x' was not found in '" TESTS_DIR "synthetic.mat'"));
+
+		const char *wrong_unit[1] = { "A" };
+
+		CHECK_THAT(read_time_series(filename, 1, name_ptrs.data(), wrong_unit, "", size, &buffer[0][0]), Equals("Variable '/c1/x' in '" TESTS_DIR "synthetic.mat' has the wrong unit. Expected 'A' but was 'V'."));
+
+		close_files();
+	}
+
+	const char *name[1] = { "/DS1" };
+	int alias = 0, nvariables = 0, ncolumns = 0;
+
+	CHECK_THAT(get_alias_statistics(TESTS_DIR "test.sdf", 1, name, &alias, &nvariables, &ncolumns), Equals("'" TESTS_DIR "test.sdf' is not a Dymola result file"));
+
+	remove(filename);
+}
+
+
+TEST_CASE("benchmark read synthetic result files", "[.][benchmark]") {
+
+# ifdef _WIN32
+	auto l = LoadLibraryA(SHARED_LIBRARY_PATH);
+# else
+	auto l = dlopen(SHARED_LIBRARY_PATH, RTLD_LAZY);
+# endif
+
+	REQUIRE(l != nullptr);
+
+	auto read_time_series = get<ModelicaSDF_read_time_series> (l, "ModelicaSDF_read_time_series");
+
+	const auto filename = TESTS_DIR "synthetic.mat";
+	const int nvars = 200000, nsamples = 10, nrequested = 2000;
+
+	SyntheticDsres dsres(filename, true, nvars, nsamples);
+
+	std::vector<std::string> names;
+	std::vector<const char *> name_ptrs, unit_ptrs;
+
+	for (int i = 0; i < nrequested; i++) {
+		names.push_back("/c" + std::to_string(1 + (i * 7919) % (nvars - 1)) + "/x");
+	}
+
+	for (auto &name : names) {
+		name_ptrs.push_back(name.c_str());
+		unit_ptrs.push_back("");
+	}
+
+	std::vector<double> data(nsamples * (nrequested + 1));
+
+	BENCHMARK("read 2000 of 200000 variables") {
+		return read_time_series(filename, nrequested, name_ptrs.data(), unit_ptrs.data(), "", nsamples, data.data());
+	};
+
+	remove(filename);
+}
+
+TEST_CASE("benchmark extract trajectories", "[.][benchmark]") {
+
+# ifdef _WIN32
+	auto l = LoadLibraryA(SHARED_LIBRARY_PATH);
+# else
+	auto l = dlopen(SHARED_LIBRARY_PATH, RTLD_LAZY);
+# endif
+
+	REQUIRE(l != nullptr);
+
+	auto read_time_series = get<ModelicaSDF_read_time_series> (l, "ModelicaSDF_read_time_series");
+
+	const auto filename = TESTS_DIR "synthetic.mat";
+	const int nvars = 10001, nsamples = 1000;
+
+	std::vector<std::string> names;
+	std::vector<const char *> name_ptrs, unit_ptrs;
+
+	for (int k = 1; k < nvars; k++) {
+		names.push_back("/c" + std::to_string(k) + "/x");
+	}
+
+	for (auto &name : names) {
+		name_ptrs.push_back(name.c_str());
+		unit_ptrs.push_back("");
+	}
+
+	std::vector<double> data(static_cast<size_t>(nsamples) * nvars);
+
+	for (bool trans : { true, false }) {
+
+		SyntheticDsres dsres(filename, trans, nvars, nsamples);
+
+		// GB/s = 8 * nsamples * (nrequested + 1) / mean
+		for (int nrequested : { 10, 100, 10000 }) {
+
+			const auto name = std::string(trans ? "binTrans" : "binNormal") + ", " + std::to_string(nrequested) + " columns (" + 
+				std::to_string(8 * nsamples * (nrequested + 1) / 1000) + " kB)";
+
+			BENCHMARK(name.c_str()) {
+				return read_time_series(filename, nrequested, name_ptrs.data(), unit_ptrs.data(), "", nsamples, data.data());
+			};
+		}
+	}
+
+	remove(filename);
+}
+
+TEST_CASE("concurrent reads and writes", "[functions]") {
+
+	// load the shared library
+# ifdef _WIN32
+	auto l = LoadLibraryA(SHARED_LIBRARY_PATH);
+# else
+	auto l = dlopen(SHARED_LIBRARY_PATH, RTLD_LAZY);
+# endif
+
+	REQUIRE(l != nullptr);
+
+	auto append_rows         = get<ModelicaSDF_append_rows>         (l, "ModelicaSDF_append_rows");
+	auto read_time_series    = get<ModelicaSDF_read_time_series>    (l, "ModelicaSDF_read_time_series");
+	auto make_dataset_double = get<ModelicaSDF_make_dataset_double> (l, "ModelicaSDF_make_dataset_double");
+	auto read_dataset_double = get<ModelicaSDF_read_dataset_double> (l, "ModelicaSDF_read_dataset_double");
+	auto close_files         = get<ModelicaSDF_close_files>         (l, "ModelicaSDF_close_files");
+
+	const auto sdf_filename = TESTS_DIR "concurrent.sdf";
+	const auto mat_filename = TESTS_DIR "concurrent.mat";
+	const int nrows = 5000, nvars = 20, nsamples = 1000;
+
+	remove(sdf_filename);
+
+	const char *sdf_names[2] = { "/x", "/y" };
+	const char *sdf_units[2] = { "m", "" };
+
+	std::vector<double> rows(nrows * 3);
+
+	for (int j = 0; j < nrows; j++) {
+		rows[j * 3] = 0.01 * j;
+		rows[j * 3 + 1] = 2.0 * j;
+		rows[j * 3 + 2] = -1.0 * j;
+	}
+
+	REQUIRE_THAT(append_rows(sdf_filename, "/time", "s", 2, sdf_names, sdf_units, nrows, rows.data()), Equals(""));
+
+	close_files();
+
+	SyntheticDsres dsres(mat_filename, true, nvars, nsamples);
+
+	const char *mat_names[2] = { "/c1/x", "/c7/x" };
+	const char *mat_units[2] = { "", "" };
+
+	const int nthreads = 8, iterations = 50;
+
+	std::atomic<int> failures(0);
+	std::vector<std::thread> threads;
+
+	// every thread reads both time series and writes and reads its own file
+	// (the readers share the file pool and the index of the dsres file, so this test
+	// must also pass without reports in a build with -fsanitize=thread)
+	for (int t = 0; t < nthreads; t++) {
+		threads.emplace_back([&, t]() {
+
+			const std::string filename = TESTS_DIR "concurrent" + std::to_string(t) + ".sdf";
+			std::vector<double> data(nrows * 3);
+
+			for (int i = 0; i < iterations; i++) {
+
+				if (strlen(read_time_series(sdf_filename, 2, sdf_names, sdf_units, "s", nrows, data.data())) > 0 || data != rows) {
+					failures++;
+				}
+
+				if (strlen(read_time_series(mat_filename, 2, mat_names, mat_units, "s", nsamples, data.data())) > 0) {
+					failures++;
+				} else {
+					for (int j = 0; j < nsamples; j++) {
+						if (data[j * 3] != dsres.value(0, j) || data[j * 3 + 1] != dsres.value(1, j) || data[j * 3 + 2] != dsres.value(7, j)) {
+							failures++;
+							break;
+						}
+					}
+				}
+
+				int dims[1] = { 1 };
+				double value = t * 1000 + i, read_value = -1;
+
+				if (strlen(make_dataset_double(filename.c_str(), "/value", 1, dims, &value, "", "", "", "", 0)) > 0 ||
+					strlen(read_dataset_double(filename.c_str(), "/value", "", &read_value)) > 0 || read_value != value) {
+					failures++;
+				}
+			}
+
+			close_files();
+			remove(filename.c_str());
+		});
+	}
+
+	for (auto &thread : threads) {
+		thread.join();
+	}
+
+	CHECK(failures == 0);
+
+	close_files();
+
+	remove(sdf_filename);
+	remove(mat_filename);
+}
+
+TEST_CASE("benchmark concurrent reads", "[.][benchmark]") {
+
+# ifdef _WIN32
+	auto l = LoadLibraryA(SHARED_LIBRARY_PATH);
+# else
+	auto l = dlopen(SHARED_LIBRARY_PATH, RTLD_LAZY);
+# endif
+
+	REQUIRE(l != nullptr);
+
+	auto append_rows      = get<ModelicaSDF_append_rows>      (l, "ModelicaSDF_append_rows");
+	auto read_time_series = get<ModelicaSDF_read_time_series> (l, "ModelicaSDF_read_time_series");
+	auto close_files      = get<ModelicaSDF_close_files>      (l, "ModelicaSDF_close_files");
+
+	const auto sdf_filename = TESTS_DIR "concurrent.sdf";
+	const auto mat_filename = TESTS_DIR "concurrent.mat";
+
+	// 8 reads of 10 signals with 100000 samples
+	const int nreads = 8, nsignals = 10, nsamples = 100000;
+
+	std::vector<std::string> sdf_names, mat_names;
+	std::vector<const char *> sdf_name_ptrs, mat_name_ptrs, unit_ptrs;
+
+	for (int i = 0; i < nsignals; i++) {
+		sdf_names.push_back("/s" + std::to_string(i));
+		mat_names.push_back("/c" + std::to_string(i + 1) + "/x");
+	}
+
+	for (int i = 0; i < nsignals; i++) {
+		sdf_name_ptrs.push_back(sdf_names[i].c_str());
+		mat_name_ptrs.push_back(mat_names[i].c_str());
+		unit_ptrs.push_back("");
+	}
+
+	std::vector<double> rows(static_cast<size_t>(nsamples) * (nsignals + 1), 1.0);
+
+	remove(sdf_filename);
+
+	REQUIRE_THAT(append_rows(sdf_filename, "/time", "s", nsignals, sdf_name_ptrs.data(), unit_ptrs.data(), nsamples, rows.data()), Equals(""));
+
+	close_files();
+
+	SyntheticDsres dsres(mat_filename, true, nsignals + 1, nsamples);
+
+	std::vector<std::vector<double>> data(nreads, std::vector<double>(rows.size()));
+
+	auto read = [&](const char *filename, std::vector<const char *> &names, int i) {
+		return read_time_series(filename, nsignals, names.data(), unit_ptrs.data(), "", nsamples, data[i].data());
+	};
+
+	auto read_parallel = [&](const char *filename, std::vector<const char *> &names) {
+		std::vector<std::thread> threads;
+		for (int i = 0; i < nreads; i++) {
+			threads.emplace_back([&, i]() { read(filename, names, i); });
+		}
+		for (auto &thread : threads) {
+			thread.join();
+		}
+		return data[0][0];
+	};
+
+	BENCHMARK("8 SDF reads (1 thread)") {
+		for (int i = 0; i < nreads; i++) {
+			read(sdf_filename, sdf_name_ptrs, i);
+		}
+		return data[0][0];
+	};
+
+	BENCHMARK("8 SDF reads (8 threads)") {
+		return read_parallel(sdf_filename, sdf_name_ptrs);
+	};
+
+	BENCHMARK("8 MAT reads (1 thread)") {
+		for (int i = 0; i < nreads; i++) {
+			read(mat_filename, mat_name_ptrs, i);
+		}
+		return data[0][0];
+	};
+
+	BENCHMARK("8 MAT reads (8 threads)") {
+		return read_parallel(mat_filename, mat_name_ptrs);
+	};
+
+	close_files();
+
+	remove(sdf_filename);
+	remove(mat_filename);
+}
@@ -0,0 +1,1375 @@
+#define CATCH_CONFIG_MAIN
+
+#include "catch_amalgamated.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
+
+#include "NDTable.h"
+
+using namespace Catch::Matchers;
+
+
+// a table with the given dimensions and scales 0, 1, 4, 9, ... and smooth, non-monotonic data
+struct TestTable {
+
+	std::vector<std::vector<double>> scales;
+	std::vector<double> data;
+	NDTable_h table = nullptr;
+
+	explicit TestTable(const std::vector<int> &dims) {
+
+		const int ndims = static_cast<int>(dims.size());
+		const double *scale_ptrs[MAX_NDIMS];
+		int numel = 1;
+
+		for (int i = 0; i < ndims; i++) {
+			std::vector<double> scale;
+			for (int j = 0; j < dims[i]; j++) {
+				scale.push_back(j * (j + 1) * 0.5);
+			}
+			scales.push_back(scale);
+			numel *= dims[i];
+		}
+
+		for (int i = 0; i < ndims; i++) {
+			scale_ptrs[i] = scales[i].data();
+		}
+
+		for (int k = 0; k < numel; k++) {
+			double v = 0;
+			int n = k;
+			for (int i = ndims - 1; i >= 0; i--) {
+				v += std::sin(0.7 * scales[i][n % dims[i]] + i);
+				n /= dims[i];
+			}
+			data.push_back(v);
+		}
+
+		table = NDTable_create_table(ndims, dims.data(), data.data(), scale_ptrs);
+	}
+
+	~TestTable() {
+		NDTable_free_table(table);
+	}
+
+	// sample points that cover the whole range including extrapolation
+	std::vector<std::vector<double>> samples(int n) const {
+		std::vector<std::vector<double>> points;
+		for (int k = 0; k < n; k++) {
+			std::vector<double> p;
+			for (size_t i = 0; i < scales.size(); i++) {
+				const double min = scales[i].front(), max = scales[i].back();
+				const double s = std::fmod(0.37 * k + 0.13 * i, 1.2) - 0.1;
+				p.push_back(min + s * (max - min));
+			}
+			points.push_back(p);
+		}
+		return points;
+	}
+};
+
+
+TEST_CASE("precomputed spline coefficients", "[interpolation]") {
+
+	const NDTable_InterpMethod_t methods[] = { NDTABLE_INTERP_AKIMA, NDTABLE_INTERP_FRITSCH_BUTLAND, NDTABLE_INTERP_STEFFEN };
+	const std::vector<std::vector<int>> shapes = { { 9 }, { 2 }, { 3 }, { 7, 5 }, { 4, 3, 5, 6 }, { 5, 1 } };
+
+	for (auto &dims : shapes) {
+
+		TestTable a(dims), b(dims);
+
+		REQUIRE(a.table != nullptr);
+		REQUIRE(b.table != nullptr);
+
+		const int ndims = static_cast<int>(dims.size());
+		const auto points = a.samples(200);
+		const double delta[4] = { 1.0, 0.5, -0.25, 2.0 };
+
+		for (auto method : methods) {
+
+			REQUIRE(NDTable_precompute_coefficients(b.table, method) == 0);
+
+			for (auto &p : points) {
+				double v1 = 0, v2 = 0;
+
+				REQUIRE(NDTable_evaluate(a.table, ndims, p.data(), method, NDTABLE_EXTRAP_LINEAR, &v1) == 0);
+				REQUIRE(NDTable_evaluate(b.table, ndims, p.data(), method, NDTABLE_EXTRAP_LINEAR, &v2) == 0);
+				CHECK(v1 == v2);
+
+				REQUIRE(NDTable_evaluate_derivative(a.table, ndims, p.data(), delta, method, NDTABLE_EXTRAP_LINEAR, &v1) == 0);
+				REQUIRE(NDTable_evaluate_derivative(b.table, ndims, p.data(), delta, method, NDTABLE_EXTRAP_LINEAR, &v2) == 0);
+				CHECK(v1 == v2);
+			}
+		}
+	}
+
+	SECTION("non-finite values") {
+
+		TestTable a({ 8 }), b({ 8 });
+
+		a.data[3] = NAN;
+		b.data[3] = NAN;
+
+		NDTable_free_table(a.table);
+		NDTable_free_table(b.table);
+
+		const double *scales_a[1] = { a.scales[0].data() };
+		const double *scales_b[1] = { b.scales[0].data() };
+		const int dims[1] = { 8 };
+
+		a.table = NDTable_create_table(1, dims, a.data.data(), scales_a);
+		b.table = NDTable_create_table(1, dims, b.data.data(), scales_b);
+
+		REQUIRE(NDTable_precompute_coefficients(b.table, NDTABLE_INTERP_AKIMA) == 0);
+
+		for (double x = 0; x <= 28; x += 0.5) {
+			double v1 = 0, v2 = 0;
+			NDTable_evaluate(a.table, 1, &x, NDTABLE_INTERP_AKIMA, NDTABLE_EXTRAP_HOLD, &v1);
+			NDTable_evaluate(b.table, 1, &x, NDTABLE_INTERP_AKIMA, NDTABLE_EXTRAP_HOLD, &v2);
+			CHECK(std::isnan(v1) == std::isnan(v2));
+			if (!std::isnan(v1)) {
+				CHECK(v1 == v2);
+			}
+		}
+	}
+
+	SECTION("other methods are not precomputed") {
+
+		TestTable a({ 5 });
+
+		REQUIRE(NDTable_precompute_coefficients(a.table, NDTABLE_INTERP_LINEAR) == 0);
+		CHECK(a.table->coeffs == nullptr);
+	}
+}
+
+
+TEST_CASE("benchmark precomputed spline coefficients", "[.][benchmark]") {
+
+	const std::vector<std::vector<int>> shapes = { { 1000 }, { 100, 100 }, { 10, 10, 10, 10 } };
+
+	for (auto &dims : shapes) {
+
+		TestTable a(dims), b(dims);
+
+		const int ndims = static_cast<int>(dims.size());
+		const auto points = a.samples(1024);
+		const std::string name = std::to_string(ndims) + "-D Akima";
+
+		REQUIRE(NDTable_precompute_coefficients(b.table, NDTABLE_INTERP_AKIMA) == 0);
+
+		BENCHMARK(name + " (on the fly, 1024 evaluations)") {
+			double sum = 0, v;
+			for (auto &p : points) {
+				NDTable_evaluate(a.table, ndims, p.data(), NDTABLE_INTERP_AKIMA, NDTABLE_EXTRAP_HOLD, &v);
+				sum += v;
+			}
+			return sum;
+		};
+
+		BENCHMARK(name + " (precomputed, 1024 evaluations)") {
+			double sum = 0, v;
+			for (auto &p : points) {
+				NDTable_evaluate(b.table, ndims, p.data(), NDTABLE_INTERP_AKIMA, NDTABLE_EXTRAP_HOLD, &v);
+				sum += v;
+			}
+			return sum;
+		};
+	}
+}
+
+
+// evaluate the table with the recursive NDTable_evaluate_internal()
+static int evaluate_recursive(NDTable_h table, const double params[], NDTable_InterpMethod_t interp_method, NDTable_ExtrapMethod_t extrap_method, double *value) {
+
+	double t[MAX_NDIMS];
+	int subs[MAX_NDIMS], nsubs[MAX_NDIMS];
+	double derivatives[MAX_NDIMS];
+
+	for (int i = 0; i < table->ndims; i++) {
+		subs[i] = 0;
+		NDTable_find_index(params[i], table->dims[i], table->scales[i], &subs[i], &t[i], extrap_method);
+	}
+
+	return NDTable_evaluate_internal(table, t, subs, nsubs, 0, interp_method, extrap_method, value, derivatives);
+}
+
+
+TEST_CASE("iterative evaluation", "[interpolation]") {
+
+	const NDTable_InterpMethod_t interp_methods[] = { NDTABLE_INTERP_HOLD, NDTABLE_INTERP_NEAREST, NDTABLE_INTERP_LINEAR };
+	const NDTable_ExtrapMethod_t extrap_methods[] = { NDTABLE_EXTRAP_HOLD, NDTABLE_EXTRAP_LINEAR, NDTABLE_EXTRAP_NONE };
+	const std::vector<std::vector<int>> shapes = { { 9 }, { 7, 5 }, { 4, 1, 3 }, { 4, 3, 5, 6 }, { 3, 2, 2, 3, 2, 2, 2, 2, 2, 3 } };
+
+	for (auto &dims : shapes) {
+
+		TestTable a(dims);
+
+		const int ndims = static_cast<int>(dims.size());
+		const auto points = a.samples(100);
+
+		for (auto interp_method : interp_methods) {
+			for (auto extrap_method : extrap_methods) {
+				for (auto &p : points) {
+					double v1 = 0, v2 = 0;
+
+					const int status1 = NDTable_evaluate(a.table, ndims, p.data(), interp_method, extrap_method, &v1);
+					const int status2 = evaluate_recursive(a.table, p.data(), interp_method, extrap_method, &v2);
+
+					REQUIRE(status1 == status2);
+
+					if (status1 == 0) {
+						CHECK_THAT(v1, WithinRel(v2, 1e-12) || WithinAbs(v2, 1e-12));
+					}
+				}
+			}
+		}
+	}
+
+	SECTION("non-finite values") {
+
+		TestTable a({ 4, 4 });
+
+		a.table->data[5] = INFINITY;
+
+		double p[2] = { 1.5, 1.5 }, v = 0;
+		REQUIRE(NDTable_evaluate(a.table, 2, p, NDTABLE_INTERP_LINEAR, NDTABLE_EXTRAP_HOLD, &v) == 0);
+		CHECK(std::isnan(v));
+
+		p[0] = 0.0;
+		p[1] = 0.0;
+		REQUIRE(NDTable_evaluate(a.table, 2, p, NDTABLE_INTERP_LINEAR, NDTABLE_EXTRAP_HOLD, &v) == 0);
+		CHECK(std::isnan(v));
+
+		REQUIRE(NDTable_evaluate(a.table, 2, p, NDTABLE_INTERP_NEAREST, NDTABLE_EXTRAP_HOLD, &v) == 0);
+		CHECK(v == a.data[0]);
+	}
+}
+
+
+TEST_CASE("benchmark iterative evaluation", "[.][benchmark]") {
+
+	const std::vector<std::vector<int>> shapes = { { 20, 20, 20 }, { 10, 10, 10, 10 }, { 8, 8, 8, 8, 8 }, { 5, 5, 5, 5, 5, 5 } };
+
+	for (auto &dims : shapes) {
+
+		TestTable a(dims);
+
+		const int ndims = static_cast<int>(dims.size());
+		const auto points = a.samples(1024);
+		const std::string name = std::to_string(ndims) + "-D linear";
+
+		BENCHMARK(name + " (recursive, 1024 evaluations)") {
+			double sum = 0, v;
+			for (auto &p : points) {
+				evaluate_recursive(a.table, p.data(), NDTABLE_INTERP_LINEAR, NDTABLE_EXTRAP_HOLD, &v);
+				sum += v;
+			}
+			return sum;
+		};
+
+		BENCHMARK(name + " (iterative, 1024 evaluations)") {
+			double sum = 0, v;
+			for (auto &p : points) {
+				NDTable_evaluate(a.table, ndims, p.data(), NDTABLE_INTERP_LINEAR, NDTABLE_EXTRAP_HOLD, &v);
+				sum += v;
+			}
+			return sum;
+		};
+	}
+}
+
+
+TEST_CASE("batch evaluation", "[interpolation]") {
+
+	const NDTable_InterpMethod_t interp_methods[] = { NDTABLE_INTERP_HOLD, NDTABLE_INTERP_NEAREST, NDTABLE_INTERP_LINEAR, NDTABLE_INTERP_AKIMA, NDTABLE_INTERP_FRITSCH_BUTLAND, NDTABLE_INTERP_STEFFEN };
+	const NDTable_ExtrapMethod_t extrap_methods[] = { NDTABLE_EXTRAP_HOLD, NDTABLE_EXTRAP_LINEAR };
+	const std::vector<std::vector<int>> shapes = { { 9 }, { 7, 5 }, { 4, 1, 3 }, { 4, 3, 5, 6 }, { 3, 2, 2, 3, 2, 2, 2, 2, 2, 3 } };
+
+	for (auto &dims : shapes) {
+
+		TestTable a(dims);
+
+		const int ndims = static_cast<int>(dims.size());
+		const auto points = a.samples(101);
+
+		// structure of arrays
+		std::vector<std::vector<double>> coords(ndims);
+		const double *params[MAX_NDIMS];
+
+		for (int i = 0; i < ndims; i++) {
+			for (auto &p : points) {
+				coords[i].push_back(p[i]);
+			}
+			params[i] = coords[i].data();
+		}
+
+		for (auto interp_method : interp_methods) {
+			for (auto extrap_method : extrap_methods) {
+
+				std::vector<double> values(points.size());
+
+				REQUIRE(NDTable_evaluate_batch(a.table, static_cast<int>(points.size()), params, interp_method, extrap_method, values.data()) == 0);
+
+				for (size_t k = 0; k < points.size(); k++) {
+					double v = 0;
+					REQUIRE(NDTable_evaluate(a.table, ndims, points[k].data(), interp_method, extrap_method, &v) == 0);
+					CHECK_THAT(values[k], WithinRel(v, 1e-12) || WithinAbs(v, 1e-12));
+				}
+			}
+		}
+
+		// points outside the range without extrapolation
+		std::vector<double> values(points.size());
+		CHECK(NDTable_evaluate_batch(a.table, static_cast<int>(points.size()), params, NDTABLE_INTERP_LINEAR, NDTABLE_EXTRAP_NONE, values.data()) == -1);
+		CHECK_THAT(NDTable_get_error_message(), Equals("Requested value is outside data range"));
+	}
+}
+
+
+TEST_CASE("benchmark batch evaluation", "[.][benchmark]") {
+
+	const std::vector<std::vector<int>> shapes = { { 1000 }, { 100, 100 }, { 10, 10, 10, 10 } };
+	const int npoints = 100000;
+
+	for (auto &dims : shapes) {
+
+		TestTable a(dims);
+
+		const int ndims = static_cast<int>(dims.size());
+		const std::string name = std::to_string(ndims) + "-D linear";
+
+		// a sweep along the diagonal
+		std::vector<std::vector<double>> coords(ndims);
+		const double *params[MAX_NDIMS];
+
+		for (int i = 0; i < ndims; i++) {
+			for (int k = 0; k < npoints; k++) {
+				coords[i].push_back(a.scales[i].back() * k / (npoints - 1));
+			}
+			params[i] = coords[i].data();
+		}
+
+		std::vector<double> values(npoints);
+
+		BENCHMARK(name + " (single, 100000 points)") {
+			double point[MAX_NDIMS];
+			for (int k = 0; k < npoints; k++) {
+				for (int i = 0; i < ndims; i++) {
+					point[i] = params[i][k];
+				}
+				NDTable_evaluate(a.table, ndims, point, NDTABLE_INTERP_LINEAR, NDTABLE_EXTRAP_HOLD, &values[k]);
+			}
+			return values[npoints / 2];
+		};
+
+		BENCHMARK(name + " (batch, 100000 points)") {
+			NDTable_evaluate_batch(a.table, npoints, params, NDTABLE_INTERP_LINEAR, NDTABLE_EXTRAP_HOLD, values.data());
+			return values[npoints / 2];
+		};
+	}
+}
+
+
+TEST_CASE("index search", "[interpolation]") {
+
+	std::vector<double> scale;
+
+	// strongly non-uniform scale
+	for (int i = 0; i < 1000; i++) {
+		scale.push_back(std::pow(10.0, i * 0.01) + i * 1e-3);
+	}
+
+	const int n = static_cast<int>(scale.size());
+
+	for (int k = 0; k < 5000; k++) {
+
+		const double value = -10 + std::fmod(k * 7919.123, 1.1e10) * 1e-3 / 1.0;
+		const double x = k % 3 ? value : scale[k % n];
+
+		for (int start : { 0, n - 2, k % n, -5, n + 5 }) {
+
+			int index = start;
+			double t = 0;
+
+			NDTable_find_index(x, n, scale.data(), &index, &t, NDTABLE_EXTRAP_LINEAR);
+
+			REQUIRE(index >= 0);
+			REQUIRE(index <= n - 2);
+
+			if (x < scale.front()) {
+				CHECK(index == 0);
+				CHECK(t < 0);
+			} else if (x > scale.back()) {
+				CHECK(index == n - 2);
+				CHECK(t > 1);
+			} else {
+				CHECK(scale[index] <= x);
+				CHECK(x <= scale[index + 1]);
+				CHECK_THAT(scale[index] + t * (scale[index + 1] - scale[index]), WithinRel(x, 1e-12));
+			}
+		}
+	}
+
+	SECTION("less than two values") {
+		int index = 3;
+		double t = 1;
+		NDTable_find_index(2.0, 1, scale.data(), &index, &t, NDTABLE_EXTRAP_LINEAR);
+		CHECK(index == 0);
+		CHECK(t == 0);
+	}
+}
+
+
+// the previous implementation of NDTable_find_index() (estimate and walk)
+static void find_index_walk(double value, int nvalues, const double *values, int *index, double *t) {
+	const double min = values[0];
+	const double range = values[nvalues - 1] - min;
+	int i = std::max(0, std::min((int)(nvalues * (value - min) / range), nvalues - 2));
+	while (i < nvalues - 2 && value > values[i + 1]) { i++; }
+	while (i > 0 && value < values[i]) { i--; }
+	*t = (value - values[i]) / (values[i + 1] - values[i]);
+	*index = i;
+}
+
+
+TEST_CASE("benchmark index search", "[.][benchmark]") {
+
+	const int n = 10000;
+	const int nsamples = 10000;
+
+	std::vector<double> uniform, logarithmic;
+
+	for (int i = 0; i < n; i++) {
+		uniform.push_back(i);
+		logarithmic.push_back(std::pow(10.0, 6.0 * i / (n - 1)));
+	}
+
+	struct Pattern { const char *name; const std::vector<double> &scale; bool random; };
+
+	const Pattern patterns[] = {
+		{ "uniform, sweep", uniform, false },
+		{ "uniform, random", uniform, true },
+		{ "log-spaced, sweep", logarithmic, false },
+		{ "log-spaced, random", logarithmic, true },
+	};
+
+	for (auto &pattern : patterns) {
+
+		std::vector<double> samples;
+
+		for (int k = 0; k < nsamples; k++) {
+			const int j = pattern.random ? (k * 7919) % (n - 1) : k * (n - 1) / nsamples;
+			samples.push_back(0.5 * (pattern.scale[j] + pattern.scale[j + 1]));
+		}
+
+		BENCHMARK(std::string(pattern.name) + " (walk, 10000 searches)") {
+			int index = 0, sum = 0;
+			double t;
+			for (double x : samples) {
+				find_index_walk(x, n, pattern.scale.data(), &index, &t);
+				sum += index;
+			}
+			return sum;
+		};
+
+		BENCHMARK(std::string(pattern.name) + " (hunt, 10000 searches)") {
+			int index = 0, sum = 0;
+			double t;
+			for (double x : samples) {
+				NDTable_find_index(x, n, pattern.scale.data(), &index, &t, NDTABLE_EXTRAP_HOLD);
+				sum += index;
+			}
+			return sum;
+		};
+	}
+}
+
+
+// a 2-D table with uniform scales
+struct UniformTable {
+
+	std::vector<double> x, y, data;
+	NDTable_h table = nullptr;
+
+	UniformTable(int nx, int ny) {
+
+		for (int i = 0; i < nx; i++) x.push_back(-1.0 + 2.0 * i / (nx - 1));
+		for (int j = 0; j < ny; j++) y.push_back(0.1 * j);
+
+		for (int i = 0; i < nx; i++) {
+			for (int j = 0; j < ny; j++) {
+				data.push_back(std::sin(3 * x[i]) * std::cos(y[j]));
+			}
+		}
+
+		const int dims[2] = { nx, ny };
+		const double *scales[2] = { x.data(), y.data() };
+
+		table = NDTable_create_table(2, dims, data.data(), scales);
+	}
+
+	~UniformTable() {
+		NDTable_free_table(table);
+	}
+};
+
+
+TEST_CASE("uniform scales", "[interpolation]") {
+
+	UniformTable a(21, 11), b(21, 11);
+
+	REQUIRE(a.table->step[0] > 0);
+	REQUIRE(a.table->step[1] > 0);
+
+	// disable the fast path
+	b.table->step[0] = 0;
+	b.table->step[1] = 0;
+
+	const NDTable_InterpMethod_t interp_methods[] = { NDTABLE_INTERP_HOLD, NDTABLE_INTERP_NEAREST, NDTABLE_INTERP_LINEAR, NDTABLE_INTERP_AKIMA, NDTABLE_INTERP_FRITSCH_BUTLAND, NDTABLE_INTERP_STEFFEN };
+	const NDTable_ExtrapMethod_t extrap_methods[] = { NDTABLE_EXTRAP_HOLD, NDTABLE_EXTRAP_LINEAR, NDTABLE_EXTRAP_NONE };
+
+	std::vector<std::array<double, 2>> points;
+
+	// scale values
+	for (double u : a.x) {
+		for (double v : a.y) {
+			points.push_back({ u, v });
+		}
+	}
+
+	// values in between and outside (not within NDTABLE_UNIFORM_TOLERANCE of a scale value)
+	for (int k = 0; k < 200; k++) {
+		points.push_back({ -1.2 + 2.4 * std::fmod(k * 0.6180339, 1.0), -0.1 + 1.2 * std::fmod(k * 0.4142135, 1.0) });
+	}
+
+	for (auto interp_method : interp_methods) {
+		for (auto extrap_method : extrap_methods) {
+			for (auto &p : points) {
+				double v1 = 0, v2 = 0;
+
+				const int status1 = NDTable_evaluate(a.table, 2, p.data(), interp_method, extrap_method, &v1);
+				const int status2 = NDTable_evaluate(b.table, 2, p.data(), interp_method, extrap_method, &v2);
+
+				REQUIRE(status1 == status2);
+
+				if (status1 == 0) {
+					CHECK_THAT(v1, WithinAbs(v2, 1e-9));
+				}
+			}
+		}
+	}
+
+	SECTION("non-uniform scales are detected") {
+
+		TestTable c({ 5, 2, 1 });
+
+		CHECK(c.table->step[0] == 0);
+		CHECK(c.table->step[1] > 0); // two values are always uniform
+		CHECK(c.table->step[2] == 0);
+	}
+}
+
+
+TEST_CASE("benchmark uniform scales", "[.][benchmark]") {
+
+	const int npoints = 10000;
+
+	for (auto shape : { std::array<int, 2>{ 1000000, 1 }, std::array<int, 2>{ 1000, 1000 } }) {
+
+		UniformTable a(shape[0], shape[1]);
+
+		const int ndims = shape[1] > 1 ? 2 : 1;
+
+		if (ndims == 1) {
+			a.table->ndims = 1;
+		}
+
+		std::vector<std::array<double, 2>> points;
+
+		for (int k = 0; k < npoints; k++) {
+			points.push_back({ -1.0 + 2.0 * std::fmod(k * 0.618, 1.0), 0.1 * (shape[1] - 1) * std::fmod(k * 0.414, 1.0) });
+		}
+
+		const std::string name = ndims == 1 ? "1-D 1000000" : "2-D 1000x1000";
+
+		BENCHMARK(name + " (search, 10000 random evaluations)") {
+			double steps[2] = { a.table->step[0], a.table->step[1] }, sum = 0, v;
+			a.table->step[0] = a.table->step[1] = 0;
+			for (auto &p : points) {
+				NDTable_evaluate(a.table, ndims, p.data(), NDTABLE_INTERP_LINEAR, NDTABLE_EXTRAP_HOLD, &v);
+				sum += v;
+			}
+			a.table->step[0] = steps[0];
+			a.table->step[1] = steps[1];
+			return sum;
+		};
+
+		BENCHMARK(name + " (uniform, 10000 random evaluations)") {
+			double sum = 0, v;
+			for (auto &p : points) {
+				NDTable_evaluate(a.table, ndims, p.data(), NDTABLE_INTERP_LINEAR, NDTABLE_EXTRAP_HOLD, &v);
+				sum += v;
+			}
+			return sum;
+		};
+	}
+}
+
+
+// the number of doubles that fill whole blocks of NDTABLE_ALIGNMENT bytes
+static size_t aligned(size_t n) {
+	const size_t block = NDTABLE_ALIGNMENT / sizeof(double);
+	return (n + block - 1) / block * block;
+}
+
+
+TEST_CASE("table memory", "[table]") {
+
+	UniformTable a(21, 11);
+
+	const int dims[2] = { 21, 11 };
+	const double *scales[2] = { a.x.data(), a.y.data() };
+
+	SECTION("data and scales are copied into one aligned block") {
+
+		REQUIRE(a.table->arena != nullptr);
+		CHECK(a.table->borrowed == 0);
+
+		const char *begin = static_cast<const char *>(a.table->arena);
+		const char *end = reinterpret_cast<const char *>(a.table->scales[1] + dims[1]);
+
+		CHECK(reinterpret_cast<uintptr_t>(a.table->data) % NDTABLE_ALIGNMENT == 0);
+		CHECK(reinterpret_cast<uintptr_t>(a.table->scales[0]) % NDTABLE_ALIGNMENT == 0);
+		CHECK(reinterpret_cast<uintptr_t>(a.table->scales[1]) % NDTABLE_ALIGNMENT == 0);
+		CHECK(reinterpret_cast<const char *>(a.table->data) >= begin);
+		CHECK(end - begin < static_cast<ptrdiff_t>((aligned(21 * 11) + aligned(21) + aligned(11)) * sizeof(double) + NDTABLE_ALIGNMENT));
+
+		CHECK(std::equal(a.data.begin(), a.data.end(), a.table->data));
+		CHECK(std::equal(a.x.begin(), a.x.end(), a.table->scales[0]));
+		CHECK(std::equal(a.y.begin(), a.y.end(), a.table->scales[1]));
+	}
+
+	SECTION("borrowed data and scales are not copied") {
+
+		NDTable_h b = NDTable_create_table_borrowed(2, dims, a.data.data(), scales);
+
+		REQUIRE(b != nullptr);
+		CHECK(b->arena == nullptr);
+		CHECK(b->borrowed == 1);
+		CHECK(b->data == a.data.data());
+		CHECK(b->scales[0] == a.x.data());
+		CHECK(b->scales[1] == a.y.data());
+		CHECK(b->step[0] == a.table->step[0]);
+
+		for (int k = 0; k < 100; k++) {
+			const double p[2] = { -1.2 + 2.4 * std::fmod(k * 0.6180339, 1.0), -0.1 + 1.2 * std::fmod(k * 0.4142135, 1.0) };
+			double v1 = 0, v2 = 0;
+			REQUIRE(NDTable_evaluate(a.table, 2, p, NDTABLE_INTERP_AKIMA, NDTABLE_EXTRAP_LINEAR, &v1) == 0);
+			REQUIRE(NDTable_evaluate(b, 2, p, NDTABLE_INTERP_AKIMA, NDTABLE_EXTRAP_LINEAR, &v2) == 0);
+			CHECK(v1 == v2);
+		}
+
+		// must not free the vectors of a
+		NDTable_free_table(b);
+	}
+
+	SECTION("invalid scales") {
+
+		std::vector<double> x(a.x);
+		x[3] = x[2];
+		const double *invalid[2] = { x.data(), a.y.data() };
+
+		CHECK(NDTable_create_table(2, dims, a.data.data(), invalid) == nullptr);
+		CHECK(NDTable_create_table_borrowed(2, dims, a.data.data(), invalid) == nullptr);
+		CHECK_THAT(NDTable_get_error_message(), ContainsSubstring("not strictly monotonic"));
+	}
+}
+
+
+TEST_CASE("concurrent error messages", "[table]") {
+
+	const int nthreads = 8, iterations = 10000;
+
+	std::atomic<int> mismatches(0);
+	std::vector<std::thread> threads;
+
+	// every thread produces its own message and checks it after the others have set theirs
+	for (int t = 0; t < nthreads; t++) {
+		threads.emplace_back([t, &mismatches]() {
+
+			const int ndims = MAX_NDIMS + 1 + t;
+			const std::string expected = "The number of dimensions must be in the range [0;32] but was " + std::to_string(ndims);
+
+			for (int i = 0; i < iterations; i++) {
+
+				NDTable_h table = NDTable_create_table(ndims, nullptr, nullptr, nullptr);
+
+				std::this_thread::yield();
+
+				if (table != nullptr || expected != NDTable_get_error_message()) {
+					mismatches++;
+				}
+			}
+		});
+	}
+
+	for (auto &thread : threads) {
+		thread.join();
+	}
+
+	CHECK(mismatches == 0);
+}
+
+TEST_CASE("concurrent evaluation", "[interpolation]") {
+
+	const int nthreads = 8, iterations = 200;
+
+	TestTable a({ 40, 30 });
+
+	REQUIRE(a.table != nullptr);
+
+	const auto points = a.samples(100);
+
+	std::vector<double> expected(points.size());
+
+	for (size_t k = 0; k < points.size(); k++) {
+		REQUIRE(NDTable_evaluate(a.table, 2, points[k].data(), NDTABLE_INTERP_AKIMA, NDTABLE_EXTRAP_LINEAR, &expected[k]) == 0);
+	}
+
+	std::atomic<int> mismatches(0);
+	std::vector<std::thread> threads;
+
+	// the threads share the search hints of the table and walk the points in different orders
+	// (this test must also pass without reports in a build with -fsanitize=thread)
+	for (int t = 0; t < nthreads; t++) {
+		threads.emplace_back([t, &a, &points, &expected, &mismatches]() {
+
+			for (int i = 0; i < iterations; i++) {
+				for (size_t j = 0; j < points.size(); j++) {
+
+					const size_t k = (j * (2 * t + 1)) % points.size();
+					double value = 0;
+
+					if (NDTable_evaluate(a.table, 2, points[k].data(), NDTABLE_INTERP_AKIMA, NDTABLE_EXTRAP_LINEAR, &value) != 0 || value != expected[k]) {
+						mismatches++;
+					}
+				}
+			}
+		});
+	}
+
+	for (auto &thread : threads) {
+		thread.join();
+	}
+
+	CHECK(mismatches == 0);
+}
+
+TEST_CASE("benchmark table memory", "[.][benchmark]") {
+
+	UniformTable a(4000, 4000);
+
+	const int dims[2] = { 4000, 4000 };
+	const double *scales[2] = { a.x.data(), a.y.data() };
+
+	BENCHMARK("4000x4000 (copy)") {
+		NDTable_h table = NDTable_create_table(2, dims, a.data.data(), scales);
+		NDTable_free_table(table);
+		return table;
+	};
+
+	BENCHMARK("4000x4000 (borrowed)") {
+		NDTable_h table = NDTable_create_table_borrowed(2, dims, a.data.data(), scales);
+		NDTable_free_table(table);
+		return table;
+	};
+}
+
+
+TEST_CASE("gradient", "[interpolation]") {
+
+	const NDTable_InterpMethod_t interp_methods[] = { NDTABLE_INTERP_HOLD, NDTABLE_INTERP_NEAREST, NDTABLE_INTERP_LINEAR, NDTABLE_INTERP_AKIMA, NDTABLE_INTERP_FRITSCH_BUTLAND, NDTABLE_INTERP_STEFFEN };
+	const std::vector<std::vector<int>> shapes = { { 9 }, { 7, 5 }, { 4, 3, 5, 6 } };
+
+	for (auto &dims : shapes) {
+
+		TestTable a(dims);
+
+		const int ndims = static_cast<int>(dims.size());
+		const auto points = a.samples(50);
+
+		for (auto method : interp_methods) {
+			for (auto &p : points) {
+
+				double value = 0, expected = 0;
+				double gradient[MAX_NDIMS];
+
+				REQUIRE(NDTable_evaluate_gradient(a.table, ndims, p.data(), method, NDTABLE_EXTRAP_LINEAR, &value, gradient) == 0);
+				REQUIRE(NDTable_evaluate(a.table, ndims, p.data(), method, NDTABLE_EXTRAP_LINEAR, &expected) == 0);
+				CHECK_THAT(value, WithinRel(expected, 1e-12) || WithinAbs(expected, 1e-12));
+
+				// every partial derivative matches the total differential in the direction of its dimension
+				for (int i = 0; i < ndims; i++) {
+					double delta[MAX_NDIMS] = { 0 };
+					delta[i] = 1;
+					REQUIRE(NDTable_evaluate_derivative(a.table, ndims, p.data(), delta, method, NDTABLE_EXTRAP_LINEAR, &expected) == 0);
+					CHECK(gradient[i] == expected);
+				}
+			}
+		}
+	}
+}
+
+
+TEST_CASE("gradient vs. finite differences", "[interpolation]") {
+
+	const NDTable_InterpMethod_t interp_methods[] = { NDTABLE_INTERP_LINEAR, NDTABLE_INTERP_AKIMA, NDTABLE_INTERP_FRITSCH_BUTLAND, NDTABLE_INTERP_STEFFEN };
+	const NDTable_ExtrapMethod_t extrap_methods[] = { NDTABLE_EXTRAP_HOLD, NDTABLE_EXTRAP_LINEAR };
+	const std::vector<std::vector<int>> shapes = { { 9 }, { 7, 5 }, { 4, 1, 3 }, { 4, 3, 5, 6 }, { 2, 3, 2 } };
+
+	for (auto &dims : shapes) {
+
+		TestTable a(dims);
+
+		const int ndims = static_cast<int>(dims.size());
+		const auto points = a.samples(50);
+		const double *scales[MAX_NDIMS];
+
+		// non-separable data so the partial derivatives depend on all coordinates
+		for (size_t k = 0; k < a.data.size(); k++) {
+			a.data[k] = std::sin(1.3 * k) + 0.5 * std::cos(0.7 * k * k);
+		}
+
+		for (int i = 0; i < ndims; i++) {
+			scales[i] = a.scales[i].data();
+		}
+
+		NDTable_free_table(a.table);
+		a.table = NDTable_create_table(ndims, dims.data(), a.data.data(), scales);
+
+		for (auto interp_method : interp_methods) {
+			for (auto extrap_method : extrap_methods) {
+				for (auto &p : points) {
+
+					double value = 0;
+					double gradient[MAX_NDIMS];
+
+					REQUIRE(NDTable_evaluate_gradient(a.table, ndims, p.data(), interp_method, extrap_method, &value, gradient) == 0);
+
+					// central differences
+					for (int i = 0; i < ndims; i++) {
+
+						const double h = 1e-6 * std::max(1.0, std::abs(p[i]));
+
+						// the derivative is not continuous at the sample points
+						if (std::any_of(a.scales[i].begin(), a.scales[i].end(), [&](double x) { return std::abs(p[i] - x) < 2 * h; })) {
+							continue;
+						}
+
+						auto q = p;
+						double left = 0, right = 0;
+
+						q[i] = p[i] - h;
+						REQUIRE(NDTable_evaluate(a.table, ndims, q.data(), interp_method, extrap_method, &left) == 0);
+						q[i] = p[i] + h;
+						REQUIRE(NDTable_evaluate(a.table, ndims, q.data(), interp_method, extrap_method, &right) == 0);
+
+						const double expected = (right - left) / (2 * h);
+
+						CHECK_THAT(gradient[i], WithinRel(expected, 1e-5) || WithinAbs(expected, 1e-5));
+					}
+				}
+			}
+		}
+	}
+
+	SECTION("non-finite values") {
+
+		TestTable a({ 4, 5 });
+
+		a.data[7] = NAN;
+
+		NDTable_free_table(a.table);
+
+		const double *scales[2] = { a.scales[0].data(), a.scales[1].data() };
+		const int dims[2] = { 4, 5 };
+
+		a.table = NDTable_create_table(2, dims, a.data.data(), scales);
+
+		const double p[2] = { 2.0, 5.0 };
+		double value = 0;
+		double gradient[2] = { 0, 0 };
+
+		REQUIRE(NDTable_evaluate_gradient(a.table, 2, p, NDTABLE_INTERP_AKIMA, NDTABLE_EXTRAP_HOLD, &value, gradient) == 0);
+		CHECK(std::isnan(value));
+		CHECK(std::isnan(gradient[0]));
+		CHECK(std::isnan(gradient[1]));
+	}
+}
+
+TEST_CASE("benchmark jacobian", "[.][benchmark]") {
+
+	TestTable a({ 10, 10, 10, 10 });
+
+	const int ndims = 4;
+	const auto points = a.samples(1000);
+
+	// the Jacobian of the table w.r.t. its inputs as assembled by a solver
+	std::vector<double> jacobian(points.size() * ndims);
+
+	BENCHMARK("4-D akima (finite differences, 1000 rows)") {
+		for (size_t k = 0; k < points.size(); k++) {
+			double p[MAX_NDIMS], v, vh;
+			std::copy(points[k].begin(), points[k].end(), p);
+			NDTable_evaluate(a.table, ndims, p, NDTABLE_INTERP_AKIMA, NDTABLE_EXTRAP_LINEAR, &v);
+			for (int i = 0; i < ndims; i++) {
+				const double h = 1e-7 * std::max(1.0, std::abs(p[i]));
+				p[i] += h;
+				NDTable_evaluate(a.table, ndims, p, NDTABLE_INTERP_AKIMA, NDTABLE_EXTRAP_LINEAR, &vh);
+				p[i] -= h;
+				jacobian[k * ndims + i] = (vh - v) / h;
+			}
+		}
+		return jacobian[0];
+	};
+
+	BENCHMARK("4-D akima (directional derivatives, 1000 rows)") {
+		for (size_t k = 0; k < points.size(); k++) {
+			for (int i = 0; i < ndims; i++) {
+				double delta[MAX_NDIMS] = { 0 };
+				delta[i] = 1;
+				NDTable_evaluate_derivative(a.table, ndims, points[k].data(), delta, NDTABLE_INTERP_AKIMA, NDTABLE_EXTRAP_LINEAR, &jacobian[k * ndims + i]);
+			}
+		}
+		return jacobian[0];
+	};
+
+	BENCHMARK("4-D akima (gradient, 1000 rows)") {
+		for (size_t k = 0; k < points.size(); k++) {
+			double v;
+			NDTable_evaluate_gradient(a.table, ndims, points[k].data(), NDTABLE_INTERP_AKIMA, NDTABLE_EXTRAP_LINEAR, &v, &jacobian[k * ndims]);
+		}
+		return jacobian[0];
+	};
+}
+
+
+TEST_CASE("benchmark gradient", "[.][benchmark]") {
+
+	const std::pair<NDTable_InterpMethod_t, std::string> methods[] = { { NDTABLE_INTERP_LINEAR, "linear" }, { NDTABLE_INTERP_AKIMA, "akima" }, { NDTABLE_INTERP_STEFFEN, "steffen" } };
+
+	TestTable a({ 10, 10, 10, 10 });
+
+	const int ndims = 4;
+	const auto points = a.samples(10000);
+
+	for (auto &method : methods) {
+
+		BENCHMARK("4-D " + method.second + " (value, 10000 points)") {
+			double sum = 0, v;
+			for (auto &p : points) {
+				NDTable_evaluate(a.table, ndims, p.data(), method.first, NDTABLE_EXTRAP_LINEAR, &v);
+				sum += v;
+			}
+			return sum;
+		};
+
+		BENCHMARK("4-D " + method.second + " (value and gradient, 10000 points)") {
+			double sum = 0, v, gradient[MAX_NDIMS];
+			for (auto &p : points) {
+				NDTable_evaluate_gradient(a.table, ndims, p.data(), method.first, NDTABLE_EXTRAP_LINEAR, &v, gradient);
+				sum += v + gradient[ndims - 1];
+			}
+			return sum;
+		};
+	}
+}
+
+
+// a multi-output table with the scales of TestTable and a different dataset per output
+struct MultiTestTable {
+
+	std::vector<TestTable *> outputs;
+	NDTable_h table = nullptr;
+
+	MultiTestTable(const std::vector<int> &dims, int nvalues) {
+
+		const double *data[8];
+		const double *scales[MAX_NDIMS];
+
+		for (int k = 0; k < nvalues; k++) {
+			auto *output = new TestTable(dims);
+			for (size_t i = 0; i < output->data.size(); i++) {
+				output->data[i] = std::sin(1.3 * i + k) * (k + 1);
+			}
+			NDTable_free_table(output->table);
+			for (size_t i = 0; i < dims.size(); i++) {
+				scales[i] = output->scales[i].data();
+			}
+			output->table = NDTable_create_table(static_cast<int>(dims.size()), dims.data(), output->data.data(), scales);
+			data[k] = output->data.data();
+			outputs.push_back(output);
+		}
+
+		table = NDTable_create_table_multi(static_cast<int>(dims.size()), dims.data(), nvalues, data, scales);
+	}
+
+	~MultiTestTable() {
+		NDTable_free_table(table);
+		for (auto *output : outputs) {
+			delete output;
+		}
+	}
+};
+
+
+TEST_CASE("multi-output tables", "[interpolation]") {
+
+	const NDTable_InterpMethod_t interp_methods[] = { NDTABLE_INTERP_HOLD, NDTABLE_INTERP_NEAREST, NDTABLE_INTERP_LINEAR, NDTABLE_INTERP_AKIMA, NDTABLE_INTERP_FRITSCH_BUTLAND, NDTABLE_INTERP_STEFFEN };
+	const NDTable_ExtrapMethod_t extrap_methods[] = { NDTABLE_EXTRAP_HOLD, NDTABLE_EXTRAP_LINEAR };
+	const std::vector<std::vector<int>> shapes = { { 9 }, { 7, 5 }, { 4, 1, 3 }, { 4, 3, 5, 6 } };
+
+	for (auto &dims : shapes) {
+
+		MultiTestTable a(dims, 3);
+
+		REQUIRE(a.table != nullptr);
+		CHECK(a.table->nvalues == 3);
+		CHECK(reinterpret_cast<uintptr_t>(a.table->data) % NDTABLE_ALIGNMENT == 0);
+
+		const int ndims = static_cast<int>(dims.size());
+		const auto points = a.outputs[0]->samples(50);
+
+		for (auto interp_method : interp_methods) {
+			for (auto extrap_method : extrap_methods) {
+				for (auto &p : points) {
+
+					double values[3];
+
+					REQUIRE(NDTable_evaluate_multi(a.table, ndims, p.data(), interp_method, extrap_method, values) == 0);
+
+					for (int k = 0; k < 3; k++) {
+						double expected = 0;
+						REQUIRE(NDTable_evaluate(a.outputs[k]->table, ndims, p.data(), interp_method, extrap_method, &expected) == 0);
+						CHECK_THAT(values[k], WithinRel(expected, 1e-12) || WithinAbs(expected, 1e-12));
+					}
+
+					// the single-output functions evaluate the first dataset
+					double first = 0;
+					REQUIRE(NDTable_evaluate(a.table, ndims, p.data(), interp_method, extrap_method, &first) == 0);
+					CHECK_THAT(first, WithinRel(values[0], 1e-12) || WithinAbs(values[0], 1e-12));
+				}
+			}
+		}
+	}
+
+	SECTION("invalid arguments") {
+
+		const int dims[1] = { 3 };
+		const double scale[3] = { 0, 1, 2 }, values[3] = { 1, 2, 3 };
+		const double *scales[1] = { scale };
+		const double *data[1] = { values };
+
+		CHECK(NDTable_create_table_multi(1, dims, 0, data, scales) == nullptr);
+		CHECK_THAT(NDTable_get_error_message(), Equals("The number of values must be >= 1 but was 0"));
+
+		MultiTestTable a({ 5 }, 2);
+		const double *params[1] = { scale };
+		double result[3];
+		CHECK(NDTable_evaluate_batch(a.table, 3, params, NDTABLE_INTERP_LINEAR, NDTABLE_EXTRAP_HOLD, result) == -1);
+		CHECK_THAT(NDTable_get_error_message(), Equals("Batch evaluation is not supported for multi-output tables"));
+	}
+}
+
+
+TEST_CASE("benchmark multi-output tables", "[.][benchmark]") {
+
+	MultiTestTable a({ 10, 10, 10, 10 }, 4);
+
+	const int ndims = 4;
+	const auto points = a.outputs[0]->samples(10000);
+
+	BENCHMARK("4-D linear (4 tables, 10000 points)") {
+		double sum = 0, v;
+		for (auto &p : points) {
+			for (auto *output : a.outputs) {
+				NDTable_evaluate(output->table, ndims, p.data(), NDTABLE_INTERP_LINEAR, NDTABLE_EXTRAP_LINEAR, &v);
+				sum += v;
+			}
+		}
+		return sum;
+	};
+
+	BENCHMARK("4-D linear (multi-output table with 4 values, 10000 points)") {
+		double sum = 0, values[4];
+		for (auto &p : points) {
+			NDTable_evaluate_multi(a.table, ndims, p.data(), NDTABLE_INTERP_LINEAR, NDTABLE_EXTRAP_LINEAR, values);
+			sum += values[0] + values[1] + values[2] + values[3];
+		}
+		return sum;
+	};
+}
+
+
+TEST_CASE("single precision storage", "[table]") {
+
+	const NDTable_InterpMethod_t interp_methods[] = { NDTABLE_INTERP_HOLD, NDTABLE_INTERP_NEAREST, NDTABLE_INTERP_LINEAR, NDTABLE_INTERP_AKIMA, NDTABLE_INTERP_FRITSCH_BUTLAND, NDTABLE_INTERP_STEFFEN };
+	const NDTable_ExtrapMethod_t extrap_methods[] = { NDTABLE_EXTRAP_HOLD, NDTABLE_EXTRAP_LINEAR };
+	const std::vector<std::vector<int>> shapes = { { 9 }, { 7, 5 }, { 4, 1, 3 }, { 4, 3, 5, 6 } };
+
+	for (auto &dims : shapes) {
+
+		TestTable a(dims);
+
+		const int ndims = static_cast<int>(dims.size());
+		const double *scales[MAX_NDIMS];
+
+		for (int i = 0; i < ndims; i++) {
+			scales[i] = a.scales[i].data();
+		}
+
+		NDTable_h f = NDTable_create_table_float(ndims, dims.data(), a.data.data(), scales);
+
+		REQUIRE(f != nullptr);
+		CHECK(f->data == nullptr);
+		CHECK(reinterpret_cast<uintptr_t>(f->data_float) % NDTABLE_ALIGNMENT == 0);
+		CHECK(reinterpret_cast<uintptr_t>(f->scales[0]) % NDTABLE_ALIGNMENT == 0);
+
+		// a double table with the rounded values gives the same results (the arithmetic is done in double)
+		std::vector<float> rounded(a.data.begin(), a.data.end());
+		std::vector<double> widened(rounded.begin(), rounded.end());
+
+		NDTable_h d = NDTable_create_table(ndims, dims.data(), widened.data(), scales);
+		NDTable_h b = NDTable_create_table_borrowed_float(ndims, dims.data(), rounded.data(), scales);
+
+		REQUIRE(b != nullptr);
+		CHECK(b->data_float == rounded.data());
+
+		const auto points = a.samples(50);
+
+		for (auto interp_method : interp_methods) {
+			for (auto extrap_method : extrap_methods) {
+				for (auto &p : points) {
+
+					double expected = 0, value = 0, borrowed = 0, exact = 0;
+					double expected_derivatives[MAX_NDIMS], derivatives[MAX_NDIMS];
+
+					REQUIRE(NDTable_evaluate(d, ndims, p.data(), interp_method, extrap_method, &expected) == 0);
+					REQUIRE(NDTable_evaluate(f, ndims, p.data(), interp_method, extrap_method, &value) == 0);
+					REQUIRE(NDTable_evaluate(b, ndims, p.data(), interp_method, extrap_method, &borrowed) == 0);
+					REQUIRE(NDTable_evaluate(a.table, ndims, p.data(), interp_method, extrap_method, &exact) == 0);
+
+					CHECK_THAT(value, WithinRel(expected, 1e-12) || WithinAbs(expected, 1e-12));
+					CHECK(borrowed == value);
+
+					// the rounding error is in the order of the machine epsilon of float
+					CHECK_THAT(value, WithinAbs(exact, 1e-5 * ndims));
+
+					REQUIRE(NDTable_evaluate_gradient(d, ndims, p.data(), interp_method, extrap_method, &expected, expected_derivatives) == 0);
+					REQUIRE(NDTable_evaluate_gradient(f, ndims, p.data(), interp_method, extrap_method, &value, derivatives) == 0);
+
+					for (int i = 0; i < ndims; i++) {
+						CHECK_THAT(derivatives[i], WithinRel(expected_derivatives[i], 1e-12) || WithinAbs(expected_derivatives[i], 1e-12));
+					}
+				}
+			}
+		}
+
+		// precomputed coefficients and batch evaluation
+		std::vector<std::vector<double>> coords(ndims);
+		const double *params[MAX_NDIMS];
+
+		for (int i = 0; i < ndims; i++) {
+			for (auto &p : points) {
+				coords[i].push_back(p[i]);
+			}
+			params[i] = coords[i].data();
+		}
+
+		REQUIRE(NDTable_precompute_coefficients(f, NDTABLE_INTERP_AKIMA) == 0);
+
+		for (auto interp_method : { NDTABLE_INTERP_LINEAR, NDTABLE_INTERP_AKIMA }) {
+
+			std::vector<double> values(points.size());
+
+			REQUIRE(NDTable_evaluate_batch(f, static_cast<int>(points.size()), params, interp_method, NDTABLE_EXTRAP_LINEAR, values.data()) == 0);
+
+			for (size_t k = 0; k < points.size(); k++) {
+				double expected = 0;
+				REQUIRE(NDTable_evaluate(d, ndims, points[k].data(), interp_method, NDTABLE_EXTRAP_LINEAR, &expected) == 0);
+				CHECK_THAT(values[k], WithinRel(expected, 1e-12) || WithinAbs(expected, 1e-12));
+			}
+		}
+
+		NDTable_free_table(b);
+		NDTable_free_table(d);
+		NDTable_free_table(f);
+	}
+}
+
+
+TEST_CASE("benchmark single precision storage", "[.][benchmark]") {
+
+	// a table with 200 x 200 x 200 values (64 MB in double, 32 MB in single precision)
+	TestTable a({ 200, 200, 200 });
+
+	const int ndims = 3;
+	const double *scales[3] = { a.scales[0].data(), a.scales[1].data(), a.scales[2].data() };
+
+	NDTable_h f = NDTable_create_table_float(ndims, a.table->dims, a.data.data(), scales);
+
+	REQUIRE(f != nullptr);
+
+	// random points inside the range, so most of the samples are not cached
+	std::vector<std::vector<double>> points;
+	uint32_t seed = 12345;
+
+	for (int k = 0; k < 100000; k++) {
+		std::vector<double> p;
+		for (int i = 0; i < ndims; i++) {
+			seed = seed * 1664525u + 1013904223u;
+			p.push_back(a.scales[i].back() * (seed >> 8) / 16777216.0);
+		}
+		points.push_back(p);
+	}
+
+	for (auto interp_method : { NDTABLE_INTERP_LINEAR, NDTABLE_INTERP_AKIMA }) {
+
+		const std::string name = interp_method == NDTABLE_INTERP_LINEAR ? "3-D linear" : "3-D Akima";
+
+		// accuracy report
+		double max_abs_error = 0, max_rel_error = 0;
+
+		for (auto &p : points) {
+			double exact = 0, value = 0;
+			NDTable_evaluate(a.table, ndims, p.data(), interp_method, NDTABLE_EXTRAP_LINEAR, &exact);
+			NDTable_evaluate(f, ndims, p.data(), interp_method, NDTABLE_EXTRAP_LINEAR, &value);
+			max_abs_error = std::max(max_abs_error, std::abs(value - exact));
+			max_rel_error = std::max(max_rel_error, std::abs(value - exact) / std::max(std::abs(exact), 1.0));
+		}
+
+		WARN(name << ": max. absolute error " << max_abs_error << ", max. relative error " << max_rel_error);
+
+		BENCHMARK(name + " (double, 100000 points)") {
+			double sum = 0, v;
+			for (auto &p : points) {
+				NDTable_evaluate(a.table, ndims, p.data(), interp_method, NDTABLE_EXTRAP_LINEAR, &v);
+				sum += v;
+			}
+			return sum;
+		};
+
+		BENCHMARK(name + " (single, 100000 points)") {
+			double sum = 0, v;
+			for (auto &p : points) {
+				NDTable_evaluate(f, ndims, p.data(), interp_method, NDTABLE_EXTRAP_LINEAR, &v);
+				sum += v;
+			}
+			return sum;
+		};
+	}
+
+	NDTable_free_table(f);
+}
+
+
+TEST_CASE("tables with more than 2^31 elements", "[table]") {
+
+	// 65536 x 32769 = 2147549184 values
+	const int nx = 65536, ny = 32769;
+	const int dims[2] = { nx, ny };
+	const size_t numel = static_cast<size_t>(nx) * ny;
+
+	std::vector<double> x(nx), y(ny);
+
+	for (int i = 0; i < nx; i++) x[i] = i;
+	for (int j = 0; j < ny; j++) y[j] = j;
+
+	const double *scales[2] = { x.data(), y.data() };
+
+	SECTION("the number of elements must fit into the address space") {
+		const int huge[5] = { 65536, 65536, 65536, 65536, 65536 };
+		const double *huge_scales[5] = { x.data(), x.data(), x.data(), x.data(), x.data() };
+		CHECK(NDTable_calculate_numel(5, huge) == 0);
+		CHECK(NDTable_create_table_borrowed(5, huge, x.data(), huge_scales) == nullptr);
+		CHECK_THAT(NDTable_get_error_message(), ContainsSubstring("address space"));
+	}
+
+#ifdef _WIN32
+	SKIP("Sparse memory is not available");
+#else
+	// 8 GB of virtual memory that is only backed by pages that are written
+	const size_t length = numel * sizeof(float);
+	void *memory = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+
+	if (memory == MAP_FAILED) {
+		SKIP("Failed to reserve 8 GB of virtual memory");
+	}
+
+	float *values = static_cast<float *>(memory);
+
+	// the last two rows
+	const size_t last_rows = static_cast<size_t>(nx - 2) * ny;
+
+	for (size_t k = last_rows; k < numel; k++) {
+		values[k] = static_cast<float>(k - last_rows);
+	}
+
+	NDTable_h table = NDTable_create_table_borrowed_float(2, dims, values, scales);
+
+	REQUIRE(table != nullptr);
+	CHECK(table->numel == numel);
+	CHECK(table->offs[0] == static_cast<size_t>(ny));
+
+	// subscripts and indices beyond INT_MAX
+	int subs[2] = { nx - 1, ny - 1 }, back[2] = { 0, 0 };
+	size_t index = 0;
+	NDTable_sub2ind(subs, table, &index);
+	CHECK(index == numel - 1);
+	NDTable_ind2sub(index, table, back);
+	CHECK(back[0] == nx - 1);
+	CHECK(back[1] == ny - 1);
+	CHECK(NDTable_get_value_subs(table, subs) == 2.0 * ny - 1);
+
+	const double params[2] = { nx - 1.5, ny - 1.5 };
+	const double expected = 0.25 * ((ny - 2.0) + (ny - 1.0) + (2.0 * ny - 2) + (2.0 * ny - 1));
+	double value = 0, derivatives[2];
+
+	REQUIRE(NDTable_evaluate(table, 2, params, NDTABLE_INTERP_LINEAR, NDTABLE_EXTRAP_HOLD, &value) == 0);
+	CHECK(value == expected);
+
+	REQUIRE(NDTable_evaluate_gradient(table, 2, params, NDTABLE_INTERP_LINEAR, NDTABLE_EXTRAP_HOLD, &value, derivatives) == 0);
+	CHECK(value == expected);
+	CHECK(derivatives[0] == ny);
+	CHECK(derivatives[1] == 1);
+
+	// the last sample point (hold returns the sample point at the start of the last interval)
+	const double corner[2] = { nx - 1.0, ny - 1.0 };
+	REQUIRE(NDTable_evaluate(table, 2, corner, NDTABLE_INTERP_HOLD, NDTABLE_EXTRAP_HOLD, &value) == 0);
+	CHECK(value == ny - 2.0);
+
+	for (auto interp_method : { NDTABLE_INTERP_NEAREST, NDTABLE_INTERP_LINEAR, NDTABLE_INTERP_AKIMA, NDTABLE_INTERP_FRITSCH_BUTLAND, NDTABLE_INTERP_STEFFEN }) {
+		REQUIRE(NDTable_evaluate(table, 2, corner, interp_method, NDTABLE_EXTRAP_HOLD, &value) == 0);
+		CHECK(value == 2.0 * ny - 1);
+	}
+
+	const double *batch[2] = { &params[0], &params[1] };
+	REQUIRE(NDTable_evaluate_batch(table, 1, batch, NDTABLE_INTERP_LINEAR, NDTABLE_EXTRAP_HOLD, &value) == 0);
+	CHECK(value == expected);
+
+	NDTable_free_table(table);
+
+	munmap(memory, length);
+#endif
+}
@@ -3,6 +3,7 @@
 #include <string.h>
 #include <stdio.h>
 #include <float.h>
+#include <stdint.h>
 
 #include "NDTable.h"
 
@@ -25,6 +26,16 @@ static const unsigned long __nan[2] = { 0xffffffff, 0x7fffffff };
 #define ISFINITE(x) isfinite(x)
 #endif
 
+// the search hints in table->last are shared by all threads that evaluate the table
+// (volatile accesses of aligned ints are atomic with MSVC)
+#ifdef _MSC_VER
+#define LOAD_HINT(p)     (*(volatile int *)(p))
+#define STORE_HINT(p, v) (*(volatile int *)(p) = (v))
+#else
+#define LOAD_HINT(p)     __atomic_load_n(p, __ATOMIC_RELAXED)
+#define STORE_HINT(p, v) __atomic_store_n(p, v, __ATOMIC_RELAXED)
+#endif
+
 /** 
 Prototype of an interpolation function
 
@@ -52,13 +63,15 @@ static int interp_steffen         (const NDTable_h table, const double *t, const
 static int extrap_hold		      (const NDTable_h table, const double *t, const int *subs, int *nsubs, int dim, NDTable_InterpMethod_t interp_method, NDTable_ExtrapMethod_t extrap_method, double *value, double derivatives[]);
 static int extrap_linear	      (const NDTable_h table, const double *t, const int *subs, int *nsubs, int dim, NDTable_InterpMethod_t interp_method, NDTable_ExtrapMethod_t extrap_method, double *value, double derivatives[]);
 
+/*! The maximum number of linearly interpolated dimensions for evaluate_flat() (i.e. 2^8 corners) */
+#define MAX_FLAT_NDIMS 8
+
+static int evaluate_flat(const NDTable_h table, const double *t, const int *subs, NDTable_InterpMethod_t interp_method, NDTable_ExtrapMethod_t extrap_method, int nvalues, double *value, double derivatives[]);
+
 
 void NDTable_find_index(double value, int nvalues, const double *values, int *index, double *t, NDTable_ExtrapMethod_t extrap_method) {
-	int i;
-	double a, b;
-	double min = values[0];
-	double max = values[nvalues - 1];
-	double range = max - min;
+	int i, lo, hi, mid, step;
+	double a, b, e;
 
 	if(nvalues < 2) {
 		*t = 0.0;
@@ -66,14 +79,54 @@ void NDTable_find_index(double value, int nvalues, const double *values, int *in
 		return;
 	}
 
-	// estimate the index and make sure that i <= 0 and i <= 2nd last 
-	i = MAX(0, MIN((int)(nvalues * (value - min) / range), nvalues - 2));
+	// start at the previous index and make sure that 0 <= i <= 2nd last
+	i = MAX(0, MIN(*index, nvalues - 2));
 
-	// go up until value < values[i+1]
-	while (i < nvalues - 2 && value > values[i+1]) { i++; }
+	// if the value is not in the same or an adjacent interval estimate the index assuming uniform spacing
+	if (value < values[MAX(i - 1, 0)] || value > values[MIN(i + 2, nvalues - 1)]) {
+		e = (nvalues - 1) * (value - values[0]) / (values[nvalues - 1] - values[0]);
+		i = e > 0 ? (int)MIN(e, nvalues - 2) : 0;
+	}
+
+	if (value < values[i]) {
+		// hunt down until values[lo] <= value
+		hi = i;
+		step = 1;
+		lo = hi - step;
+		while (lo > 0 && value < values[lo]) {
+			hi = lo;
+			step *= 2;
+			lo = hi - step;
+		}
+		lo = MAX(lo, 0);
+	} else if (value >= values[i + 1] && i < nvalues - 2) {
+		// hunt up until value < values[hi]
+		lo = i + 1;
+		step = 1;
+		hi = lo + step;
+		while (hi < nvalues - 1 && value >= values[hi]) {
+			lo = hi;
+			step *= 2;
+			hi = lo + step;
+		}
+		hi = MIN(hi, nvalues - 1);
+	} else {
+		// same interval
+		lo = i;
+		hi = i + 1;
+	}
+
+	// bisect until values[lo] <= value < values[lo+1]
+	while (hi - lo > 1) {
+		mid = lo + (hi - lo) / 2;
+		if (value < values[mid]) {
+			hi = mid;
+		} else {
+			lo = mid;
+		}
+	}
 
-	// go down until values[i] < value
-	while (i > 0 && value < values[i]) { i--; }
+	i = MIN(lo, nvalues - 2);
 
 	a = values[i];
 	b = values[i+1];
@@ -83,8 +136,38 @@ void NDTable_find_index(double value, int nvalues, const double *values, int *in
 	*index = i;
 }
 
+/* Find the subscript and weight for a dimension of the table (without searching if the scale is uniform) */
+static void find_table_index(const NDTable_h table, int dim, double value, int *index, double *t, NDTable_ExtrapMethod_t extrap_method) {
+	const int n = table->dims[dim];
+	double u;
+	int i;
+
+	if (table->step[dim] <= 0) {
+		NDTable_find_index(value, n, table->scales[dim], index, t, extrap_method);
+		return;
+	}
+
+	u = (value - table->min[dim]) / table->step[dim];
+
+	if (value >= table->min[dim] && value < table->max[dim]) {
+		// interpolate (values within the tolerance of a scale value are snapped to it)
+		i = MIN((int)(u + NDTABLE_UNIFORM_TOLERANCE), n - 2);
+		*t = MAX(0.0, MIN(u - i, 1.0));
+	} else if (value >= table->max[dim]) {
+		// extrapolate right
+		i = n - 2;
+		*t = value == table->max[dim] ? 1.0 : u - i;
+	} else {
+		// extrapolate left
+		i = 0;
+		*t = u;
+	}
+
+	*index = i;
+}
+
 int NDTable_evaluate(NDTable_h table, int nparams, const double params[], NDTable_InterpMethod_t interp_method, NDTable_ExtrapMethod_t extrap_method, double *value) {
-	int		 i;
+	int		 i, err;
 	double	 t	   [MAX_NDIMS]; // the weights for the interpolation
 	int		 subs  [MAX_NDIMS];	// the subscripts
 	int		 nsubs [MAX_NDIMS];	// the neighboring subscripts
@@ -94,51 +177,289 @@ int NDTable_evaluate(NDTable_h table, int nparams, const double params[], NDTabl
 
 	// if the dataset is scalar return the value
 	if (table->ndims == 0) {
-		*value = table->data[0];
+		*value = NDTABLE_VALUE(table, 0);
 		return NDTABLE_INTERPSTATUS_OK;
 	}
 
-	// find entry point and weights
+	// find entry point and weights starting at the previous subscripts
 	for (i = 0; i < table->ndims; i++) {
-		NDTable_find_index(params[i], table->dims[i], table->scales[i], &subs[i], &t[i], extrap_method);
+		subs[i] = LOAD_HINT(&table->last[i]);
+		find_table_index(table, i, params[i], &subs[i], &t[i], extrap_method);
+		STORE_HINT(&table->last[i], subs[i]);
+	}
+
+	// evaluate the (multi-)linear methods without recursion
+	if (interp_method == NDTABLE_INTERP_HOLD || interp_method == NDTABLE_INTERP_NEAREST || interp_method == NDTABLE_INTERP_LINEAR) {
+		if ((err = evaluate_flat(table, t, subs, interp_method, extrap_method, 1, value, NULL)) <= 0) {
+			return err;
+		}
 	}
 
 	return NDTable_evaluate_internal(table, t, subs, nsubs, 0, interp_method, extrap_method, value, derivatives);
 }
 
 int NDTable_evaluate_derivative(NDTable_h table, int nparams, const double params[], const double delta_params[], NDTable_InterpMethod_t interp_method, NDTable_ExtrapMethod_t extrap_method, double *value) {
+	int		 i, err;
+	double	 derivatives[MAX_NDIMS];
+
+	if ((err = NDTable_evaluate_gradient(table, nparams, params, interp_method, extrap_method, value, derivatives)) != 0) {
+		return err;
+	}
+
+	*value = 0.0;
+
+	for (i = 0; i < nparams; i++) {
+		*value += delta_params[i] * derivatives[i];
+	}
+
+	return 0;
+}
+
+int NDTable_evaluate_gradient(NDTable_h table, int nparams, const double params[], NDTable_InterpMethod_t interp_method, NDTable_ExtrapMethod_t extrap_method, double *value, double derivatives[]) {
 	int		 i, err;
 	double	 t[MAX_NDIMS];		// the weights for the interpolation
 	int		 subs[MAX_NDIMS];	// the subscripts
 	int		 nsubs[MAX_NDIMS];	// the neighboring subscripts
-	double	 derivatives[MAX_NDIMS];
 
 	// TODO: add null check
 
 	// if the dataset is scalar return the value
 	if (table->ndims == 0) {
-		*value = table->data[0];
+		*value = NDTABLE_VALUE(table, 0);
 		return NDTABLE_INTERPSTATUS_OK;
 	}
 
-	// find entry point and weights
+	// find entry point and weights starting at the previous subscripts
 	for (i = 0; i < table->ndims; i++) {
-		NDTable_find_index(params[i], table->dims[i], table->scales[i], &subs[i], &t[i], extrap_method);
+		subs[i] = LOAD_HINT(&table->last[i]);
+		find_table_index(table, i, params[i], &subs[i], &t[i], extrap_method);
+		STORE_HINT(&table->last[i], subs[i]);
 	}
 
-	if ((err = NDTable_evaluate_internal(table, t, subs, nsubs, 0, interp_method, extrap_method, value, derivatives)) != 0) {
-		return err;
+	// evaluate the (multi-)linear methods without recursion
+	if (interp_method == NDTABLE_INTERP_HOLD || interp_method == NDTABLE_INTERP_NEAREST || interp_method == NDTABLE_INTERP_LINEAR) {
+		if ((err = evaluate_flat(table, t, subs, interp_method, extrap_method, 1, value, derivatives)) <= 0) {
+			return err;
+		}
 	}
 
-	*value = 0.0;
+	return NDTable_evaluate_internal(table, t, subs, nsubs, 0, interp_method, extrap_method, value, derivatives);
+}
 
-	for (i = 0; i < nparams; i++) {
-		*value += delta_params[i] * derivatives[i];
+int NDTable_evaluate_multi(NDTable_h table, int nparams, const double params[], NDTable_InterpMethod_t interp_method, NDTable_ExtrapMethod_t extrap_method, double values[]) {
+	int		 i, k, err;
+	double	 t[MAX_NDIMS];		// the weights for the interpolation
+	int		 subs[MAX_NDIMS];	// the subscripts
+	int		 nsubs[MAX_NDIMS];	// the neighboring subscripts
+	double	 derivatives[MAX_NDIMS];
+	NDTable_t view;				// the table with the values of one output
+
+	// if the dataset is scalar return the values
+	if (table->ndims == 0) {
+		for (k = 0; k < table->nvalues; k++) {
+			values[k] = NDTABLE_VALUE(table, k);
+		}
+		return NDTABLE_INTERPSTATUS_OK;
+	}
+
+	// find entry point and weights starting at the previous subscripts
+	for (i = 0; i < table->ndims; i++) {
+		subs[i] = LOAD_HINT(&table->last[i]);
+		find_table_index(table, i, params[i], &subs[i], &t[i], extrap_method);
+		STORE_HINT(&table->last[i], subs[i]);
+	}
+
+	// evaluate the (multi-)linear methods for all outputs in one pass over the corners
+	if (interp_method == NDTABLE_INTERP_HOLD || interp_method == NDTABLE_INTERP_NEAREST || interp_method == NDTABLE_INTERP_LINEAR) {
+		if ((err = evaluate_flat(table, t, subs, interp_method, extrap_method, table->nvalues, values, NULL)) <= 0) {
+			return err;
+		}
+	}
+
+	if (table->nvalues == 1) {
+		return NDTable_evaluate_internal(table, t, subs, nsubs, 0, interp_method, extrap_method, values, derivatives);
+	}
+
+	// evaluate the splines for every output with the same subscripts and weights
+	// (copy everything but the search hints which are the last member)
+	memcpy(&view, table, offsetof(NDTable_t, last));
+	view.coeffs = NULL;
+
+	for (k = 0; k < table->nvalues; k++) {
+		view.data = table->data + k;
+
+		if ((err = NDTable_evaluate_internal(&view, t, subs, nsubs, 0, interp_method, extrap_method, &values[k], derivatives)) != 0) {
+			return err;
+		}
 	}
 
 	return 0;
 }
 
+/*! The number of sample points that are processed together by NDTable_evaluate_batch() */
+#define BATCH_SIZE 32
+
+/* Evaluate point p of a batch */
+static int evaluate_batch_point(const NDTable_h table, double t[][BATCH_SIZE], int subs[][BATCH_SIZE], int p, NDTable_InterpMethod_t interp_method, NDTable_ExtrapMethod_t extrap_method, double *value) {
+	int		 i, err;
+	double	 tp   [MAX_NDIMS];
+	int		 subsp[MAX_NDIMS];
+	int		 nsubs[MAX_NDIMS];
+	double	 derivatives[MAX_NDIMS];
+
+	for (i = 0; i < table->ndims; i++) {
+		tp[i]    = t[i][p];
+		subsp[i] = subs[i][p];
+	}
+
+	if (interp_method == NDTABLE_INTERP_HOLD || interp_method == NDTABLE_INTERP_NEAREST || interp_method == NDTABLE_INTERP_LINEAR) {
+		if ((err = evaluate_flat(table, tp, subsp, interp_method, extrap_method, 1, value, NULL)) <= 0) {
+			return err;
+		}
+	}
+
+	return NDTable_evaluate_internal(table, tp, subsp, nsubs, 0, interp_method, extrap_method, value, derivatives);
+}
+
+int NDTable_evaluate_batch(NDTable_h table, int npoints, const double *params[], NDTable_InterpMethod_t interp_method, NDTable_ExtrapMethod_t extrap_method, double values[]) {
+	int		 subs[MAX_NDIMS][BATCH_SIZE];  // the subscripts
+	double	 t   [MAX_NDIMS][BATCH_SIZE];  // the weights for the interpolation
+	double	 w   [MAX_NDIMS + 1][BATCH_SIZE]; // the partial products of the corner weights
+	size_t	 base[BATCH_SIZE];             // the indices of the first corners
+	int		 hint[MAX_NDIMS];              // the subscripts of the previous point
+	int		 lin [MAX_NDIMS];              // the dimensions with more than one sample
+	int		 nlin = 0;
+	size_t	 offset;
+	int		 i, j, p, first, count, corner, regular, err;
+
+	if (table->nvalues > 1) {
+		NDTable_set_error_message("Batch evaluation is not supported for multi-output tables");
+		return -1;
+	}
+
+	// if the dataset is scalar return the value
+	if (table->ndims == 0) {
+		for (p = 0; p < npoints; p++) {
+			values[p] = NDTABLE_VALUE(table, 0);
+		}
+		return NDTABLE_INTERPSTATUS_OK;
+	}
+
+	for (i = 0; i < table->ndims; i++) {
+		hint[i] = LOAD_HINT(&table->last[i]);
+		if (table->dims[i] > 1) {
+			lin[nlin++] = i;
+		}
+	}
+
+	for (first = 0; first < npoints; first += BATCH_SIZE) {
+
+		count = MIN(BATCH_SIZE, npoints - first);
+
+		// find the subscripts and weights starting with the interval of the previous point
+		for (i = 0; i < table->ndims; i++) {
+			const double *x = &params[i][first];
+
+			for (p = 0; p < count; p++) {
+				find_table_index(table, i, x[p], &hint[i], &t[i][p], extrap_method);
+				subs[i][p] = hint[i];
+			}
+		}
+
+		if (interp_method != NDTABLE_INTERP_LINEAR || nlin > MAX_FLAT_NDIMS) {
+			for (p = 0; p < count; p++) {
+				if ((err = evaluate_batch_point(table, t, subs, p, interp_method, extrap_method, &values[first + p])) != 0) {
+					return err;
+				}
+			}
+			continue;
+		}
+
+		// sum up the weighted corners of the hypercubes for all points
+		for (p = 0; p < count; p++) {
+			base[p] = 0;
+			w[nlin][p] = 1;
+			values[first + p] = 0;
+		}
+
+		for (i = 0; i < table->ndims; i++) {
+			for (p = 0; p < count; p++) {
+				base[p] += subs[i][p] * table->offs[i];
+			}
+		}
+
+		for (corner = 0; corner < (1 << nlin); corner++) {
+
+			// update the weights of the dimensions that changed w.r.t. the previous corner
+			if (corner == 0) {
+				j = nlin - 1;
+			} else {
+				for (j = 0; !((corner >> j) & 1); j++);
+			}
+
+			for (; j >= 0; j--) {
+				const double *tj = t[lin[j]];
+				if ((corner >> j) & 1) {
+					for (p = 0; p < count; p++) {
+						w[j][p] = w[j + 1][p] * tj[p];
+					}
+				} else {
+					for (p = 0; p < count; p++) {
+						w[j][p] = w[j + 1][p] * (1 - tj[p]);
+					}
+				}
+			}
+
+			offset = 0;
+
+			for (j = 0; j < nlin; j++) {
+				if ((corner >> j) & 1) {
+					offset += table->offs[lin[j]];
+				}
+			}
+
+			if (table->data_float) {
+				for (p = 0; p < count; p++) {
+					values[first + p] += w[0][p] * table->data_float[base[p] + offset];
+				}
+			} else {
+				for (p = 0; p < count; p++) {
+					values[first + p] += w[0][p] * table->data[base[p] + offset];
+				}
+			}
+		}
+
+		for (p = 0; p < count; p++) {
+
+			regular = 1;
+
+			// points outside the range are only interpolated linearly for linear extrapolation
+			if (extrap_method != NDTABLE_EXTRAP_LINEAR) {
+				for (j = 0; j < nlin; j++) {
+					if (t[lin[j]][p] < 0.0 || t[lin[j]][p] > 1.0) {
+						regular = 0;
+					}
+				}
+			}
+
+			if (!regular) {
+				if ((err = evaluate_batch_point(table, t, subs, p, interp_method, extrap_method, &values[first + p])) != 0) {
+					return err;
+				}
+			} else if (!ISFINITE(values[first + p])) {
+				// if any of the values is not finite return NAN
+				values[first + p] = NAN;
+			}
+		}
+	}
+
+	for (i = 0; i < table->ndims; i++) {
+		STORE_HINT(&table->last[i], hint[i]);
+	}
+
+	return NDTABLE_INTERPSTATUS_OK;
+}
+
 int NDTable_evaluate_internal(const NDTable_h table, const double *t, const int *subs, int *nsubs, int dim, NDTable_InterpMethod_t interp_method, NDTable_ExtrapMethod_t extrap_method, double *value, double derivatives[]) {
 
 	interp_fun func;
@@ -189,6 +510,151 @@ int NDTable_evaluate_internal(const NDTable_h table, const double *t, const int
 	return (*func)(table, t, subs, nsubs, dim, interp_method, extrap_method, value, derivatives);
 }
 
+/* Evaluate the table for hold, nearest and linear interpolation by summing up the weighted corners 
+   of the hypercube around the sample point. The first nvalues values of every corner are evaluated.
+   If derivatives is not NULL the partial derivatives of the first value are summed up in the same pass. 
+   Returns 1 if more than MAX_FLAT_NDIMS dimensions have to be interpolated linearly. */
+static int evaluate_flat(const NDTable_h table, const double *t, const int *subs, NDTable_InterpMethod_t interp_method, NDTable_ExtrapMethod_t extrap_method, int nvalues, double *value, double derivatives[]) {
+
+	size_t index [1 << MAX_FLAT_NDIMS]; // the offsets of the corners
+	double weight[1 << MAX_FLAT_NDIMS]; // the weights of the corners
+	double der_weight[MAX_FLAT_NDIMS][1 << MAX_FLAT_NDIMS]; // the weights of the corners for the partial derivatives
+	int    der_dims[MAX_FLAT_NDIMS];    // the linearly interpolated dimensions
+	int    nlinear = 0;
+	int    ncorners = 1;
+	size_t base = 0;                    // the index of the first corner
+	size_t offs;
+	int    dim, i, k;
+	double v, dx;
+
+	index[0]  = 0;
+	weight[0] = 1;
+
+	for (dim = 0; dim < table->ndims; dim++) {
+
+		offs = table->offs[dim] * table->nvalues;
+
+		if (derivatives) {
+			derivatives[dim] = 0;
+		}
+
+		if (table->dims[dim] < 2) {
+			// hold
+			base += subs[dim] * offs;
+			continue;
+		}
+
+		if (t[dim] < 0.0 || t[dim] > 1.0) {
+			// extrapolate
+			switch (extrap_method) {
+			case NDTABLE_EXTRAP_HOLD:
+				base += (t[dim] < 0.0 ? subs[dim] : subs[dim] + 1) * offs;
+				continue;
+			case NDTABLE_EXTRAP_LINEAR:
+				break;
+			default:
+				NDTable_set_error_message("Requested value is outside data range");
+				return -1;
+			}
+		} else if (interp_method == NDTABLE_INTERP_HOLD) {
+			base += subs[dim] * offs;
+			continue;
+		} else if (interp_method == NDTABLE_INTERP_NEAREST) {
+			base += (t[dim] < 0.5 ? subs[dim] : subs[dim] + 1) * offs;
+			continue;
+		}
+
+		// split the corners into left and right
+		if (ncorners == 1 << MAX_FLAT_NDIMS) {
+			return 1;
+		}
+
+		base += subs[dim] * offs;
+
+		if (derivatives) {
+			dx = table->scales[dim][subs[dim] + 1] - table->scales[dim][subs[dim]];
+
+			for (k = 0; k < nlinear; k++) {
+				for (i = 0; i < ncorners; i++) {
+					der_weight[k][ncorners + i] = der_weight[k][i] * t[dim];
+					der_weight[k][i]           *= 1 - t[dim];
+				}
+			}
+
+			for (i = 0; i < ncorners; i++) {
+				der_weight[nlinear][ncorners + i] =  weight[i] / dx;
+				der_weight[nlinear][i]            = -weight[i] / dx;
+			}
+
+			der_dims[nlinear++] = dim;
+		}
+
+		for (i = 0; i < ncorners; i++) {
+			index [ncorners + i] = index[i] + offs;
+			weight[ncorners + i] = weight[i] * t[dim];
+			weight[i]           *= 1 - t[dim];
+		}
+
+		ncorners *= 2;
+	}
+
+	if (nvalues == 1) {
+		v = 0;
+
+		if (table->data_float) {
+			for (i = 0; i < ncorners; i++) {
+				v += weight[i] * table->data_float[base + index[i]];
+			}
+		} else {
+			for (i = 0; i < ncorners; i++) {
+				v += weight[i] * table->data[base + index[i]];
+			}
+		}
+
+		// if any of the values is not finite return NAN
+		*value = ISFINITE(v) ? v : NAN;
+	} else {
+		for (k = 0; k < nvalues; k++) {
+			value[k] = 0;
+		}
+
+		// the values of a corner are adjacent
+		for (i = 0; i < ncorners; i++) {
+			const double *corner = &table->data[base + index[i]];
+
+			for (k = 0; k < nvalues; k++) {
+				value[k] += weight[i] * corner[k];
+			}
+		}
+
+		for (k = 0; k < nvalues; k++) {
+			if (!ISFINITE(value[k])) {
+				value[k] = NAN;
+			}
+		}
+	}
+
+	if (derivatives) {
+		for (k = 0; k < nlinear; k++) {
+			v = 0;
+
+			for (i = 0; i < ncorners; i++) {
+				v += der_weight[k][i] * NDTABLE_VALUE(table, base + index[i]);
+			}
+
+			derivatives[der_dims[k]] = v;
+		}
+
+		if (!ISFINITE(*value)) {
+			for (dim = 0; dim < table->ndims; dim++) {
+				derivatives[dim] = NAN;
+			}
+		}
+	}
+
+	return 0;
+}
+
 static int interp_hold(const NDTable_h table, const double *t, const int *subs, int *nsubs, int dim, NDTable_InterpMethod_t interp_method, NDTable_ExtrapMethod_t extrap_method, double *value, double der_values[]) {
 	nsubs[dim] = subs[dim]; // always take the left sample value
 	der_values[dim] = 0;
@@ -214,8 +680,9 @@ static int interp_nearest(const NDTable_h table, const double *t, const int *sub
 }
 
 static int interp_linear(const NDTable_h table, const double *t, const int *subs, int *nsubs, int dim, NDTable_InterpMethod_t interp_method, NDTable_ExtrapMethod_t extrap_method, double *value, double der_values[]) {
-	int err;
+	int err, i;
 	double a, b;
+	double der_b[MAX_NDIMS]; // the partial derivatives of the right value w.r.t. the lower dimensions
 
 	// get the left value
 	nsubs[dim] = subs[dim];
@@ -225,20 +692,27 @@ static int interp_linear(const NDTable_h table, const double *t, const int *subs
 
 	// get the right value
 	nsubs[dim] = subs[dim] + 1;
-	if ((err = NDTable_evaluate_internal(table, t, subs, nsubs, dim + 1, interp_method, extrap_method, &b, der_values)) != 0) {
+	if ((err = NDTable_evaluate_internal(table, t, subs, nsubs, dim + 1, interp_method, extrap_method, &b, der_b)) != 0) {
 		return err;
 	}
 
 	// if any of the values is not finite return NAN
 	if (!ISFINITE(a) || !ISFINITE(b)) {
 		*value = NAN;
-		der_values[dim] = NAN;
+		for (i = dim; i < table->ndims; i++) {
+			der_values[i] = NAN;
+		}
 		return 0;
 	}
 
 	// calculate the interpolated value
 	*value = (1 - t[dim]) * a + t[dim] * b;
 
+	// interpolate the partial derivatives w.r.t. the lower dimensions
+	for (i = dim + 1; i < table->ndims; i++) {
+		der_values[i] = (1 - t[dim]) * der_values[i] + t[dim] * der_b[i];
+	}
+
 	// calculate the derivative
 	der_values[dim] = (b - a) / (table->scales[dim][subs[dim] + 1] - table->scales[dim][subs[dim]]);
 
@@ -268,42 +742,36 @@ static void cubic_hermite_spline(const double x0, const double x1, const double
 	}
 }
 
-static int interp_akima(const NDTable_h table, const double *t, const int *subs, int *nsubs, int dim, NDTable_InterpMethod_t interp_method, NDTable_ExtrapMethod_t extrap_method, double *value, double der_values[]) {
-	
-	double x[6] = { 0, 0, 0, 0, 0, 0};
-	double y[6] = { 0, 0, 0, 0, 0, 0};
-	double c[4] = { 0, 0, 0, 0 };	   // spline coefficients
-    double d[5] = { 0, 0, 0, 0, 0 };   // divided differences 
-    double c2   = 0;
-	double dx   = 0;
-	double a    = 0;
-	double v    = 0;
+/* Evaluate the spline in the last dimension using the precomputed coefficients */
+static int interp_precomputed(const NDTable_h table, const double *t, const int *subs, const int *nsubs, int dim, double *value, double der_values[]) {
 
-	int n = table->dims[dim]; // extent of the current dimension
-	int sub = subs[dim];      // subscript of current dimension
-	int err, i, idx;
+	const int n = table->dims[dim]; // extent of the current dimension
+	const int sub = subs[dim];      // subscript of current dimension
+	const double *x = table->scales[dim];
+	const double *c;
+	size_t index = 0;
+	int i;
 
-	for (i = 0; i < 6; i++) {
-		idx = sub - 2 + i;
+	// index of the first value of the current line
+	for (i = 0; i < dim; i++) {
+		index += nsubs[i] * table->offs[i];
+	}
 
-		if (idx >= 0 && idx < n) {
-			x[i] = table->scales[dim][idx];
+	c = &table->coeffs[4 * ((index / n) * (n - 1) + sub)];
 
-			nsubs[dim] = idx;
-			if ((err = NDTable_evaluate_internal(table, t, subs, nsubs, dim + 1, interp_method, extrap_method, &y[i], der_values)) != 0) {
-				return err;
-			}
-		}
-	}
+	cubic_hermite_spline(x[sub], x[sub + 1], NDTABLE_VALUE(table, index + sub), NDTABLE_VALUE(table, index + sub + 1), t[dim], c, value, &der_values[dim]);
 
-	// if any of the values is not finite return NAN
-	for (i = 0; i < 6; i++) {
-		if (!ISFINITE(y[i])) {
-			*value = NAN;
-			der_values[dim] = NAN;
-			return 0;
-		}
-	}
+	return 0;
+}
+
+/* Calculate the coefficients of the Akima spline for the interval [x[2];x[3]] of a dimension with extent n */
+static void akima_coefficients(const double x[6], const double y[6], int n, int sub, double c[4]) {
+
+    double d[5] = { 0, 0, 0, 0, 0 };   // divided differences 
+    double c2   = 0;
+	double dx   = 0;
+	double a    = 0;
+	int i;
 
 	// calculate the divided differences
 	for (i = MAX(0, 2 - sub); i < MIN(5, 1 + n - sub); i++) {
@@ -353,48 +821,138 @@ static int interp_akima(const NDTable_h table, const double *t, const int *subs,
 	c[0] = (c[2] + c2 - 2 * d[2]) / (dx * dx);
     
 	c[3] = y[2];
+}
 
-	cubic_hermite_spline(x[2], x[3], y[2], y[3], t[dim], c, value, &der_values[dim]);
+/* Calculate the derivative of the Akima slope at the interval boundary between d[1] and d[2] w.r.t. the divided differences */
+static double akima_slope_derivative(const double d[4], const double dd[4]) {
 
-	return 0;
+	const double p = fabs(d[1] - d[0]);
+	const double q = fabs(d[3] - d[2]);
+	double dp, dq, a;
+
+	if (p + q > 0) {
+		dp = ((d[1] > d[0]) - (d[1] < d[0])) * (dd[1] - dd[0]);
+		dq = ((d[3] > d[2]) - (d[3] < d[2])) * (dd[3] - dd[2]);
+		a = p / (p + q);
+		return (1 - a) * dd[1] + a * dd[2] + (dp * q - p * dq) / ((p + q) * (p + q)) * (d[2] - d[1]);
+	}
+
+	return 0.5 * dd[1] + 0.5 * dd[2];
 }
 
-static int interp_fritsch_butland(const NDTable_h table, const double *t, const int *subs, int *nsubs, int dim, NDTable_InterpMethod_t interp_method, NDTable_ExtrapMethod_t extrap_method, double *value, double der_values[]) {
+/* Calculate the derivatives of the Akima coefficients w.r.t. the change dy of the sample values */
+static void akima_coefficients_derivative(const double x[6], const double y[6], const double dy[6], int n, int sub, double dc[4]) {
+
+	double d [5] = { 0, 0, 0, 0, 0 };   // divided differences 
+	double dd[5] = { 0, 0, 0, 0, 0 };   // derivatives of the divided differences 
+	double dc2, dx;
+	int i;
+
+	for (i = MAX(0, 2 - sub); i < MIN(5, 1 + n - sub); i++) {
+		d [i] = (y [i + 1] - y [i]) / (x[i + 1] - x[i]);
+		dd[i] = (dy[i + 1] - dy[i]) / (x[i + 1] - x[i]);
+	}
+
+	// pad left
+	if (sub < 2) {
+		if (sub < 1) {
+			d [1] = 2.0 * d [2] - d [3];
+			dd[1] = 2.0 * dd[2] - dd[3];
+		}
+		d [0] = 2.0 * d [1] - d [2];
+		dd[0] = 2.0 * dd[1] - dd[2];
+	}
+
+	// pad right
+	if (sub > n - 4) {
+		if (sub > n - 3) {
+			d [3] = 2.0 * d [2] - d [1];
+			dd[3] = 2.0 * dd[2] - dd[1];
+		}
+		d [4] = 2.0 * d [3] - d [2];
+		dd[4] = 2.0 * dd[3] - dd[2];
+	}
+
+	dx = x[3] - x[2];
+
+	dc[2] = akima_slope_derivative(&d[0], &dd[0]);
+	dc2   = akima_slope_derivative(&d[1], &dd[1]);
+
+	dc[1] = (3 * dd[2] - 2 * dc[2] - dc2) / dx;
+	dc[0] = (dc[2] + dc2 - 2 * dd[2]) / (dx * dx);
+	dc[3] = dy[2];
+}
+
+static int interp_akima(const NDTable_h table, const double *t, const int *subs, int *nsubs, int dim, NDTable_InterpMethod_t interp_method, NDTable_ExtrapMethod_t extrap_method, double *value, double der_values[]) {
 	
-	double x [4] = { 0, 0, 0, 0 };
-	double y [4] = { 0, 0, 0, 0 };
-	double dx[3] = { 0, 0, 0 };
-	double d [3] = { 0, 0, 0 };    // divided differences 
-    double c [4] = { 0, 0, 0, 0 }; // spline coefficients
-    double c2    = 0;
-	double v     = 0;
+	double x[6] = { 0, 0, 0, 0, 0, 0};
+	double y[6] = { 0, 0, 0, 0, 0, 0};
+	double c[4] = { 0, 0, 0, 0 };	   // spline coefficients
 
 	int n = table->dims[dim]; // extent of the current dimension
 	int sub = subs[dim];      // subscript of current dimension
-	int err, i, idx;
+	int err, i, j, idx;
+	double der_y[6][MAX_NDIMS]; // the partial derivatives of the sample values w.r.t. the lower dimensions
+	double dy[6];               // the change of the sample values
+	double dc[4];               // the change of the spline coefficients
+	double d2v;                 // the mixed second derivative (not used)
+
+	if (dim == table->ndims - 1 && table->coeffs && table->coeffs_method == interp_method) {
+		return interp_precomputed(table, t, subs, nsubs, dim, value, der_values);
+	}
 
-	for (i = 0; i < 4; i++) {
-		idx = sub - 1 + i;
+	for (i = 0; i < 6; i++) {
+		idx = sub - 2 + i;
 
 		if (idx >= 0 && idx < n) {
 			x[i] = table->scales[dim][idx];
 
 			nsubs[dim] = idx;
-			if ((err = NDTable_evaluate_internal(table, t, subs, nsubs, dim + 1, interp_method, extrap_method, &y[i], der_values)) != 0) {
+			if ((err = NDTable_evaluate_internal(table, t, subs, nsubs, dim + 1, interp_method, extrap_method, &y[i], der_y[i])) != 0) {
 				return err;
 			}
 		}
 	}
 
 	// if any of the values is not finite return NAN
-	for (i = 0; i < 4; i++) {
+	for (i = 0; i < 6; i++) {
 		if (!ISFINITE(y[i])) {
 			*value = NAN;
-			der_values[dim] = NAN;
+			for (j = dim; j < table->ndims; j++) {
+				der_values[j] = NAN;
+			}
 			return 0;
 		}
 	}
 
+	akima_coefficients(x, y, n, sub, c);
+
+	cubic_hermite_spline(x[2], x[3], y[2], y[3], t[dim], c, value, &der_values[dim]);
+
+	// propagate the partial derivatives w.r.t. the lower dimensions through the spline
+	for (j = dim + 1; j < table->ndims; j++) {
+
+		for (i = 0; i < 6; i++) {
+			idx = sub - 2 + i;
+			dy[i] = idx >= 0 && idx < n ? der_y[i][j] : 0;
+		}
+
+		akima_coefficients_derivative(x, y, dy, n, sub, dc);
+
+		cubic_hermite_spline(x[2], x[3], dy[2], dy[3], t[dim], dc, &der_values[j], &d2v);
+	}
+
+	return 0;
+}
+
+/* Calculate the coefficients of the Fritsch-Butland spline for the interval [x[1];x[2]] of a dimension with extent n */
+static void fritsch_butland_coefficients(const double x[4], const double y[4], int n, int sub, double c[4]) {
+
+	double dx[3] = { 0, 0, 0 };
+	double d [3] = { 0, 0, 0 };    // divided differences 
+    double c2    = 0;
+	int i;
+
 	// calculate the divided differences
 	//for (i = MAX(0, 1 - sub); i < MIN(3, n - 1 - sub); i++) {
 	for (i = 0; i < 3; i++) {
@@ -428,25 +986,73 @@ static int interp_fritsch_butland(const NDTable_h table, const double *t, const
     c[0] = (c[2] + c2 - 2 * d[1]) / (dx[1] * dx[1]);
 
     c[3] = y[1];
+}
 
-	cubic_hermite_spline(x[1], x[2], y[1], y[2], t[dim], c, value, &der_values[dim]);
+/* Calculate the derivative of the Fritsch-Butland slope between the intervals dx[0] and dx[1] w.r.t. the divided differences */
+static double fritsch_butland_slope_derivative(const double dx[2], const double d[2], const double dd[2]) {
 
-	return 0;
+	const double a = dx[0] + 2 * dx[1];
+	const double b = dx[1] + 2 * dx[0];
+	const double s = a / d[0] + b / d[1];
+
+	return 3 * (dx[0] + dx[1]) * (a * dd[0] / (d[0] * d[0]) + b * dd[1] / (d[1] * d[1])) / (s * s);
 }
 
-static int interp_steffen(const NDTable_h table, const double *t, const int *subs, int *nsubs, int dim, NDTable_InterpMethod_t interp_method, NDTable_ExtrapMethod_t extrap_method, double *value, double der_values[]) {
+/* Calculate the derivatives of the Fritsch-Butland coefficients w.r.t. the change dy of the sample values */
+static void fritsch_butland_coefficients_derivative(const double x[4], const double y[4], const double dy[4], int n, int sub, double dc[4]) {
+
+	double dx[3] = { 0, 0, 0 };
+	double d [3] = { 0, 0, 0 };    // divided differences 
+	double dd[3] = { 0, 0, 0 };    // derivatives of the divided differences 
+	double dc2   = 0;
+	int i;
+
+	for (i = 0; i < 3; i++) {
+		dx[i] = x[i + 1] - x[i];
+		d [i] = (y [i + 1] - y [i]) / dx[i];
+		dd[i] = (dy[i + 1] - dy[i]) / dx[i];
+	}
+
+	if (sub == 0) {
+		dc2 = dd[1];
+	} else if (d[0] == 0 || d[1] == 0 || (d[0] < 0 && d[1] > 0) || (d[0] > 0 && d[1] < 0)) {
+		dc2 = 0;
+	} else {
+		dc2 = fritsch_butland_slope_derivative(&dx[0], &d[0], &dd[0]);
+	}
+
+	dc[2] = dc2;
+
+	if (sub == n - 2) {
+		dc2 = dd[1];
+	} else if (d[1] == 0 || d[2] == 0 || (d[1] < 0 && d[2] > 0) || (d[1] > 0 && d[2] < 0)) {
+		dc2 = 0;
+	} else {
+		dc2 = fritsch_butland_slope_derivative(&dx[1], &d[1], &dd[1]);
+	}
+
+	dc[1] = (3 * dd[1] - 2 * dc[2] - dc2) / dx[1];
+	dc[0] = (dc[2] + dc2 - 2 * dd[1]) / (dx[1] * dx[1]);
+	dc[3] = dy[1];
+}
+
+static int interp_fritsch_butland(const NDTable_h table, const double *t, const int *subs, int *nsubs, int dim, NDTable_InterpMethod_t interp_method, NDTable_ExtrapMethod_t extrap_method, double *value, double der_values[]) {
 	
 	double x [4] = { 0, 0, 0, 0 };
 	double y [4] = { 0, 0, 0, 0 };
-	double dx[3] = { 0, 0, 0 };
-	double d [3] = { 0, 0, 0 };    // divided differences 
     double c [4] = { 0, 0, 0, 0 }; // spline coefficients
-    double c2    = 0;
-	double v     = 0;
 
-	const int n   = table->dims[dim]; // extent of the current dimension
-	const int sub = subs[dim];      // subscript of current dimension
-	int err, i, idx;
+	int n = table->dims[dim]; // extent of the current dimension
+	int sub = subs[dim];      // subscript of current dimension
+	int err, i, j, idx;
+	double der_y[4][MAX_NDIMS]; // the partial derivatives of the sample values w.r.t. the lower dimensions
+	double dy[4];               // the change of the sample values
+	double dc[4];               // the change of the spline coefficients
+	double d2v;                 // the mixed second derivative (not used)
+
+	if (dim == table->ndims - 1 && table->coeffs && table->coeffs_method == interp_method) {
+		return interp_precomputed(table, t, subs, nsubs, dim, value, der_values);
+	}
 
 	for (i = 0; i < 4; i++) {
 		idx = sub - 1 + i;
@@ -455,7 +1061,7 @@ static int interp_steffen(const NDTable_h table, const double *t, const int *sub
 			x[i] = table->scales[dim][idx];
 
 			nsubs[dim] = idx;
-			if ((err = NDTable_evaluate_internal(table, t, subs, nsubs, dim + 1, interp_method, extrap_method, &y[i], der_values)) != 0) {
+			if ((err = NDTable_evaluate_internal(table, t, subs, nsubs, dim + 1, interp_method, extrap_method, &y[i], der_y[i])) != 0) {
 				return err;
 			}
 		}
@@ -465,11 +1071,41 @@ static int interp_steffen(const NDTable_h table, const double *t, const int *sub
 	for (i = 0; i < 4; i++) {
 		if (!ISFINITE(y[i])) {
 			*value = NAN;
-			der_values[dim] = NAN;
+			for (j = dim; j < table->ndims; j++) {
+				der_values[j] = NAN;
+			}
 			return 0;
 		}
 	}
 
+	fritsch_butland_coefficients(x, y, n, sub, c);
+
+	cubic_hermite_spline(x[1], x[2], y[1], y[2], t[dim], c, value, &der_values[dim]);
+
+	// propagate the partial derivatives w.r.t. the lower dimensions through the spline
+	for (j = dim + 1; j < table->ndims; j++) {
+
+		for (i = 0; i < 4; i++) {
+			idx = sub - 1 + i;
+			dy[i] = idx >= 0 && idx < n ? der_y[i][j] : 0;
+		}
+
+		fritsch_butland_coefficients_derivative(x, y, dy, n, sub, dc);
+
+		cubic_hermite_spline(x[1], x[2], dy[1], dy[2], t[dim], dc, &der_values[j], &d2v);
+	}
+
+	return 0;
+}
+
+/* Calculate the coefficients of the Steffen spline for the interval [x[1];x[2]] of a dimension with extent n */
+static void steffen_coefficients(const double x[4], const double y[4], int n, int sub, double c[4]) {
+
+	double dx[3] = { 0, 0, 0 };
+	double d [3] = { 0, 0, 0 };    // divided differences 
+    double c2    = 0;
+	int i;
+
 	// calculate the divided differences
 	for (i = 0; i < 3; i++) {
 		dx[i] = x[i + 1] - x[i];
@@ -514,9 +1150,118 @@ static int interp_steffen(const NDTable_h table, const double *t, const int *sub
     c[1] = (3 * d[1] - 2 * c[2] - c2) / dx[1];
     c[0] = (c[2] + c2 - 2 * d[1]) / (dx[1] * dx[1]);
     c[3] = y[1];
+}
+
+/* Calculate the derivative of the Steffen slope between the intervals dx[0] and dx[1] w.r.t. the divided differences */
+static double steffen_slope_derivative(const double dx[2], const double d[2], const double dd[2]) {
+
+	const double c2 = (d[0] * dx[1] + d[1] * dx[0]) / (dx[0] + dx[1]);
+
+	// the slope is limited to twice the smaller divided difference (which has the same sign)
+	if (0.5 * fabs(c2) > fabs(d[0]) || 0.5 * fabs(c2) > fabs(d[1])) {
+		return 2 * (fabs(d[0]) < fabs(d[1]) ? dd[0] : dd[1]);
+	}
+
+	return (dd[0] * dx[1] + dd[1] * dx[0]) / (dx[0] + dx[1]);
+}
+
+/* Calculate the derivatives of the Steffen coefficients w.r.t. the change dy of the sample values */
+static void steffen_coefficients_derivative(const double x[4], const double y[4], const double dy[4], int n, int sub, double dc[4]) {
+
+	double dx[3] = { 0, 0, 0 };
+	double d [3] = { 0, 0, 0 };    // divided differences 
+	double dd[3] = { 0, 0, 0 };    // derivatives of the divided differences 
+	double dc2   = 0;
+	int i;
+
+	for (i = 0; i < 3; i++) {
+		dx[i] = x[i + 1] - x[i];
+		d [i] = (y [i + 1] - y [i]) / dx[i];
+		dd[i] = (dy[i + 1] - dy[i]) / dx[i];
+	}
+
+	if (sub == 0) {
+		dc2 = dd[1];
+	} else if (d[0] == 0 || d[1] == 0 || (d[0] < 0 && d[1] > 0) || (d[0] > 0 && d[1] < 0)) {
+		dc2 = 0;
+	} else {
+		dc2 = steffen_slope_derivative(&dx[0], &d[0], &dd[0]);
+	}
+
+	dc[2] = dc2;
+
+	if (sub == n - 2) {
+		dc2 = dd[1];
+	} else if (d[1] == 0 || d[2] == 0 || (d[1] < 0 && d[2] > 0) || (d[1] > 0 && d[2] < 0)) {
+		dc2 = 0;
+	} else {
+		dc2 = steffen_slope_derivative(&dx[1], &d[1], &dd[1]);
+	}
+
+	dc[1] = (3 * dd[1] - 2 * dc[2] - dc2) / dx[1];
+	dc[0] = (dc[2] + dc2 - 2 * dd[1]) / (dx[1] * dx[1]);
+	dc[3] = dy[1];
+}
+
+static int interp_steffen(const NDTable_h table, const double *t, const int *subs, int *nsubs, int dim, NDTable_InterpMethod_t interp_method, NDTable_ExtrapMethod_t extrap_method, double *value, double der_values[]) {
+	
+	double x [4] = { 0, 0, 0, 0 };
+	double y [4] = { 0, 0, 0, 0 };
+    double c [4] = { 0, 0, 0, 0 }; // spline coefficients
+
+	const int n   = table->dims[dim]; // extent of the current dimension
+	const int sub = subs[dim];      // subscript of current dimension
+	int err, i, j, idx;
+	double der_y[4][MAX_NDIMS]; // the partial derivatives of the sample values w.r.t. the lower dimensions
+	double dy[4];               // the change of the sample values
+	double dc[4];               // the change of the spline coefficients
+	double d2v;                 // the mixed second derivative (not used)
+
+	if (dim == table->ndims - 1 && table->coeffs && table->coeffs_method == interp_method) {
+		return interp_precomputed(table, t, subs, nsubs, dim, value, der_values);
+	}
+
+	for (i = 0; i < 4; i++) {
+		idx = sub - 1 + i;
+
+		if (idx >= 0 && idx < n) {
+			x[i] = table->scales[dim][idx];
+
+			nsubs[dim] = idx;
+			if ((err = NDTable_evaluate_internal(table, t, subs, nsubs, dim + 1, interp_method, extrap_method, &y[i], der_y[i])) != 0) {
+				return err;
+			}
+		}
+	}
+
+	// if any of the values is not finite return NAN
+	for (i = 0; i < 4; i++) {
+		if (!ISFINITE(y[i])) {
+			*value = NAN;
+			for (j = dim; j < table->ndims; j++) {
+				der_values[j] = NAN;
+			}
+			return 0;
+		}
+	}
+
+	steffen_coefficients(x, y, n, sub, c);
 
 	cubic_hermite_spline(x[1], x[2], y[1], y[2], t[dim], c, value, &der_values[dim]);
 
+	// propagate the partial derivatives w.r.t. the lower dimensions through the spline
+	for (j = dim + 1; j < table->ndims; j++) {
+
+		for (i = 0; i < 4; i++) {
+			idx = sub - 1 + i;
+			dy[i] = idx >= 0 && idx < n ? der_y[i][j] : 0;
+		}
+
+		steffen_coefficients_derivative(x, y, dy, n, sub, dc);
+
+		cubic_hermite_spline(x[1], x[2], dy[1], dy[2], t[dim], dc, &der_values[j], &d2v);
+	}
+
 	return 0;
 }
 
@@ -539,8 +1284,9 @@ static int extrap_hold(const NDTable_h table, const double *t, const int *subs,
 }
 
 static int extrap_linear(const NDTable_h table, const double *t, const int *subs, int *nsubs, int dim, NDTable_InterpMethod_t interp_method, NDTable_ExtrapMethod_t extrap_method, double *value, double der_values[]) {
-	int err;
+	int err, i;
 	double a, b;
+	double der_b[MAX_NDIMS]; // the partial derivatives of the right value w.r.t. the lower dimensions
 
 	nsubs[dim] = subs[dim];
 	if ((err = NDTable_evaluate_internal(table, t, subs, nsubs, dim + 1, interp_method, extrap_method, &a, der_values)) != 0) {
@@ -548,22 +1294,118 @@ static int extrap_linear(const NDTable_h table, const double *t, const int *subs
 	}
 
 	nsubs[dim] = subs[dim] + 1;
-	if ((err = NDTable_evaluate_internal(table, t, subs, nsubs, dim + 1, interp_method, extrap_method, &b, der_values)) != 0) {
+	if ((err = NDTable_evaluate_internal(table, t, subs, nsubs, dim + 1, interp_method, extrap_method, &b, der_b)) != 0) {
 		return err;
 	}
 
 	// if any of the values is not finite return NAN
 	if (!ISFINITE(a) || !ISFINITE(b)) {
 		*value = NAN;
-		der_values[dim] = NAN;
+		for (i = dim; i < table->ndims; i++) {
+			der_values[i] = NAN;
+		}
 		return 0;
 	}
 
 	// calculate the extrapolated value
 	*value = (1 - t[dim]) * a + t[dim] * b;
 
+	// interpolate the partial derivatives w.r.t. the lower dimensions
+	for (i = dim + 1; i < table->ndims; i++) {
+		der_values[i] = (1 - t[dim]) * der_values[i] + t[dim] * der_b[i];
+	}
+
 	// calculate the derivative
 	der_values[dim] = (b - a) / (table->scales[dim][subs[dim] + 1] - table->scales[dim][subs[dim]]);
 
 	return 0;
 }
+
+int NDTable_precompute_coefficients(NDTable_h table, NDTable_InterpMethod_t interp_method) {
+
+	double x[6], y[6];
+	double *coeffs = NULL;
+	size_t offset, nlines, line;
+	int dim, n, sub, first, width, i, idx;
+
+	free(table->coeffs);
+	table->coeffs = NULL;
+
+	// the coefficients are only precomputed for single-output tables
+	if (table->nvalues > 1) {
+		return 0;
+	}
+
+	switch (interp_method) {
+	case NDTABLE_INTERP_AKIMA:           first = -2; width = 6; break;
+	case NDTABLE_INTERP_FRITSCH_BUTLAND: first = -1; width = 4; break;
+	case NDTABLE_INTERP_STEFFEN:         first = -1; width = 4; break;
+	default: return 0; // nothing to precompute
+	}
+
+	if (table->ndims < 1) {
+		return 0;
+	}
+
+	dim = table->ndims - 1;
+	n = table->dims[dim];
+
+	// interp_hold() is used for dimensions with only one sample
+	if (n < 2) {
+		return 0;
+	}
+
+	nlines = table->numel / n;
+
+	// four coefficients per interval
+	if (nlines > SIZE_MAX / sizeof(double) / 4 / (size_t)(n - 1)) {
+		NDTable_set_error_message("The spline coefficients must fit into the address space");
+		return -1;
+	}
+
+	if (!(coeffs = (double *)malloc(nlines * (n - 1) * 4 * sizeof(double)))) {
+		NDTable_set_error_message("Failed to allocate memory for the spline coefficients");
+		return -1;
+	}
+
+	for (line = 0; line < nlines; line++) {
+
+		offset = line * n;
+
+		for (sub = 0; sub < n - 1; sub++) {
+
+			double *c = &coeffs[4 * (line * (n - 1) + sub)];
+			int finite = 1;
+
+			for (i = 0; i < width; i++) {
+				idx = sub + first + i;
+
+				if (idx >= 0 && idx < n) {
+					x[i] = table->scales[dim][idx];
+					y[i] = NDTABLE_VALUE(table, offset + idx);
+					finite = finite && ISFINITE(y[i]);
+				} else {
+					x[i] = 0;
+					y[i] = 0;
+				}
+			}
+
+			// propagate non-finite values as NAN
+			if (!finite) {
+				c[0] = c[1] = c[2] = c[3] = NAN;
+				continue;
+			}
+
+			switch (interp_method) {
+			case NDTABLE_INTERP_AKIMA:           akima_coefficients          (x, y, n, sub, c); break;
+			case NDTABLE_INTERP_FRITSCH_BUTLAND: fritsch_butland_coefficients(x, y, n, sub, c); break;
+			default:                             steffen_coefficients        (x, y, n, sub, c); break;
+			}
+		}
+	}
+
+	table->coeffs = coeffs;
+	table->coeffs_method = interp_method;
+
+	return 0;
+}
@@ -10,15 +10,15 @@
 #define NDTABLE_INTERPSTATUS_OK 0
 #include "Interpolation.c"
 
-NDTable_h ModelicaNDTable_open(const int ndims, const double *data, const int size) {
+/* Check the layout of the table data (as returned by readTableData()) and get the dimensions, scales and values */
+static int parse_table_data(const int ndims, const double *data, const int size, int dims[], const double *scales[], const double **values) {
 
-	int rank, i, numel, dims[32];
-	const double *scales[32];
-	NDTable_h table = NULL;
+	int rank, i;
+	size_t numel;
 
 	if (size < 2) {
 		ModelicaError("The number of elements in data must be >= 2");
-		return NULL;
+		return -1;
 	}
 
 	rank = (int)*data++;
@@ -26,18 +26,18 @@ NDTable_h ModelicaNDTable_open(const int ndims, const double *data, const int si
 	// check the rank
 	if (rank < 0 || rank > 32) {
 		ModelicaError("The first element in data must be in the range [0;32]");
-		return NULL;
+		return -1;
 	}
 
 	if (rank != ndims) {
 		ModelicaFormatError("The first element in data must match the number of inputs. Expected %d but was %d.", ndims, rank);
-		return NULL;
+		return -1;
 	}
 
 	// check the size
 	if (size < 1 + rank) {
 		ModelicaError("Data has not enough elements for the given number of dimensions");
-		return NULL;
+		return -1;
 	}
 
 	// check the dimensions
@@ -46,15 +46,18 @@ NDTable_h ModelicaNDTable_open(const int ndims, const double *data, const int si
 
 		if (dims[i] < 1) {
 			ModelicaError("The size of the dimensions must be >= 1");
-			return NULL;
+			return -1;
 		}
 	}
 
-	// check the number of elements
+	// check the number of elements (without overflow)
 	numel = 1;
 	
 	for (i = 0; i < rank; i++) {
-		numel *= dims[i]; // data
+		if (numel > (size_t)size) {
+			break;
+		}
+		numel *= (size_t)dims[i]; // data
 	}
 
 	for (i = 0; i < rank; i++) {
@@ -64,9 +67,9 @@ NDTable_h ModelicaNDTable_open(const int ndims, const double *data, const int si
 	numel += rank; // dims
 	numel++; // ndims
 
-	if (size != numel) {
-		ModelicaFormatError("Data has the wrong number of elements for the given dimensions. Expected %d but was %d.", numel, size);
-		return NULL;
+	if ((size_t)size != numel) {
+		ModelicaFormatError("Data has the wrong number of elements for the given dimensions. Expected %llu but was %d.", (unsigned long long)numel, size);
+		return -1;
 	}
 
 	for (i = 0; i < rank; i++) {
@@ -74,22 +77,54 @@ NDTable_h ModelicaNDTable_open(const int ndims, const double *data, const int si
 		data += dims[i];
 	}
 
-	table = NDTable_create_table(ndims, dims, data, scales);
+	*values = data;
+
+	return 0;
+}
+
+NDTable_h ModelicaNDTable_open_ex(const int ndims, const double *data, const int size, NDTable_InterpMethod_t interp_method, int precompute, int single) {
+
+	int dims[32];
+	const double *scales[32];
+	const double *values;
+	NDTable_h table = NULL;
+
+	if (parse_table_data(ndims, data, size, dims, scales, &values)) {
+		return NULL;
+	}
+
+	if (single) {
+		table = NDTable_create_table_float(ndims, dims, values, scales);
+	} else {
+		table = NDTable_create_table(ndims, dims, values, scales);
+	}
 
 	if (!table) {
 		ModelicaError(NDTable_get_error_message());
+		return NULL;
+	}
+
+	if (precompute && NDTable_precompute_coefficients(table, interp_method)) {
+		NDTable_free_table(table);
+		ModelicaError(NDTable_get_error_message());
+		return NULL;
 	}
 
 	return table;
 }
 
-
 void ModelicaNDTable_close(NDTable_h externalTable) {
 
 	NDTable_free_table(externalTable);
 
 }
 
+NDTable_h ModelicaNDTable_open(const int ndims, const double *data, const int size) {
+
+	return ModelicaNDTable_open_ex(ndims, data, size, NDTABLE_INTERP_LINEAR, 0, 0);
+
+}
+
 double ModelicaNDTable_evaluate(
 	NDTable_h table,
 	int nparams, 
@@ -123,4 +158,74 @@ double ModelicaNDTable_evaluate_derivative(
 	return value;
 }
 
+/* Returns 1 if the dimensions and scales of two tables are equal and 0 otherwise */
+static int same_scales(const int ndims, const int dims_a[], const double *scales_a[], const int dims_b[], const double *scales_b[]) {
+
+	int i;
+
+	for (i = 0; i < ndims; i++) {
+		if (dims_a[i] != dims_b[i] || memcmp(scales_a[i], scales_b[i], dims_a[i] * sizeof(double)) != 0) {
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+NDTable_h ModelicaNDTable_open_multi(const int ndims, const int nvalues, const double *data, const int size) {
+
+	int k, dims[32], dims_k[32];
+	const double *scales[32], *scales_k[32];
+	const double *values[32];
+	NDTable_h table = NULL;
+
+	if (nvalues < 1 || nvalues > 32) {
+		ModelicaFormatError("The number of outputs must be in the range [1;32] but was %d", nvalues);
+		return NULL;
+	}
+
+	// one row of data per output
+	for (k = 0; k < nvalues; k++) {
+
+		if (parse_table_data(ndims, data + (size_t)k * size, size, dims_k, scales_k, &values[k])) {
+			return NULL;
+		}
+
+		if (k == 0) {
+			memcpy(dims, dims_k, sizeof(dims));
+			memcpy(scales, scales_k, sizeof(scales));
+		} else if (!same_scales(ndims, dims, scales, dims_k, scales_k)) {
+			ModelicaFormatError("The scales in row %d of data do not match the ones in the first row", k + 1);
+			return NULL;
+		}
+	}
+
+	table = NDTable_create_table_multi(ndims, dims, nvalues, values, scales);
+
+	if (!table) {
+		ModelicaError(NDTable_get_error_message());
+	}
+
+	return table;
+}
+
+void ModelicaNDTable_evaluate_multi(
+	NDTable_h table,
+	int nparams, 
+	const double params[], 
+	NDTable_InterpMethod_t interp_method,
+	NDTable_ExtrapMethod_t extrap_method,
+	double values[],
+	int nvalues) {
+
+	if (nvalues != table->nvalues) {
+		ModelicaFormatError("The table has %d outputs but %d values were requested", table->nvalues, nvalues);
+		return;
+	}
+
+	if (NDTable_evaluate_multi(table, nparams, params, interp_method, extrap_method, values)) {
+		ModelicaError(NDTable_get_error_message());
+	}
+}
+
 #endif // MODELICA_NDTABLE_C
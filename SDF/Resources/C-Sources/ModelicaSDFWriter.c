@@ -0,0 +1,61 @@
+#ifndef MODELICA_SDF_WRITER_C
+#define MODELICA_SDF_WRITER_C
+
+#include <string.h>
+
+#include "ModelicaUtilities.h"
+
+/* the buffered writer of the ModelicaSDF library (see ModelicaSDFFunctions.h) */
+typedef struct ModelicaSDF_Writer ModelicaSDF_Writer;
+
+const char * ModelicaSDF_open_writer(const char *filename, const char *scale_name, const char *scale_unit, const int ndatasets, const char **dataset_names, const char **dataset_units, int capacity, double flush_interval, ModelicaSDF_Writer **writer);
+const char * ModelicaSDF_write_row(ModelicaSDF_Writer *writer, const double *row, int ncols);
+const char * ModelicaSDF_flush_writer(ModelicaSDF_Writer *writer);
+const char * ModelicaSDF_close_writer(ModelicaSDF_Writer *writer);
+
+void * ModelicaSDFWriter_open(const char *filename, const char *scale_name, const char *scale_unit, const int ndatasets, const char **dataset_names, const char **dataset_units, int capacity, double flush_interval) {
+
+	ModelicaSDF_Writer *writer = NULL;
+
+	const char *msg = ModelicaSDF_open_writer(filename, scale_name, scale_unit, ndatasets, dataset_names, dataset_units, capacity, flush_interval, &writer);
+
+	if (strlen(msg) > 0) {
+		ModelicaError(msg);
+		return NULL;
+	}
+
+	return writer;
+}
+
+void ModelicaSDFWriter_write_row(void *externalWriter, const double *row, int ncols) {
+
+	const char *msg = ModelicaSDF_write_row((ModelicaSDF_Writer *)externalWriter, row, ncols);
+
+	if (strlen(msg) > 0) {
+		ModelicaError(msg);
+	}
+
+}
+
+void ModelicaSDFWriter_flush(void *externalWriter) {
+
+	const char *msg = ModelicaSDF_flush_writer((ModelicaSDF_Writer *)externalWriter);
+
+	if (strlen(msg) > 0) {
+		ModelicaError(msg);
+	}
+
+}
+
+void ModelicaSDFWriter_close(void *externalWriter) {
+
+	const char *msg = ModelicaSDF_close_writer((ModelicaSDF_Writer *)externalWriter);
+
+	// don't raise an error in the destructor
+	if (strlen(msg) > 0) {
+		ModelicaMessage(msg);
+	}
+
+}
+
+#endif // MODELICA_SDF_WRITER_C
@@ -0,0 +1,152 @@
+#ifndef MODELICA_SHARED_NDTABLE_C
+#define MODELICA_SHARED_NDTABLE_C
+
+/* NDTables that are read from SDF files (requires the ModelicaSDF library) */
+
+#include "ModelicaNDTable.c"
+
+/* the shared table cache of the ModelicaSDF library (see ModelicaSDFFunctions.h) */
+const char * ModelicaSDF_acquire_table_data(const char *filename, const char *dataset_name, const int ndims, const char *unit, const char **scale_units, const double **data, int *size);
+const char * ModelicaSDF_acquire_table(const char *filename, const char *dataset_name, const int ndims, const char *unit, const char **scale_units, int *single, const double **data, long long *size, const void **values);
+void ModelicaSDF_release_table_data(const double *data);
+
+void ModelicaNDTable_close_shared(NDTable_h externalTable) {
+
+	if (externalTable && externalTable->owner) {
+		ModelicaSDF_release_table_data((const double *)externalTable->owner);
+	}
+
+	NDTable_free_table(externalTable);
+
+}
+
+NDTable_h ModelicaNDTable_open_shared(const int ndims, NDTable_InterpMethod_t interp_method, int precompute, int single,
+	const char *filename, const char *dataset_name, const char *unit, const char **scale_units) {
+
+	int i, dims[32];
+	const double *scales[32];
+	const double *shared = NULL;
+	const void *values = NULL;
+	const double *p;
+	long long shared_size = 0;
+	const char *msg;
+	NDTable_h table = NULL;
+
+	// large tables are mapped from the file (single is set if the dataset is stored in single precision)
+	msg = ModelicaSDF_acquire_table(filename, dataset_name, ndims, unit, scale_units, &single, &shared, &shared_size, &values);
+
+	if (strlen(msg) > 0) {
+		ModelicaError(msg);
+		return NULL;
+	}
+
+	// the layout has been validated by ModelicaSDF_read_table_data()
+	p = shared + 1;
+
+	for (i = 0; i < ndims; i++) {
+		dims[i] = (int)*p++;
+	}
+
+	for (i = 0; i < ndims; i++) {
+		scales[i] = p;
+		p += dims[i];
+	}
+
+	if (single) {
+		table = NDTable_create_table_borrowed_float(ndims, dims, (const float *)values, scales);
+	} else {
+		table = NDTable_create_table_borrowed(ndims, dims, (const double *)values, scales);
+	}
+
+	if (!table) {
+		ModelicaSDF_release_table_data(shared);
+		ModelicaError(NDTable_get_error_message());
+		return NULL;
+	}
+
+	table->owner = shared;
+
+	if (precompute && NDTable_precompute_coefficients(table, interp_method)) {
+		ModelicaNDTable_close_shared(table);
+		ModelicaError(NDTable_get_error_message());
+		return NULL;
+	}
+
+	return table;
+}
+
+NDTable_h ModelicaNDTable_open_multi_shared(const int ndims, const int nvalues, const char *filename, const char **dataset_names, const char **units, const char **scale_units) {
+
+	int i, k, nacquired = 0, dims[32], dims_k[32];
+	const double *scales[32], *scales_k[32];
+	const double *values[32];
+	const double *shared[32];
+	const double *p;
+	int shared_size = 0;
+	const char *msg = "";
+	NDTable_h table = NULL;
+
+	if (nvalues < 1 || nvalues > 32) {
+		ModelicaFormatError("The number of outputs must be in the range [1;32] but was %d", nvalues);
+		return NULL;
+	}
+
+	// read the datasets through the shared table cache (as doubles)
+	for (k = 0; k < nvalues; k++) {
+
+		msg = ModelicaSDF_acquire_table_data(filename, dataset_names[k], ndims, units[k], scale_units, &shared[k], &shared_size);
+
+		if (strlen(msg) > 0) {
+			goto out;
+		}
+
+		nacquired++;
+
+		// the layout has been validated by ModelicaSDF_read_table_data()
+		p = shared[k] + 1;
+
+		for (i = 0; i < ndims; i++) {
+			dims_k[i] = (int)*p++;
+		}
+
+		for (i = 0; i < ndims; i++) {
+			scales_k[i] = p;
+			p += dims_k[i];
+		}
+
+		values[k] = p;
+
+		if (k == 0) {
+			memcpy(dims, dims_k, sizeof(dims));
+			memcpy(scales, scales_k, sizeof(scales));
+		} else if (!same_scales(ndims, dims, scales, dims_k, scales_k)) {
+			break;
+		}
+	}
+
+	// interleave the values
+	if (k == nvalues) {
+		table = NDTable_create_table_multi(ndims, dims, nvalues, values, scales);
+		msg = table ? "" : NDTable_get_error_message();
+	}
+
+out:
+	// the values have been copied
+	for (i = 0; i < nacquired; i++) {
+		ModelicaSDF_release_table_data(shared[i]);
+	}
+
+	if (strlen(msg) > 0) {
+		ModelicaError(msg);
+		return NULL;
+	}
+
+	if (!table) {
+		ModelicaFormatError("The scales of '%s' and '%s' in '%s' do not match", dataset_names[0], dataset_names[k], filename);
+		return NULL;
+	}
+
+	return table;
+}
+
+#endif // MODELICA_SHARED_NDTABLE_C
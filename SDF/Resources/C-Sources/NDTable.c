@@ -4,6 +4,7 @@
 #include <string.h>
 #include <float.h>
 #include <stdio.h>
+#include <stdint.h>
 
 #include "NDTable.h"
 
@@ -13,7 +14,18 @@
 #define ISFINITE(x) isfinite(x)
 #endif
 
-static char error_message[MAX_MESSAGE_LENGTH] = "";
+// the error message is kept per thread, so tables can be used by concurrent simulations
+#if defined(_MSC_VER)
+#define THREAD_LOCAL __declspec(thread)
+#elif defined(__GNUC__)
+#define THREAD_LOCAL __thread
+#elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+#define THREAD_LOCAL _Thread_local
+#else
+#define THREAD_LOCAL
+#endif
+
+static THREAD_LOCAL char error_message[MAX_MESSAGE_LENGTH] = "";
 
 
 /* A string comparison that returns 1 if a is NULL, empty ("") or equal b and 0 otherwise */
@@ -30,12 +42,18 @@ static int streq(const char *a, const char *b) {
 void NDTable_set_error_message(const char *msg, ...) {
 	va_list vargs;
 	va_start(vargs, msg);
-	vsprintf(error_message, msg, vargs);
+	vsnprintf(error_message, MAX_MESSAGE_LENGTH, msg, vargs);
 	va_end(vargs);
 }
 
 NDTable_h NDTable_alloc_table() {
-	return (NDTable_h )calloc(1, sizeof(NDTable_t));
+	NDTable_h table = (NDTable_h )calloc(1, sizeof(NDTable_t));
+
+	if(table) {
+		table->nvalues = 1;
+	}
+
+	return table;
 }
 
 void NDTable_free_table(NDTable_h table) {
@@ -43,10 +61,17 @@ void NDTable_free_table(NDTable_h table) {
 
 	if(!table) return;
 	
-	free(table->data);
-	
-	for(i = 0; i < MAX_NDIMS; i++) {
-		free(table->scales[i]);
+	free(table->coeffs);
+
+	if(table->arena) {
+		free(table->arena);
+	} else if(!table->borrowed) {
+		free(table->data);
+		free(table->data_float);
+
+		for(i = 0; i < MAX_NDIMS; i++) {
+			free(table->scales[i]);
+		}
 	}
 
 	free(table);
@@ -56,7 +81,7 @@ const char * NDTable_get_error_message() {
 	return error_message;
 }
 
-void NDTable_calculate_offsets(int ndims, const int dims[], int *offs) {
+void NDTable_calculate_offsets(int ndims, const int dims[], size_t *offs) {
 	int i;
 
 	if(ndims < 1) {
@@ -66,12 +91,13 @@ void NDTable_calculate_offsets(int ndims, const int dims[], int *offs) {
 	offs[ndims-1] = 1;
 
 	for(i = ndims-2; i >= 0; i--) {
-		offs[i] = offs[i+1] * dims[i+1];  
+		offs[i] = offs[i+1] * (size_t)dims[i+1];  
 	}
 }
 
 int NDTable_validate_table(NDTable_h table) {
-	int i, j, numel, offs[MAX_NDIMS];
+	int i, j;
+	size_t index, numel, offs[MAX_NDIMS];
 	double v;
 
 	// check the rank
@@ -89,12 +115,9 @@ int NDTable_validate_table(NDTable_h table) {
 	}
 
 	// check the number of values
-	numel = 1;
-	for(i = 0; i < table->ndims; i++) {
-		numel = numel * table->dims[i];
-	}
+	numel = NDTable_calculate_numel(table->ndims, table->dims);
 
-	if(table->numel != numel) {
+	if(numel == 0 || table->numel != numel) {
 		NDTable_set_error_message("The size of '%s' in '%s' does not match its extent", "table->datasetname", "table->filename");
 		return -1;
 	}
@@ -103,7 +126,7 @@ int NDTable_validate_table(NDTable_h table) {
 	NDTable_calculate_offsets(table->ndims, table->dims, offs);
 	for(i = 0; i < table->ndims; i++) {
 		if(table->offs[i] != offs[i]) {
-			NDTable_set_error_message("The offset[%d] of '%s' in '%s' must be %d but was %d", i, "table->datasetname", "table->filename", offs[i], table->offs[i]);
+			NDTable_set_error_message("The offset[%d] of '%s' in '%s' must be %llu but was %llu", i, "table->datasetname", "table->filename", (unsigned long long)offs[i], (unsigned long long)table->offs[i]);
 			return -1;
 		}
 	}
@@ -128,15 +151,15 @@ int NDTable_validate_table(NDTable_h table) {
 		}
 		
 		if(table->offs[i] != offs[i]) {
-			NDTable_set_error_message("The offset[%d] of '%s' in '%s' must be %d but was %d", i, "table->datasetname", "table->filename", offs[i], table->offs[i]);
+			NDTable_set_error_message("The offset[%d] of '%s' in '%s' must be %llu but was %llu", i, "table->datasetname", "table->filename", (unsigned long long)offs[i], (unsigned long long)table->offs[i]);
 			return -1;
 		}
 	}
 
 	// check the data for non-finite values
-	for(i = 0; i < table->numel; i++) {
-		if(!ISFINITE(table->data[i])) {
-			NDTable_set_error_message("The data value at index %d of '%s' in '%s' is not finite", i, "table->datasetname", "table->filename");
+	for(index = 0; index < table->numel; index++) {
+		if(!ISFINITE(NDTABLE_VALUE(table, index))) {
+			NDTable_set_error_message("The data value at index %llu of '%s' in '%s' is not finite", (unsigned long long)index, "table->datasetname", "table->filename");
 			return -1;
 		}
 	}
@@ -144,57 +167,114 @@ int NDTable_validate_table(NDTable_h table) {
 	return 0;
 }
 
-int NDTable_calculate_numel(int ndims, const int dims[]) {
-	int i, numel = 1;
+size_t NDTable_calculate_numel(int ndims, const int dims[]) {
+	int i;
+	size_t numel = 1;
 
 	for(i = 0; i < ndims; i++) {
-		numel = numel * dims[i];
+
+		if(dims[i] < 1) {
+			return 0;
+		}
+
+		// the number of elements (and their size in bytes) must not overflow
+		if(numel > SIZE_MAX / sizeof(double) / (size_t)dims[i]) {
+			return 0;
+		}
+
+		numel = numel * (size_t)dims[i];
 	}
 
 	return numel;
 }
 
-void NDTable_ind2sub(const int index, const NDTable_h table, int *subs) {
-	int i, n = index; // number of remaining elements
+void NDTable_ind2sub(const size_t index, const NDTable_h table, int *subs) {
+	int i;
+	size_t n = index; // number of remaining elements
 
 	for(i = 0; i < table->ndims; i++) {
-		subs[i] = n / table->offs[i];
+		subs[i] = (int)(n / table->offs[i]);
 		n -= subs[i] * table->offs[i];
 	}
 }
 
-void NDTable_sub2ind(const int *subs, const NDTable_h table, int *index) {
-	int i, k = 1;
+void NDTable_sub2ind(const int *subs, const NDTable_h table, size_t *index) {
+	int i;
 
 	(*index) = 0;
 
-	for(i = table->ndims-1; i >= 0; i--) {
-		(*index) += subs[i] * k; 
-		k *= table->dims[i]; // TODO use pre-calculated offsets
+	for(i = 0; i < table->ndims; i++) {
+		(*index) += subs[i] * table->offs[i];
 	}
 }
 
 double NDTable_get_value_subs(const NDTable_h table, const int subs[]) {
-	int index;
+	size_t index;
 	NDTable_sub2ind(subs, table, &index);
-	return table->data[index];
+	return NDTABLE_VALUE(table, index * table->nvalues);
 }
 
-NDTable_h NDTable_create_table(int ndims, const int *dims, const double *data, const double **scales) {
+void NDTable_detect_uniform_scales(NDTable_h table) {
+	int i, j, n;
+	double step;
+	const double *scale;
+
+	for(i = 0; i < table->ndims; i++) {
+
+		n = table->dims[i];
+		scale = table->scales[i];
+
+		table->step[i] = 0;
+
+		if(n < 2) {
+			continue;
+		}
+
+		step = (scale[n - 1] - scale[0]) / (n - 1);
+
+		for(j = 1; j < n - 1; j++) {
+			if(fabs(scale[j] - (scale[0] + j * step)) > NDTABLE_UNIFORM_TOLERANCE * step) {
+				break;
+			}
+		}
+
+		if(j == n - 1) {
+			table->step[i] = step;
+			table->min[i] = scale[0];
+			table->max[i] = scale[n - 1];
+		}
+	}
+}
+
+/* Checks the scales and initializes a new table with the dimensions but without data and scales */
+static NDTable_h init_table(int ndims, const int *dims, const double **scales) {
 	int i, j;
 	NDTable_h table = NULL;
 
+	if(ndims < 0 || ndims > MAX_NDIMS) {
+		NDTable_set_error_message("The number of dimensions must be in the range [0;%d] but was %d", MAX_NDIMS, ndims);
+		return NULL;
+	}
+
+	if(NDTable_calculate_numel(ndims, dims) == 0) {
+		NDTable_set_error_message("The extents of the dimensions must be >= 1 and the number of elements must fit into the address space");
+		return NULL;
+	}
+
 	// check scales for strict monotonicity
 	for(i = 0; i < ndims; i++) {
 		for(j = 0; j < dims[i] - 1; j++) {
 			if (scales[i][j] >= scales[i][j + 1]) {
 				NDTable_set_error_message("The scale for dimension %d is not strictly monotonic at index %d", i + 1, j + 1);
-				goto out;
+				return NULL;
 			}
 		}
 	}
 
-	table = NDTable_alloc_table();
+	if(!(table = NDTable_alloc_table())) {
+		NDTable_set_error_message("Failed to allocate the table");
+		return NULL;
+	}
 
 	table->ndims = ndims;
 	
@@ -202,15 +282,207 @@ NDTable_h NDTable_create_table(int ndims, const int *dims, const double *data, c
 
 	NDTable_calculate_offsets(ndims, dims, table->offs);
 
-	table->data = (double *)malloc(table->numel * sizeof(double));
+	for(i = 0; i < ndims; i++) {
+		table->dims[i] = dims[i];
+	}
+
+	return table;
+}
+
+/* The number of doubles that fill whole blocks of NDTABLE_ALIGNMENT bytes */
+static size_t aligned_length(size_t n) {
+	const size_t block = NDTABLE_ALIGNMENT / sizeof(double);
+	return (n + block - 1) / block * block;
+}
+
+NDTable_h NDTable_create_table(int ndims, const int *dims, const double *data, const double **scales) {
+	int i;
+	size_t length;
+	double *p;
+	NDTable_h table = NULL;
+
+	if(!(table = init_table(ndims, dims, scales))) {
+		goto out;
+	}
+
+	// one block for the data and all scales
+	length = aligned_length(table->numel);
+
+	for(i = 0; i < ndims; i++) {
+		length += aligned_length(dims[i]);
+	}
+
+	if(!(table->arena = malloc(length * sizeof(double) + NDTABLE_ALIGNMENT))) {
+		NDTable_set_error_message("Failed to allocate %llu bytes for the table", (unsigned long long)(length * sizeof(double)));
+		NDTable_free_table(table);
+		table = NULL;
+		goto out;
+	}
+
+	p = (double *)(((uintptr_t)table->arena + NDTABLE_ALIGNMENT - 1) & ~(uintptr_t)(NDTABLE_ALIGNMENT - 1));
+
+	table->data = p;
 	memcpy(table->data, data, table->numel * sizeof(double));
+	p += aligned_length(table->numel);
 
 	for(i = 0; i < ndims; i++) {
-		table->dims[i] = dims[i];
-		table->scales[i] = (double *)malloc(dims[i] * sizeof(double));
+		table->scales[i] = p;
 		memcpy(table->scales[i], scales[i], dims[i] * sizeof(double));
+		p += aligned_length(dims[i]);
 	}
 
+	NDTable_detect_uniform_scales(table);
+
+out:
+	return table;
+}
+
+NDTable_h NDTable_create_table_borrowed(int ndims, const int *dims, const double *data, const double **scales) {
+	int i;
+	NDTable_h table = NULL;
+
+	if(!(table = init_table(ndims, dims, scales))) {
+		goto out;
+	}
+
+	table->borrowed = 1;
+	table->data = (double *)data;
+
+	for(i = 0; i < ndims; i++) {
+		table->scales[i] = (double *)scales[i];
+	}
+
+	NDTable_detect_uniform_scales(table);
+
+out:
+	return table;
+}
+
+NDTable_h NDTable_create_table_float(int ndims, const int *dims, const double *data, const double **scales) {
+	int i;
+	size_t length, index;
+	double *p;
+	NDTable_h table = NULL;
+
+	if(!(table = init_table(ndims, dims, scales))) {
+		goto out;
+	}
+
+	// one block for the data (two floats per double) and all scales
+	length = aligned_length((table->numel + 1) / 2);
+
+	for(i = 0; i < ndims; i++) {
+		length += aligned_length(dims[i]);
+	}
+
+	if(!(table->arena = malloc(length * sizeof(double) + NDTABLE_ALIGNMENT))) {
+		NDTable_set_error_message("Failed to allocate %llu bytes for the table", (unsigned long long)(length * sizeof(double)));
+		NDTable_free_table(table);
+		table = NULL;
+		goto out;
+	}
+
+	p = (double *)(((uintptr_t)table->arena + NDTABLE_ALIGNMENT - 1) & ~(uintptr_t)(NDTABLE_ALIGNMENT - 1));
+
+	table->data_float = (float *)p;
+
+	for(index = 0; index < table->numel; index++) {
+		table->data_float[index] = (float)data[index];
+	}
+
+	p += aligned_length((table->numel + 1) / 2);
+
+	for(i = 0; i < ndims; i++) {
+		table->scales[i] = p;
+		memcpy(table->scales[i], scales[i], dims[i] * sizeof(double));
+		p += aligned_length(dims[i]);
+	}
+
+	NDTable_detect_uniform_scales(table);
+
+out:
+	return table;
+}
+
+NDTable_h NDTable_create_table_borrowed_float(int ndims, const int *dims, const float *data, const double **scales) {
+	int i;
+	NDTable_h table = NULL;
+
+	if(!(table = init_table(ndims, dims, scales))) {
+		goto out;
+	}
+
+	table->borrowed = 1;
+	table->data_float = (float *)data;
+
+	for(i = 0; i < ndims; i++) {
+		table->scales[i] = (double *)scales[i];
+	}
+
+	NDTable_detect_uniform_scales(table);
+
+out:
+	return table;
+}
+
+NDTable_h NDTable_create_table_multi(int ndims, const int *dims, int nvalues, const double **data, const double **scales) {
+	int i, k;
+	size_t length, index;
+	double *p;
+	NDTable_h table = NULL;
+
+	if(nvalues < 1) {
+		NDTable_set_error_message("The number of values must be >= 1 but was %d", nvalues);
+		goto out;
+	}
+
+	if(!(table = init_table(ndims, dims, scales))) {
+		goto out;
+	}
+
+	table->nvalues = nvalues;
+
+	if(table->numel > SIZE_MAX / sizeof(double) / nvalues) {
+		NDTable_set_error_message("The number of values must fit into the address space");
+		NDTable_free_table(table);
+		table = NULL;
+		goto out;
+	}
+
+	// one block for the interleaved data and all scales
+	length = aligned_length(table->numel * nvalues);
+
+	for(i = 0; i < ndims; i++) {
+		length += aligned_length(dims[i]);
+	}
+
+	if(!(table->arena = malloc(length * sizeof(double) + NDTABLE_ALIGNMENT))) {
+		NDTable_set_error_message("Failed to allocate %llu bytes for the table", (unsigned long long)(length * sizeof(double)));
+		NDTable_free_table(table);
+		table = NULL;
+		goto out;
+	}
+
+	p = (double *)(((uintptr_t)table->arena + NDTABLE_ALIGNMENT - 1) & ~(uintptr_t)(NDTABLE_ALIGNMENT - 1));
+
+	table->data = p;
+
+	for(index = 0; index < table->numel; index++) {
+		for(k = 0; k < nvalues; k++) {
+			*p++ = data[k][index];
+		}
+	}
+
+	p = table->data + aligned_length(table->numel * nvalues);
+
+	for(i = 0; i < ndims; i++) {
+		table->scales[i] = p;
+		memcpy(table->scales[i], scales[i], dims[i] * sizeof(double));
+		p += aligned_length(dims[i]);
+	}
+
+	NDTable_detect_uniform_scales(table);
+
 out:
 	return table;
 }
@@ -1,6 +1,8 @@
 #ifndef NDTABLE_H_
 #define NDTABLE_H_
 
+#include <stddef.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -25,18 +27,37 @@ typedef enum {
 	NDTABLE_EXTRAP_NONE
 } NDTable_ExtrapMethod_t;
 
-/*! The structure that holds the data values */
+/*! The structure that holds the data values
+ *
+ * A table can be evaluated by several threads at once. The evaluation only writes the
+ * search hints in last[] which are accessed with relaxed atomic operations (any value is
+ * a valid hint, so a hint from another thread only costs a longer search).
+ */
 typedef struct {
 	int		ndims;			   //!< the number of dimensions of the table
 	int		dims[MAX_NDIMS];   //!< extents of the dimensions
-	int		numel;			   //!< the number of data values
-	int 	offs[MAX_NDIMS];   //!< the index offsets for the dimensions
-	double *data;			   //!< the data values
+	size_t	numel;			   //!< the number of sample points (may exceed INT_MAX)
+	int		nvalues;		   //!< the number of values per sample point (interleaved, 1 for single-output tables)
+	size_t	offs[MAX_NDIMS];   //!< the index offsets for the dimensions
+	double *data;			   //!< the data values (i.e. numel * nvalues values, NULL if they are stored in data_float)
+	float  *data_float;		   //!< the data values in single precision (NULL if they are stored in data)
 	double *scales[MAX_NDIMS]; //!< array of pointers to the scale values
+	double *coeffs;			   //!< precomputed spline coefficients for the last dimension (optional)
+	NDTable_InterpMethod_t coeffs_method; //!< the interpolation method of the precomputed coefficients
+	double	step[MAX_NDIMS];   //!< the spacing of uniform scales (0 if the scale is not uniform)
+	double	min[MAX_NDIMS];	   //!< the first value of uniform scales
+	double	max[MAX_NDIMS];	   //!< the last value of uniform scales
+	void   *arena;			   //!< the memory block that holds the data and the scales (NULL if they are allocated separately or borrowed)
+	int		borrowed;		   //!< 1 if the data and the scales are owned by the caller and not freed with the table
+	const void *owner;		   //!< identifies borrowed data for its owner (e.g. the shared table cache, optional)
+	int		last[MAX_NDIMS];   //!< the subscripts found by the last evaluation (where the next index search starts, see below)
 } NDTable_t;
 
 typedef NDTable_t * NDTable_h;
 
+/*! The data value at index of a table (stored in single or double precision) */
+#define NDTABLE_VALUE(table, index) ((table)->data_float ? (double)(table)->data_float[index] : (table)->data[index])
+
 /*! Interpolation status codes */
 typedef enum {
 	NDTABLE_INTERPSTATUS_UNKNOWN_METHOD  = -4,
@@ -47,7 +68,7 @@ typedef enum {
 } NDTable_InterpolationStatus;
 
 
-/*! Get the last error message
+/*! Get the last error message of the calling thread
  * 
  * @return		the error message
  */
@@ -80,10 +101,60 @@ int NDTable_evaluate(NDTable_h table, int nparams, const double params[], NDTabl
  */
 int NDTable_evaluate_derivative(NDTable_h table, int nparams, const double params[], const double delta_params[], NDTable_InterpMethod_t interp_method, NDTable_ExtrapMethod_t extrap_method, double *value);
 
+/*! Evaluate the value and all partial derivatives of the table at the given sample point using the specified inter- and extrapolation methods
+ *
+ * The partial derivatives are calculated in the same pass over the neighboring sample points as the
+ * value and the derivatives w.r.t. each dimension are interpolated along all other dimensions, so a
+ * Jacobian row costs one evaluation instead of one evaluation per dimension with NDTable_evaluate_derivative().
+ *
+ * @param [in]	table			the table handle
+ * @param [in]	nparams			the number of dimensions
+ * @param [in]	params			the sample point
+ * @param [in]	interp_method	the interpolation method
+ * @param [in]	extrap_method	the extrapolation method
+ * @param [out]	value			the value at the sample point
+ * @param [out]	derivatives		the partial derivatives w.r.t. each dimension at the sample point
+ *
+ * @return		0 if the value could be evaluated, -1 otherwise
+ */
+int NDTable_evaluate_gradient(NDTable_h table, int nparams, const double params[], NDTable_InterpMethod_t interp_method, NDTable_ExtrapMethod_t extrap_method, double *value, double derivatives[]);
+
+/*! Evaluate all values of a multi-output table at the given sample point using the specified inter- and extrapolation methods
+ *
+ * The index search and the traversal of the neighboring sample points are done once for all outputs.
+ * For single-output tables this is the same as NDTable_evaluate().
+ *
+ * @param [in]	table			the table handle
+ * @param [in]	nparams			the number of dimensions
+ * @param [in]	params			the sample point
+ * @param [in]	interp_method	the interpolation method
+ * @param [in]	extrap_method	the extrapolation method
+ * @param [out]	values			the table->nvalues values at the sample point
+ *
+ * @return		0 if the values could be evaluated, -1 otherwise
+ */
+int NDTable_evaluate_multi(NDTable_h table, int nparams, const double params[], NDTable_InterpMethod_t interp_method, NDTable_ExtrapMethod_t extrap_method, double values[]);
+
+/*! Evaluate the values of the table at many sample points using the specified inter- and extrapolation methods
+ *
+ * The points are processed in blocks and the index search starts at the interval of the previous
+ * point, so sweeps and other sorted sequences are evaluated much faster than with NDTable_evaluate().
+ *
+ * @param [in]	table			the table handle
+ * @param [in]	npoints			the number of sample points
+ * @param [in]	params			array of pointers to the coordinates of the sample points for each dimension (i.e. params[dim][point])
+ * @param [in]	interp_method	the interpolation method
+ * @param [in]	extrap_method	the extrapolation method
+ * @param [out]	values			the values at the sample points
+ *
+ * @return		0 if the values could be evaluated, -1 otherwise (e.g. for multi-output tables)
+ */
+int NDTable_evaluate_batch(NDTable_h table, int npoints, const double *params[], NDTable_InterpMethod_t interp_method, NDTable_ExtrapMethod_t extrap_method, double values[]);
+
 /*! The maximum length of an error message */	
 #define MAX_MESSAGE_LENGTH 256
 
-/*! Sets the error message */
+/*! Sets the error message of the calling thread (truncated to MAX_MESSAGE_LENGTH - 1 characters) */
 void NDTable_set_error_message(const char *msg, ...);
 
 /*! Allocates a new table
@@ -104,7 +175,7 @@ void NDTable_free_table(NDTable_h table);
  * @param [in]	table	the table for which to convert the index
  * @param [out]	subs	the subscripts
  */
-void NDTable_ind2sub(const int index, const NDTable_h table, int *subs);
+void NDTable_ind2sub(const size_t index, const NDTable_h table, int *subs);
 
 /*! Converts subscripts to index
  * 
@@ -112,16 +183,23 @@ void NDTable_ind2sub(const int index, const NDTable_h table, int *subs);
  *	@param [in]		table	the table for which to convert the subscripts
  *	@param [out]	index	the index
  */
-void NDTable_sub2ind(const int *subs, const NDTable_h table, int *index);
+void NDTable_sub2ind(const int *subs, const NDTable_h table, size_t *index);
 
 double NDTable_get_value_subs(const NDTable_h table, const int subs[]);
 
 /*! Helper function to the indices for the interpolation
+ *
+ *  The search starts at the interval given by index or, if the value is not in the same or an adjacent
+ *  interval, at an estimate that assumes uniform spacing. From there it hunts with increasing steps until
+ *  the value is bracketed and bisects the bracket, i.e. it takes O(1) for the same or an adjacent interval
+ *  and for uniform spacing and O(log(num_values)) otherwise.
  *
  *  @param [in]		value		the value to search for 
  *  @param [in]		num_values	the number of values 
  *  @param [in]		values		the values 
- *	@param [out]	index		the smallest index in [0;num_values-2] for which values[index] <= value
+ *	@param [in,out]	index		in: the index where to start the search (e.g. the result of the previous call)
+ *								out: the index in [0;num_values-2] for which values[index] <= value < values[index+1]
+ *									 (or value <= values[index+1] for the last interval)
  *	@param [out]	t			the weight for the linear interpolation s.t. value == (1-t)*values[index] + t*values[index+1] 
  * 
  *	@return 0
@@ -130,24 +208,120 @@ void NDTable_find_index(double value, int num_values, const double values[], int
 
 int NDTable_evaluate_internal(const NDTable_h table, const double *t, const int *subs, int *nsubs, int dim, NDTable_InterpMethod_t interp_method, NDTable_ExtrapMethod_t extrap_method, double *value, double *derivatives);
 
+/*! The alignment (in bytes) of the data and the scales in the memory block of a table */
+#define NDTABLE_ALIGNMENT 64
+
+/*! Create a table from a copy of the data and the scales
+ *
+ *  The data and the scales are copied into a single memory block (see NDTable_t.arena)
+ *  where every array starts at a multiple of NDTABLE_ALIGNMENT bytes.
+ *
+ *  @param [in]		ndims		the number of dimensions
+ *  @param [in]		dims		the extent of the dimensions
+ *  @param [in]		data		the data values
+ *  @param [in]		scales		array of pointers to the scale values
+ *
+ *	@return	the new table or NULL if the table could not be created
+ */
 NDTable_h NDTable_create_table(int ndims, const int *dims, const double *data, const double **scales);
 
+/*! Create a table that references the data and the scales without copying them
+ *
+ *  The caller must keep the data and the scales alive and unchanged until the table is freed.
+ *
+ *  @param [in]		ndims		the number of dimensions
+ *  @param [in]		dims		the extent of the dimensions
+ *  @param [in]		data		the data values
+ *  @param [in]		scales		array of pointers to the scale values
+ *
+ *	@return	the new table or NULL if the table could not be created
+ */
+NDTable_h NDTable_create_table_borrowed(int ndims, const int *dims, const double *data, const double **scales);
+
+/*! Create a table that stores a copy of the data in single precision
+ *
+ *  Works like NDTable_create_table() but halves the memory of the data (and the memory bandwidth
+ *  of the evaluation). The scales and all calculations remain in double precision, so only the
+ *  data values are rounded to about 7 significant digits.
+ *
+ *  @param [in]		ndims		the number of dimensions
+ *  @param [in]		dims		the extent of the dimensions
+ *  @param [in]		data		the data values
+ *  @param [in]		scales		array of pointers to the scale values
+ *
+ *	@return	the new table or NULL if the table could not be created
+ */
+NDTable_h NDTable_create_table_float(int ndims, const int *dims, const double *data, const double **scales);
+
+/*! Create a table that references single precision data and the scales without copying them
+ *
+ *  The caller must keep the data and the scales alive and unchanged until the table is freed.
+ *
+ *  @param [in]		ndims		the number of dimensions
+ *  @param [in]		dims		the extent of the dimensions
+ *  @param [in]		data		the data values in single precision
+ *  @param [in]		scales		array of pointers to the scale values
+ *
+ *	@return	the new table or NULL if the table could not be created
+ */
+NDTable_h NDTable_create_table_borrowed_float(int ndims, const int *dims, const float *data, const double **scales);
+
+/*! Create a multi-output table from copies of several datasets with the same scales
+ *
+ *  The values of all datasets are interleaved per sample point (i.e. data[index * nvalues + k]),
+ *  so the values of a sample point are read from the same cache line. The single-output functions
+ *  (e.g. NDTable_evaluate()) evaluate the first dataset.
+ *
+ *  @param [in]		ndims		the number of dimensions
+ *  @param [in]		dims		the extent of the dimensions
+ *  @param [in]		nvalues		the number of datasets
+ *  @param [in]		data		array of pointers to the values of the datasets
+ *  @param [in]		scales		array of pointers to the scale values
+ *
+ *	@return	the new table or NULL if the table could not be created
+ */
+NDTable_h NDTable_create_table_multi(int ndims, const int *dims, int nvalues, const double **data, const double **scales);
+
+/*! Precompute the spline coefficients of the last dimension for the given interpolation method
+ *
+ *  The coefficients of every interval of every line in the last dimension are stored in the table
+ *  so the evaluation of the spline becomes a lookup. Only Akima, Fritsch-Butland and Steffen splines
+ *  are precomputed, for all other methods and for multi-output tables this function does nothing.
+ *
+ *  @param [in]		table			the table handle
+ *  @param [in]		interp_method	the interpolation method
+ *
+ *	@return	0 on success, -1 otherwise
+ */
+int NDTable_precompute_coefficients(NDTable_h table, NDTable_InterpMethod_t interp_method);
+
+/*! The maximum deviation (relative to the spacing) of a scale value from an equidistant grid for uniform scales */
+#define NDTABLE_UNIFORM_TOLERANCE 1e-10
+
+/*! Detect uniform scales and store their spacing
+ *
+ *  For uniform scales the index search becomes a division (see NDTable_t.step).
+ *
+ *  @param [in]		table			the table handle
+ */
+void NDTable_detect_uniform_scales(NDTable_h table);
+
 /*! Calculate the number of offsets from the dimensions
  *
  *  @param [in]		ndims		the number of dimensions
  *  @param [in]		dims		the extent of the dimensions
  *	@param [out]	offs		array to write the offsets
  */
-void NDTable_calculate_offsets(int ndims, const int dims[], int offs[]);
+void NDTable_calculate_offsets(int ndims, const int dims[], size_t offs[]);
 
 /*! Calculate the number of elements from the dimensions
  *
  *  @param [in]		ndims		the number of dimensions
  *  @param [in]		dims		the extent of the dimensions
  * 
- *	@return	the number of elements
+ *	@return	the number of elements (0 if it exceeds SIZE_MAX)
  */
-int NDTable_calculate_numel(int ndims, const int dims[]);
+size_t NDTable_calculate_numel(int ndims, const int dims[]);
 
 #ifdef __cplusplus
 }